@@ -1,5 +1,9 @@
 #pragma once
 
+#include "Shaders/Compute/ParticleCollisions/BvhNodeLayout.comp"
+
+#include <cstddef>
+
 /*------------------------------------------------------------------------------------------------
 Description:   
     A convenience structure for BvhNode.  Must match the corresponding structure in 
@@ -28,39 +32,60 @@ Description:
     Stores info about a single node in the BVH.  Can be either an internal node or a leaf node.  
     If internal, then its children are either leaf nodes or other internal nodes.  If a leaf 
     node, then it will have _data to analyze.
+
+    An internal node has copies of its children's boxes, and whether each child is a leaf or
+    null is in the top bits of its index (see BvhNodeLayout.comp).  The parent indexes and
+    thread entrance counters that the builders use are in BvhNodeBuildData.
 Creator:    John Cox, 5/2017
 ------------------------------------------------------------------------------------------------*/
 struct BvhNode
 {
     BvhNode() :
-        _isLeaf(0),
-        _isNull(0),
-        _parentIndex(-1),
-        _threadEntranceCounter(0),
-        _leftChildIndex(-1),
-        _rightChildIndex(-1)
+        _leftChild(BVH_NO_CHILD),
+        _rightChild(BVH_NO_CHILD),
+        _padding1(0),
+        _padding2(0)
     {
     }
-    
-    BoundingBox _boundingBox;
 
-    // if 0, then it is an internal node
-    int _isLeaf;
-
-    // used during tree construction to prevent merging bounding boxes from inactive leaves (see 
-    // GuaranteeMortonCodeUniqueness.comp for explanation)
-    int _isNull;
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        These take apart _leftChild and _rightChild, same as BvhChildIndex(...) and the others
+        in BvhNodeBuffer.comp.
+    Parameters:
+        child   One of this node's children.
+    Returns:
+        Self-explanatory.
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    static int ChildIndex(unsigned int child)
+    {
+        return static_cast<int>(child & BVH_CHILD_INDEX_MASK);
+    }
 
-    // used for merging bounding boxes up to the root
-    int _parentIndex;
+    static bool ChildIsLeaf(unsigned int child)
+    {
+        return (child & BVH_CHILD_LEAF_BIT) != 0;
+    }
 
-    // used to prevent the first thread that reads this internal node from trying to merge the 
-    // bounding boxes of its child, one of which may not be finished yet
-    int _threadEntranceCounter;
+    static bool ChildIsNull(unsigned int child)
+    {
+        return (child & BVH_CHILD_NULL_BIT) != 0;
+    }
 
     // used when traversing down the tree during collision detection
-    int _leftChildIndex;
-    int _rightChildIndex;
+    // Note: Checking both children only takes these 4, so they come first.
+    BoundingBox _leftChildBoundingBox;
+    BoundingBox _rightChildBoundingBox;
+    unsigned int _leftChild;
+    unsigned int _rightChild;
+
+    // only the builders and the refit read this, to make the parent's copy of it
+    BoundingBox _boundingBox;
+
+    // rounds it out to 64 bytes so that a node never straddles 2 cache lines
+    unsigned int _padding1;
+    unsigned int _padding2;
 
     // Note: Lesson learned about buffer padding.  It is only necessary if the structure defines 
     // a vec* (yes, vec2 included; I tested it) or mat*.  The CPU side can declare whatever it 
@@ -72,3 +97,36 @@ struct BvhNode
     // no padding necessary.
 };
 
+// the std430 layout of the GLSL structure, which has no padding of its own to hide a mismatch
+static_assert(sizeof(BoundingBox) == 16, "BoundingBox must match BvhNodeBuffer.comp");
+static_assert(sizeof(BvhNode) == 64, "BvhNode must match BvhNodeBuffer.comp");
+static_assert(offsetof(BvhNode, _leftChildBoundingBox) == 0, "BvhNode must match BvhNodeBuffer.comp");
+static_assert(offsetof(BvhNode, _rightChildBoundingBox) == 16, "BvhNode must match BvhNodeBuffer.comp");
+static_assert(offsetof(BvhNode, _leftChild) == 32, "BvhNode must match BvhNodeBuffer.comp");
+static_assert(offsetof(BvhNode, _rightChild) == 36, "BvhNode must match BvhNodeBuffer.comp");
+static_assert(offsetof(BvhNode, _boundingBox) == 40, "BvhNode must match BvhNodeBuffer.comp");
+
+/*------------------------------------------------------------------------------------------------
+Description:   
+    Must match the corresponding structure in BvhNodeBuildDataBuffer.comp.
+    The parts of a node that are only used while building or refitting the BVH.  There is 1
+    for every BvhNode, at the same index.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+struct BvhNodeBuildData
+{
+    BvhNodeBuildData() :
+        _parentIndex(-1),
+        _threadEntranceCounter(0)
+    {
+    }
+
+    // used for merging bounding boxes up to the root
+    int _parentIndex;
+
+    // used to prevent the first thread that reads this internal node from trying to merge the 
+    // bounding boxes of its child, one of which may not be finished yet
+    int _threadEntranceCounter;
+};
+
+static_assert(sizeof(BvhNodeBuildData) == 8, "BvhNodeBuildData must match BvhNodeBuildDataBuffer.comp");
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Include/Buffers/BvhNode.h"
+
+/*------------------------------------------------------------------------------------------------
+Description:   
+    Must match the corresponding structure in BvhQuantizedNodeBuffer.comp.
+    A half-size copy of a BvhNode that collision detection can go through instead.  The node's 
+    box is a frame (a corner and a step size, 2 half floats each), and each of its children's 
+    boxes is 16-bit step counts across that frame, rounded outward.  _leftChild and _rightChild 
+    are the same as the BvhNode's (see BvhNodeLayout.comp).
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+struct BvhQuantizedNode
+{
+    BvhQuantizedNode() :
+        _frameOrigin(0),
+        _frameStep(0),
+        _leftChild(BVH_NO_CHILD),
+        _rightChild(BVH_NO_CHILD),
+        _leftChildLeftRight(0),
+        _leftChildBottomTop(0),
+        _rightChildLeftRight(0),
+        _rightChildBottomTop(0)
+    {
+    }
+
+    unsigned int _frameOrigin;
+    unsigned int _frameStep;
+    unsigned int _leftChild;
+    unsigned int _rightChild;
+    unsigned int _leftChildLeftRight;
+    unsigned int _leftChildBottomTop;
+    unsigned int _rightChildLeftRight;
+    unsigned int _rightChildBottomTop;
+
+    // Note: No padding.  There are no vec* or mat* in the GLSL structure (see BvhNode).
+};
+
+static_assert(sizeof(BvhQuantizedNode) == 32, "BvhQuantizedNode must match BvhQuantizedNodeBuffer.comp");
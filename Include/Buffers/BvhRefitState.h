@@ -0,0 +1,45 @@
+#pragma once
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Must match the front of BvhRefitBuffer.comp, everything but the partial sums.  Keeps track 
+    of whether the BVH can keep being refit or should be rebuilt (see BvhRefitLayout.comp).
+
+    Note: The GPU fills it out.  The CPU only reads it back when profiling.  
+    _bvhRebuildRequested is needed every frame, so the GPU copies it somewhere that the CPU 
+    can read without a stall (see BvhRefitSsbo::RebuildRequested()).  The CPU writes 
+    _bvhRebuildRequested when it needs a rebuild no matter what (see 
+    BvhRefitSsbo::RequestRebuild()).
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+struct BvhRefitState
+{
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Starts out with everything at 0 except the rebuild request, so the first frame always 
+        builds the tree.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    BvhRefitState() :
+        _numActiveParticlesNow(0),
+        _numTrackedParticles(0),
+        _numFramesSinceBvhRebuild(0),
+        _bvhRebuildRequested(1),
+        _numBvhRebuilds(0),
+        _numBvhRefits(0),
+        _bvhAreaAfterRebuild(0.0f),
+        _bvhArea(0.0f)
+    {
+    }
+
+    unsigned int _numActiveParticlesNow;
+    unsigned int _numTrackedParticles;
+    unsigned int _numFramesSinceBvhRebuild;
+    unsigned int _bvhRebuildRequested;
+    unsigned int _numBvhRebuilds;
+    unsigned int _numBvhRefits;
+    float _bvhAreaAfterRebuild;
+    float _bvhArea;
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Include/Buffers/BvhNode.h"
+
+/*------------------------------------------------------------------------------------------------
+Description:   
+    Must match the corresponding structure in BvhWideNodeBuffer.comp.
+    A node of the 4-wide BVH that collision detection can go through instead of the binary 
+    one.  It has its children's bounding boxes in it, so they can all be checked with one 
+    read.  The children are indexes into the BvhNodeSsbo (see BvhWideNodeBuffer.comp for how 
+    to tell the leaves apart).  Unused slots are -1.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+struct BvhWideNode
+{
+    BvhWideNode()
+    {
+        for (int slot = 0; slot < 4; slot++)
+        {
+            _childIndexes[slot] = -1;
+        }
+    }
+
+    BoundingBox _childBoundingBoxes[4];
+    int _childIndexes[4];
+
+    // Note: No padding.  There are no vec* or mat* in the GLSL structure (see BvhNode).
+};
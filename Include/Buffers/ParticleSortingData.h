@@ -34,4 +34,66 @@ struct ParticleSortingData
     int _preSortedParticleIndex;
 
     // no GLSL-native structures on the shader side, so no padding necessary
-};
\ No newline at end of file
+};
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    The sort keys can be 32 or 64 bits wide (see SortingKey32.comp and SortingKey64.comp).  
+    The width is picked when the shaders are assembled, and the ParticleSortingDataSsbo has to 
+    be made for the same width because the items are a different size.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+enum class SortingKeyWidth
+{
+    KEY_32_BIT,
+    KEY_64_BIT
+};
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    The same as ParticleSortingData, but with a 64-bit key.  GLSL 4.4 has no 64bit integer, so 
+    the key is split into two uints with the least significant half first.  That is what a 
+    uvec2 key with the low half in X looks like (see SortingKey64.comp).
+
+    Note: There is no uint64 in the struct because the GPU only needs 4-byte alignment for 
+    this.  An 8-byte-aligned member would pad the struct out to 16 bytes on the CPU side.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+struct ParticleSortingData64
+{
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Initializes members to 0.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    ParticleSortingData64() :
+        _sortingData(0),
+        _sortingDataHigh(0),
+        _preSortedParticleIndex(0)
+    {
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Puts the two halves of the key back together.
+    Parameters: None
+    Returns:    
+        The key as a 64bit unsigned integer.
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    unsigned long long Key() const
+    {
+        return (static_cast<unsigned long long>(_sortingDataHigh) << 32) | _sortingData;
+    }
+
+    // least significant 32 bits of the key
+    unsigned int _sortingData;
+
+    // most significant 32 bits of the key
+    unsigned int _sortingDataHigh;
+
+    // see ParticleSortingData
+    int _preSortedParticleIndex;
+};
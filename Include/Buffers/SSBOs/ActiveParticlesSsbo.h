@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Include/Buffers/SSBOs/SsboBase.h"
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Encapsulates the SSBO that holds the number of active particles and the indirect dispatch 
+    commands that are sized by it.  The GPU fills it out (see ActiveParticlesBuffer.comp), and 
+    the compute controller uses it as the GL_DISPATCH_INDIRECT_BUFFER for everything after the 
+    sorting data has been compacted.
+
+    The GpuKeyValueSorter also uses it for how many items to sort.  Callers that don't have the 
+    count on the GPU can fill it out from the CPU with SetNumActiveParticles(...).
+
+    Note: There are no size uniforms for this buffer.  Its size is fixed by the #defines in 
+    ActiveParticlesLayout.comp.
+
+    Also Note: One of the dispatch commands is for the BVH's leaves, and a leaf can hold more 
+    than one particle (see BvhLeaves.comp), so this needs to know how many.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+class ActiveParticlesSsbo : public SsboBase
+{
+public:
+    ActiveParticlesSsbo(unsigned int maxParticlesPerBvhLeaf);
+    virtual ~ActiveParticlesSsbo() = default;
+    using SharedPtr = std::shared_ptr<ActiveParticlesSsbo>;
+    using SharedConstPtr = std::shared_ptr<const ActiveParticlesSsbo>;
+
+    void SetNumActiveParticles(unsigned int numActiveParticles) const;
+    unsigned int DispatchCommandByteOffset(unsigned int dispatchSlot) const;
+    unsigned int NumActiveParticlesByteOffset() const;
+
+private:
+    unsigned int _maxParticlesPerBvhLeaf;
+};
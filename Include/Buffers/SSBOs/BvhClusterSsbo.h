@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Include/Buffers/SSBOs/SsboBase.h"
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Encapsulates the SSBO that the PLOC builder works in (see BvhClusterLayout.comp).  The GPU 
+    fills it out.  The compute controller uses it as the GL_DISPATCH_INDIRECT_BUFFER while the 
+    clusters are being merged, and it reads back the number of clusters to tell when they are 
+    done.
+
+    Note: There are no size uniforms for this buffer.  There is room for 1 cluster per leaf, 
+    and there are never more clusters than that.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+class BvhClusterSsbo : public SsboBase
+{
+public:
+    BvhClusterSsbo(unsigned int numParticles, unsigned int maxParticlesPerLeaf);
+    virtual ~BvhClusterSsbo() = default;
+    using SharedPtr = std::shared_ptr<BvhClusterSsbo>;
+    using SharedConstPtr = std::shared_ptr<const BvhClusterSsbo>;
+
+    void ClearClusters() const;
+    unsigned int DispatchCommandByteOffset(unsigned int dispatchSlot) const;
+    unsigned int NumClustersByteOffset() const;
+};
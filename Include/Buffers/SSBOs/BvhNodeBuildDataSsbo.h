@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Include/Buffers/SSBOs/SsboBase.h"
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Encapsulates the SSBO for the parts of the BVH's nodes that only the builders and the refit 
+    use (see BvhNodeBuildDataBuffer.comp).  There is 1 for every node in the BvhNodeSsbo.
+
+    Note: There are no size uniforms for this buffer.  It is the same size as the BvhNodeSsbo, 
+    so it uses that one's.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+class BvhNodeBuildDataSsbo : public SsboBase
+{
+public:
+    BvhNodeBuildDataSsbo(unsigned int numParticles, unsigned int maxParticlesPerLeaf);
+    virtual ~BvhNodeBuildDataSsbo() = default;
+    using SharedPtr = std::shared_ptr<BvhNodeBuildDataSsbo>;
+    using SharedConstPtr = std::shared_ptr<const BvhNodeBuildDataSsbo>;
+};
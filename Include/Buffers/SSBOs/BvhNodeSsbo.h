@@ -8,7 +8,7 @@ Description:
     Used during particle collision detection to generate the bounding volume hierarchy (BVH).
 
     Contains enough nodes for
-    - 1 leaf node for each particle (n leaves)
+    - 1 leaf node for every maxParticlesPerLeaf particles (n leaves; see BvhLeaves.comp)
     - the branches all the way to the root (n-1 internal nodes)
 
     Why have both leaves and internal nodes instead of just internal nodes and rely on the 
@@ -23,7 +23,7 @@ Creator:    John Cox, 3/2017
 class BvhNodeSsbo : public SsboBase
 {
 public:
-    BvhNodeSsbo(unsigned int numParticles);
+    BvhNodeSsbo(unsigned int numParticles, unsigned int maxParticlesPerLeaf);
     virtual ~BvhNodeSsbo() = default;
     using SharedPtr = std::shared_ptr<BvhNodeSsbo>;
     using SharedConstPtr = std::shared_ptr<const BvhNodeSsbo>;
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Include/Buffers/SSBOs/SsboBase.h"
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Encapsulates the SSBO for the quantized BVH nodes (see BvhQuantizedNodeBuffer.comp).  The 
+    GPU makes them out of the binary BVH in the BvhNodeSsbo after every build and refit (see 
+    QuantizeBvhNodes.comp).
+
+    Note: There are no size uniforms for this buffer.  There is a quantized node for every 
+    internal node of the binary tree, and they use the BvhNodeSsbo's uniforms to find them.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+class BvhQuantizedNodeSsbo : public SsboBase
+{
+public:
+    BvhQuantizedNodeSsbo(unsigned int numParticles, unsigned int maxParticlesPerLeaf);
+    virtual ~BvhQuantizedNodeSsbo() = default;
+    using SharedPtr = std::shared_ptr<BvhQuantizedNodeSsbo>;
+    using SharedConstPtr = std::shared_ptr<const BvhQuantizedNodeSsbo>;
+};
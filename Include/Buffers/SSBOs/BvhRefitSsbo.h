@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Include/Buffers/SSBOs/SsboBase.h"
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Encapsulates the SSBO that decides when the BVH is rebuilt instead of refit (see 
+    BvhRefitLayout.comp).  The GPU fills it out.  The compute controller reads the 
+    BvhRefitState at the front of it to decide what to do next frame.
+
+    Note: There are no size uniforms for this buffer.  The partial sums at the back are sized 
+    by the number of work groups that it takes to cover every particle, and 
+    MeasureBvhArea.comp never uses more than that.
+
+    Also Note: The rebuild decision is needed every frame, and glGetBufferSubData(...) on this 
+    buffer would make the driver wait on everything that has been queued, including this 
+    frame's particle update.  So the GPU copies the decision into a small persistently mapped 
+    buffer right after it is made (see QueueRebuildDecisionReadback()) and puts a fence after 
+    the copy.  By the time the CPU asks (see RebuildRequested()), the per-frame sync in 
+    main.cpp has already waited past that fence, so the read is just a pointer dereference.  
+    Same idea as PersistentAtomicCounterBuffer.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+class BvhRefitSsbo : public SsboBase
+{
+public:
+    BvhRefitSsbo(unsigned int numParticles);
+    virtual ~BvhRefitSsbo();
+    using SharedPtr = std::shared_ptr<BvhRefitSsbo>;
+    using SharedConstPtr = std::shared_ptr<const BvhRefitSsbo>;
+
+    void RequestRebuild() const;
+    void QueueRebuildDecisionReadback() const;
+    bool RebuildRequested() const;
+    unsigned int StateByteOffset() const;
+    unsigned int StateSizeBytes() const;
+
+private:
+    void WaitForRebuildDecisionReadback() const;
+
+    // the persistently mapped copy of BvhRefitState::_bvhRebuildRequested
+    unsigned int _rebuildDecisionBufferId;
+    unsigned int *_rebuildDecisionPtr;
+
+    // a GLsync; void * to keep OpenGL out of the header like the IDs above
+    mutable void *_rebuildDecisionFence;
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Include/Buffers/SSBOs/SsboBase.h"
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Encapsulates the SSBO for the 4-wide BVH (see BvhWideNodeBuffer.comp).  The GPU makes it 
+    out of the binary BVH in the BvhNodeSsbo after every build and refit (see 
+    CollapseBvhToWideNodes.comp).
+
+    Note: There are no size uniforms for this buffer.  There is a wide node for every 
+    internal node of the binary tree, and they use the BvhNodeSsbo's uniforms to find them.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+class BvhWideNodeSsbo : public SsboBase
+{
+public:
+    BvhWideNodeSsbo(unsigned int numParticles, unsigned int maxParticlesPerLeaf);
+    virtual ~BvhWideNodeSsbo() = default;
+    using SharedPtr = std::shared_ptr<BvhWideNodeSsbo>;
+    using SharedConstPtr = std::shared_ptr<const BvhWideNodeSsbo>;
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Include/Buffers/SSBOs/SsboBase.h"
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Encapsulates the SSBO that decides when the particles are moved into sorted order (see 
+    ParticleReorderLayout.comp).  The GPU fills it out, and the compute controller uses it as 
+    the GL_DISPATCH_INDIRECT_BUFFER for moving the particles.
+
+    Note: There are no size uniforms for this buffer.  Its size is fixed by the #defines in 
+    ParticleReorderLayout.comp.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+class ParticleReorderSsbo : public SsboBase
+{
+public:
+    ParticleReorderSsbo();
+    virtual ~ParticleReorderSsbo() = default;
+    using SharedPtr = std::shared_ptr<ParticleReorderSsbo>;
+    using SharedConstPtr = std::shared_ptr<const ParticleReorderSsbo>;
+
+    unsigned int DispatchCommandByteOffset() const;
+    unsigned int CountersByteOffset() const;
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Include/Buffers/SSBOs/SsboBase.h"
+#include "Include/Buffers/ParticleSortingData.h"
 
 /*------------------------------------------------------------------------------------------------
 Description:
@@ -9,19 +10,25 @@ Description:
     in GPU-land, so have to use a second buffer), so this buffer needs to be big enough to 
     contain a read/write pair of ParticleSortingData objects.  Thus it must contain 2x the number 
     of particles.
+
+    The items are ParticleSortingData or ParticleSortingData64 depending on the key width (see 
+    SortingKeyWidth in ParticleSortingData.h).
 Creator:    John Cox, 5/2017
 ------------------------------------------------------------------------------------------------*/
 class ParticleSortingDataSsbo: public SsboBase
 {
 public:
-    ParticleSortingDataSsbo(unsigned int numParticles);
+    ParticleSortingDataSsbo(unsigned int numParticles, SortingKeyWidth keyWidth);
     virtual ~ParticleSortingDataSsbo() = default;
     using SharedPtr = std::shared_ptr<ParticleSortingDataSsbo>;
     using SharedConstPtr = std::shared_ptr<const ParticleSortingDataSsbo>;
 
     void ConfigureConstantUniforms(unsigned int computeProgramId) const override;
     unsigned int NumItems() const;
+    SortingKeyWidth KeyWidth() const;
+    unsigned int ItemSizeBytes() const;
 
 private:
     unsigned int _numItems;
+    SortingKeyWidth _keyWidth;
 };
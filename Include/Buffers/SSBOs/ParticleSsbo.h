@@ -9,10 +9,13 @@ Description:
     in a drawing shader as well as compute shader, this class will also set up the VAO and the 
     vertex attributes.
 
-    Allocates enough space for 2x the number of requested particles.  The second half is used 
-    during particle sorting.  There is no "swap" function in GPU programming, so the particles 
-    need to be copied from the first half to the second half, then copied back to their sorted 
-    position.
+    Allocates enough space for 2x the number of requested particles.  The particles live in one 
+    half (the "front"), and particle sorting gathers them into the other half (the "back") in 
+    sorted order.  Then the halves swap.  There is no "swap" function in GPU programming, but 
+    there doesn't need to be.  The front half is bound to PARTICLE_BUFFER_BINDING with 
+    glBindBufferRange(...), so every shader that uses ParticleBuffer.comp follows it without 
+    knowing that there are two halves.  Rendering follows it with the first vertex in 
+    glDrawArrays(...).
 Creator:    John Cox, 3/2017
 ------------------------------------------------------------------------------------------------*/
 class ParticleSsbo : public SsboBase
@@ -25,9 +28,15 @@ public:
 
     void ConfigureConstantUniforms(unsigned int computeProgramId) const override;
     unsigned int NumParticles() const;
+    void SwapHalves();
+    unsigned int FrontHalfByteOffset() const;
+    unsigned int FrontHalfFirstVertex() const;
 
 private:
     void ConfigureRender() override;
+    void BindHalves() const;
 
     unsigned int _numParticles;
+    unsigned int _numParticlesPerHalf;
+    unsigned int _frontHalfIndex;
 };
\ No newline at end of file
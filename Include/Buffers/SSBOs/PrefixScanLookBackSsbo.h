@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Include/Buffers/SSBOs/SsboBase.h"
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Encapsulates the SSBO that the prefix scan's work groups use to pass their sums to each 
+    other.  See PrefixScanLookBackBuffer.comp for details.
+
+    Note: There are no size uniforms for this buffer.  The shader gets the number of status 
+    flags from the length of the array.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+class PrefixScanLookBackSsbo : public SsboBase
+{
+public:
+    PrefixScanLookBackSsbo(unsigned int numDataEntries);
+    virtual ~PrefixScanLookBackSsbo() = default;
+    using SharedPtr = std::shared_ptr<PrefixScanLookBackSsbo>;
+    using SharedConstPtr = std::shared_ptr<const PrefixScanLookBackSsbo>;
+
+    unsigned int NumStatusFlagsPerSet() const;
+
+private:
+    unsigned int _numStatusFlagsPerSet;
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Include/Buffers/SSBOs/SsboBase.h"
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Encapsulates the SSBO that tells the radix sort which passes to run.  The GPU fills it out 
+    (see RadixSortPassPlanBuffer.comp), and the compute controller uses it as the 
+    GL_DISPATCH_INDIRECT_BUFFER for each pass's dispatches.  The incremental sort keeps its 
+    dispatch command and counters here too.
+
+    Note: There are no size uniforms for this buffer.  Its size is fixed by the #defines in 
+    RadixSortPassPlanLayout.comp.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+class RadixSortPassPlanSsbo : public SsboBase
+{
+public:
+    RadixSortPassPlanSsbo();
+    virtual ~RadixSortPassPlanSsbo() = default;
+    using SharedPtr = std::shared_ptr<RadixSortPassPlanSsbo>;
+    using SharedConstPtr = std::shared_ptr<const RadixSortPassPlanSsbo>;
+
+    unsigned int DispatchCommandByteOffset(unsigned int passNumber, unsigned int dispatchSlot) const;
+    unsigned int NumActivePassesByteOffset() const;
+    unsigned int IncrementalSortCountersByteOffset() const;
+    unsigned int IncrementalSortDispatchCommandByteOffset() const;
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Include/Buffers/SSBOs/SsboBase.h"
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Encapsulates the SSBO that holds the bounds that the Morton Codes are normalized against 
+    (see SceneBoundsLayout.comp).  The GPU fills it out every frame.  Nothing reads it back.
+
+    Note: There are no size uniforms for this buffer.  Its size is fixed by the #defines in 
+    SceneBoundsLayout.comp.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+class SceneBoundsSsbo : public SsboBase
+{
+public:
+    SceneBoundsSsbo();
+    virtual ~SceneBoundsSsbo() = default;
+    using SharedPtr = std::shared_ptr<SceneBoundsSsbo>;
+    using SharedConstPtr = std::shared_ptr<const SceneBoundsSsbo>;
+
+    void ResetToParticleRegion() const;
+};
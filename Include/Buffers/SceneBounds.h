@@ -0,0 +1,43 @@
+#pragma once
+
+#include "ThirdParty/glm/vec4.hpp"
+#include "Shaders/Compute/ParticleCollisions/SceneBoundsLayout.comp"
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Must match SceneBoundsBuffer.comp.  The bounds that the Morton Codes are normalized 
+    against (see SceneBoundsLayout.comp).
+
+    Note: The accumulators are ordered uints, not floats (see FloatToOrderedUint(...) in 
+    SceneBoundsBuffer.comp).  The CPU only ever resets them.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+struct SceneBounds
+{
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Starts out as the fixed particle region with the accumulators ready for the first 
+        ComputeSceneBounds.comp.  The glm structures have their own zero initialization, so 
+        the W values are 0.
+    Parameters: 
+        regionMin           Where each axis starts.
+        regionInverseRange  1 / the length of each axis.
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    SceneBounds(const glm::vec4 &regionMin, const glm::vec4 &regionInverseRange) :
+        _sceneMin(regionMin),
+        _sceneInverseRange(regionInverseRange)
+    {
+        for (unsigned int axis = 0; axis < SCENE_BOUNDS_NUM_AXES; axis++)
+        {
+            _sceneMinAccumulators[axis] = SCENE_BOUNDS_MIN_ACCUMULATOR_RESET;
+            _sceneMaxAccumulators[axis] = SCENE_BOUNDS_MAX_ACCUMULATOR_RESET;
+        }
+    }
+
+    glm::vec4 _sceneMin;
+    glm::vec4 _sceneInverseRange;
+    unsigned int _sceneMinAccumulators[SCENE_BOUNDS_NUM_AXES];
+    unsigned int _sceneMaxAccumulators[SCENE_BOUNDS_NUM_AXES];
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vector>
+#include "Include/Buffers/BvhNode.h"
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    CPU measurements of how good a BVH is, for comparing the different ways of building one 
+    (different sort keys, for example; see MortonCode.h).  The nodes are read back from the 
+    BvhNodeSsbo, so the layout is the same as there: the leaves first, then the internal nodes 
+    starting with the root.
+
+    - BvhSahCost(...): the surface area heuristic (SAH) cost of the tree.  The lower the cost, 
+      the fewer nodes a random query is expected to have to look at.
+    - CountBvhNodesVisited(...): how many internal nodes DetectCollisions.comp looks at when 
+      every particle looks for its overlaps.  The same traversal as the shader, just on the 
+      CPU, so it is an exact count and not an estimate (with 1 particle per leaf).
+    - CountBvhWideNodesVisited(...): the same, but for when DetectCollisions.comp goes through 
+      the 4-wide BVH instead (see BvhWideNodeBuffer.comp).
+    - CountInvalidBvhNodes(...): whether the tree is a tree at all.  Every builder has to get 
+      this right before the others mean anything.
+
+    Note: These are slow (a traversal per leaf) and only for profiling.
+
+    Also Note: A leaf can hold more than one particle (see BvhLeaves.comp), so both take the 
+    number of particles and how many go in a leaf.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+float BvhSahCost(const std::vector<BvhNode> &nodes, int rootIndex, unsigned int numParticles, 
+    unsigned int maxParticlesPerLeaf);
+unsigned long long CountBvhNodesVisited(const std::vector<BvhNode> &nodes, int rootIndex, 
+    unsigned int numParticles, unsigned int maxParticlesPerLeaf);
+unsigned long long CountBvhWideNodesVisited(const std::vector<BvhNode> &nodes, int rootIndex, 
+    unsigned int numParticles, unsigned int maxParticlesPerLeaf);
+unsigned int CountInvalidBvhNodes(const std::vector<BvhNode> &nodes, 
+    const std::vector<BvhNodeBuildData> &buildData, int rootIndex, unsigned int numParticles, 
+    unsigned int maxParticlesPerLeaf);
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+#include "Include/Buffers/BvhNode.h"
+#include "Include/Buffers/Particle.h"
+#include "Include/Buffers/ParticleProperties.h"
+#include "Include/Buffers/ParticleSortingData.h"
+#include "Include/WorkStealingThreadPool.h"
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    BVH builders that run on the CPU, for checking the GPU's trees and for trees that are
+    worth more time than the GPU builders take.  They make the same arrays that are in the
+    BvhNodeSsbo and the BvhNodeBuildDataSsbo, byte for byte, so they can be compared with
+    what is read back from there or uploaded straight into them.
+
+    - BuildBvhKarrasCpu(...): the binary radix tree (see GenerateBinaryRadixTree.comp) over
+      sorting data that is already sorted, then the leaves' boxes (see
+      GenerateLeafNodeBoundingBoxes.comp) merged up to the root (see
+      MergeBoundingVolumes.comp).  Every step is the same algorithm as the GPU's, down to the
+      thread entrance counters, just with a WorkStealingThreadPool instead of work groups.
+      There is one for each sort key width (see SortingKeyWidth).
+    - BuildBvhBinnedSahCpu(...): a top-down tree over the same leaves, split wherever the
+      surface area heuristic (see BvhSahCost(...)) says is best, out of 16 bins along each
+      axis.  It takes a lot longer than any of the GPU builders, and the tree is about as good
+      as they come, so it is the baseline that their trees are measured against (see
+      CompareBvhBuilders() in main.cpp).  It is also for particles that don't move much: build
+      it once, upload it, and let the refit (see BvhRefitLayout.comp) keep it up to date.
+
+    The layout is the same as the GPU's: leaf N is at N, the root is at the number of leaves
+    that the buffer has room for, and the internal nodes that are in use come after it (see
+    BvhLeaves.comp).  The arrays are sized like the SSBOs and the slots that the tree doesn't
+    use are left at their defaults.
+
+    Note: The number of leaves that there is room for comes from particles.size(), the same as
+    the BvhNodeSsbo's comes from the ParticleSsbo's number of particles.
+
+    Also Note: The leaves are the same for every builder, so only the internal nodes differ.
+    A leaf holds the particles that are next to each other in the sorted data (see
+    BvhLeaves.comp), and DetectCollisions.comp finds them that way.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+void BuildBvhKarrasCpu(const std::vector<ParticleSortingData> &sortedData,
+    unsigned int numActiveParticles, const std::vector<Particle> &particles,
+    const std::vector<ParticleProperties> &particleProperties, unsigned int maxParticlesPerLeaf,
+    WorkStealingThreadPool &threadPool, std::vector<BvhNode> &nodes,
+    std::vector<BvhNodeBuildData> &buildData);
+void BuildBvhKarrasCpu(const std::vector<ParticleSortingData64> &sortedData,
+    unsigned int numActiveParticles, const std::vector<Particle> &particles,
+    const std::vector<ParticleProperties> &particleProperties, unsigned int maxParticlesPerLeaf,
+    WorkStealingThreadPool &threadPool, std::vector<BvhNode> &nodes,
+    std::vector<BvhNodeBuildData> &buildData);
+void BuildBvhBinnedSahCpu(const std::vector<ParticleSortingData> &sortedData,
+    unsigned int numActiveParticles, const std::vector<Particle> &particles,
+    const std::vector<ParticleProperties> &particleProperties, unsigned int maxParticlesPerLeaf,
+    WorkStealingThreadPool &threadPool, std::vector<BvhNode> &nodes,
+    std::vector<BvhNodeBuildData> &buildData);
+void BuildBvhBinnedSahCpu(const std::vector<ParticleSortingData64> &sortedData,
+    unsigned int numActiveParticles, const std::vector<Particle> &particles,
+    const std::vector<ParticleProperties> &particleProperties, unsigned int maxParticlesPerLeaf,
+    WorkStealingThreadPool &threadPool, std::vector<BvhNode> &nodes,
+    std::vector<BvhNodeBuildData> &buildData);
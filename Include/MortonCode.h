@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include "ThirdParty/glm/vec4.hpp"
+#include "Include/Buffers/ParticleSortingData.h"
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    There are five ways to turn a particle's position into a sort key:
+    - MORTON_CODE_3D_10_BITS: X, Y, and Z at 10 bits each (see PositionToMortonCode.comp).  
+      This was the original.
+    - MORTON_CODE_2D_16_BITS: X and Y at 16 bits each (see PositionToMortonCode2D.comp).  The 
+      simulation is 2D, so this is the default.
+    - MORTON_CODE_3D_21_BITS_64: X, Y, and Z at 21 bits each (see 
+      PositionToMortonCode64.comp).
+    - MORTON_CODE_2D_32_BITS_64: X and Y at 32 bits each (see PositionToMortonCode2D64.comp).
+    - HILBERT_CODE_2D_16_BITS: Not a Morton Code.  X and Y at 16 bits each along a Hilbert 
+      curve instead of a Z-order curve (see PositionToHilbertCode2D.comp).  Same grid and key 
+      as MORTON_CODE_2D_16_BITS, but without the Z-order curve's jumps between quadrants.
+    MORTON_CODE_3D_21_BITS_64 and MORTON_CODE_2D_32_BITS_64 need 64-bit sort keys (see 
+    SortingKey64.comp).  They cost more to sort, but large particle regions need the 
+    resolution to keep particles from piling into the same code.  MortonCodeKeyWidth(...) 
+    says which key width goes with which encoding.
+    Which one the GPU uses is decided when the shaders are assembled, so it is given to the 
+    ParticleCollisions constructor.
+
+    The CPU versions below must give exactly the same codes as the shaders.  They are for 
+    checking the GPU's work and for comparing the encoders (see 
+    CompareMortonCodeCollisionRates() in main.cpp).  They normalize against the fixed particle 
+    region, except for the PositionToMortonCode2D(...) that takes the scene bounds that the 
+    GPU used (see ProfileCpuBvhBuilderScaling() in main.cpp).
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+enum class MortonCodeEncoding
+{
+    MORTON_CODE_3D_10_BITS,
+    MORTON_CODE_2D_16_BITS,
+    MORTON_CODE_3D_21_BITS_64,
+    MORTON_CODE_2D_32_BITS_64,
+    HILBERT_CODE_2D_16_BITS
+};
+
+std::string MortonCodeShaderFilePath(MortonCodeEncoding encoding);
+SortingKeyWidth MortonCodeKeyWidth(MortonCodeEncoding encoding);
+
+unsigned int PositionToMortonCode3D(const glm::vec4 &pos);
+unsigned int PositionToMortonCode2D(const glm::vec4 &pos);
+unsigned int PositionToMortonCode2D(const glm::vec4 &pos, const glm::vec4 &regionMin, 
+    const glm::vec4 &regionInverseRange);
+unsigned long long PositionToMortonCode3D64(const glm::vec4 &pos);
+unsigned long long PositionToMortonCode2D64(const glm::vec4 &pos);
+unsigned int PositionToHilbertCode2D(const glm::vec4 &pos);
+unsigned long long PositionToMortonCode(const glm::vec4 &pos, MortonCodeEncoding encoding);
+
+glm::vec4 MortonCode3DToPosition(unsigned int mortonCode);
+glm::vec4 MortonCode2DToPosition(unsigned int mortonCode);
+glm::vec4 MortonCode3D64ToPosition(unsigned long long mortonCode);
+glm::vec4 MortonCode2D64ToPosition(unsigned long long mortonCode);
+glm::vec4 HilbertCode2DToPosition(unsigned int hilbertCode);
+glm::vec4 MortonCodeToPosition(unsigned long long mortonCode, MortonCodeEncoding encoding);
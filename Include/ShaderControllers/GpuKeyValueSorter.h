@@ -0,0 +1,145 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Include/Buffers/ParticleSortingData.h"
+#include "Include/Buffers/SSBOs/ParticleSortingDataSsbo.h"
+#include "Include/Buffers/SSBOs/PrefixSumSsbo.h"
+#include "Include/Buffers/SSBOs/PrefixScanLookBackSsbo.h"
+#include "Include/Buffers/SSBOs/RadixSortPassPlanSsbo.h"
+#include "Include/Buffers/SSBOs/ActiveParticlesSsbo.h"
+
+
+namespace ShaderControllers
+{
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Sorts key-value pairs on the GPU.  The pairs are ParticleSortingData (key =
+        _sortingData, value = _preSortedParticleIndex) or ParticleSortingData64, they live in
+        the first half of a ParticleSortingDataSsbo (the second half is the radix sort's
+        ping-pong space), and the number of pairs to sort lives on the GPU in an
+        ActiveParticlesSsbo.  The sorted pairs end up back in the first half.
+
+        This used to be built into ParticleCollisions.  It was pulled out so that anything that
+        needs a sort can share the same tuned sort and the same benchmark.  The scratch buffers
+        (prefix sums, prefix scan look-back, radix sort pass plan) belong to the sorter, and
+        which algorithm runs is up to the sorter:
+        - RADIX_SORT_1_BIT: the original.
+        - RADIX_SORT_MULTI_BIT: RADIX_SORT_BITS_PER_DIGIT bits per pass (see
+          RadixSortDigitSize.comp).
+        - SHARED_MEMORY_SORT: one work group, small item counts only (see
+          SharedMemorySortLayout.comp).  The constructor picks it when everything fits and the
+          multi-bit radix sort otherwise.
+        The incremental sort (see IncrementalSortLayout.comp) runs in front of either radix
+        sort if it is on.
+
+        Note: The sorter binds its buffers to their SSBO binding points at the start of every
+        Sort(...), so whoever uses the same binding points for something else in between (the
+        prefix scan buffer, for example) doesn't need to put anything back.
+
+        Keys can be 32 or 64 bits wide (see SortingKeyWidth in ParticleSortingData.h).  The
+        width is baked into the shaders, so a sorter only sorts one width.  64-bit keys take
+        twice as many radix sort passes, but only if their bits actually change (see
+        RadixSortPassBitNumbers in RadixSortPassPlanBuffer.comp).
+
+        The prefix scan (see PrefixScanOverAllData.comp) is public too.  Stream compaction
+        needs one, and there is no sense in a second copy of the program and its scratch
+        buffers on the same binding points.  Whoever uses it fills out the PrefixScanBuffer
+        with its own shaders (assembled with PrefixScanBuffer.comp and given the uniforms with
+        ConfigurePrefixScanUniforms(...)) and reads the sums back out of it the same way.
+
+        Also Note: The item count and the indirect dispatch commands that go with it have the
+        layout in ActiveParticlesLayout.comp.  CompactSortingData.comp fills them out for the
+        particles.  Anybody else can fill them out from the CPU with
+        ActiveParticlesSsbo::SetNumActiveParticles(...).
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    class GpuKeyValueSorter
+    {
+    public:
+        enum class Algorithm
+        {
+            RADIX_SORT_1_BIT,
+            RADIX_SORT_MULTI_BIT,
+            SHARED_MEMORY_SORT
+        };
+
+        GpuKeyValueSorter(unsigned int maxNumItems, SortingKeyWidth keyWidth);
+        ~GpuKeyValueSorter();
+
+        void SetAlgorithm(Algorithm algorithm);
+        void SetIncrementalSort(bool useIncrementalSort);
+        unsigned int MaxNumItems() const;
+        SortingKeyWidth KeyWidth() const;
+
+        void Sort(const ParticleSortingDataSsbo &keyValueSsbo, const ActiveParticlesSsbo &itemCountSsbo) const;
+        long long SortWithProfiling(const ParticleSortingDataSsbo &keyValueSsbo, const ActiveParticlesSsbo &itemCountSsbo) const;
+
+        // the CPU reference for checking the GPU's work
+        // Note: 32-bit keys are read back into the 64-bit struct so that there only needs to
+        // be one reference.
+        static void SortOnCpu(std::vector<ParticleSortingData64> &keyValuePairs);
+        static bool MatchesCpuSort(const std::vector<ParticleSortingData64> &unsortedKeyValuePairs,
+            const std::vector<ParticleSortingData64> &sortedKeyValuePairs);
+
+        // whoever else assembles shaders that read the key-value SSBO needs the same key file
+        static std::string SortingKeyShaderFilePath(SortingKeyWidth keyWidth);
+
+        // the prefix scan is shared with whoever else needs one (see Description)
+        void ConfigurePrefixScanUniforms(unsigned int computeProgramId) const;
+        void BindPrefixScanBuffers() const;
+        void PrefixScanOverAllItems() const;
+        void PrefixScanIndirect(unsigned int dispatchCommandByteOffset) const;
+
+    private:
+        unsigned int _maxNumItems;
+        SortingKeyWidth _keyWidth;
+        Algorithm _algorithm;
+        bool _useIncrementalSort;
+
+        unsigned int _programIdGetSortingDataBitMasks;
+        unsigned int _programIdMeasureSortingDataDisorder;
+        unsigned int _programIdPlanIncrementalSort;
+        unsigned int _programIdSortSortingDataTiles;
+        unsigned int _programIdPlanRadixSortPasses;
+        unsigned int _programIdGetBitForPrefixScan;
+        unsigned int _programIdPrefixScanOverAllData;
+        unsigned int _programIdSortSortingDataWithPrefixSums;
+        unsigned int _programIdGetDigitCountsForPrefixScan;
+        unsigned int _programIdSortSortingDataWithDigitPrefixSums;
+        unsigned int _programIdSortSortingDataInSharedMemory;
+
+        void AssembleProgramHeader(const std::string &shaderKey) const;
+        void AssembleProgramGetSortingDataBitMasks();
+        void AssembleProgramMeasureSortingDataDisorder();
+        void AssembleProgramPlanIncrementalSort();
+        void AssembleProgramSortSortingDataTiles();
+        void AssembleProgramPlanRadixSortPasses();
+        void AssembleProgramGetBitForPrefixScan();
+        void AssembleProgramPrefixScanOverAllData();
+        void AssembleProgramSortSortingDataWithPrefixSums();
+        void AssembleProgramGetDigitCountsForPrefixScan();
+        void AssembleProgramSortSortingDataWithDigitPrefixSums();
+        void AssembleProgramSortSortingDataInSharedMemory();
+
+        bool BindBuffers(const ParticleSortingDataSsbo &keyValueSsbo, const ActiveParticlesSsbo &itemCountSsbo) const;
+        unsigned int KeyNumBits() const;
+        std::vector<ParticleSortingData64> ReadKeyValuePairs(const ParticleSortingDataSsbo &keyValueSsbo, const ActiveParticlesSsbo &itemCountSsbo) const;
+
+        // the "without profiling" and "with profiling" go through these same steps
+        void IncrementalSort(const ActiveParticlesSsbo &itemCountSsbo) const;
+        void SortSortingDataInSharedMemory() const;
+        void PlanRadixSortPasses(const ActiveParticlesSsbo &itemCountSsbo) const;
+        void PrepareForPrefixScan(unsigned int passNumber, unsigned int sortingDataReadOffset) const;
+        void PrefixScanOverSortingData(unsigned int passNumber) const;
+        void SortSortingDataWithPrefixScan(unsigned int passNumber, unsigned int sortingDataReadOffset, unsigned int sortingDataWriteOffset) const;
+        void PrepareForDigitPrefixScan(unsigned int passNumber, unsigned int sortingDataReadOffset) const;
+        void SortSortingDataWithDigitPrefixScan(unsigned int passNumber, unsigned int sortingDataReadOffset, unsigned int sortingDataWriteOffset) const;
+
+        // scratch space
+        PrefixSumSsbo _prefixSumSsbo;
+        PrefixScanLookBackSsbo _prefixScanLookBackSsbo;
+        RadixSortPassPlanSsbo _radixSortPassPlanSsbo;
+    };
+}
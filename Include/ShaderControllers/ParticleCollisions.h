@@ -4,13 +4,25 @@
 #include <string>
 
 #include "Include/Buffers/SSBOs/BvhNodeSsbo.h"
+#include "Include/Buffers/SSBOs/BvhNodeBuildDataSsbo.h"
 #include "Include/Buffers/SSBOs/ParticlePropertiesSsbo.h"
 #include "Include/Buffers/SSBOs/ParticleSortingDataSsbo.h"
 #include "Include/Buffers/SSBOs/ParticleSsbo.h"
-#include "Include/Buffers/SSBOs/PrefixSumSsbo.h"
+#include "Include/Buffers/SSBOs/ActiveParticlesSsbo.h"
+#include "Include/Buffers/SSBOs/ParticleReorderSsbo.h"
+#include "Include/Buffers/SSBOs/SceneBoundsSsbo.h"
+#include "Include/Buffers/SSBOs/BvhRefitSsbo.h"
+#include "Include/Buffers/SSBOs/BvhClusterSsbo.h"
+#include "Include/Buffers/SSBOs/BvhWideNodeSsbo.h"
+#include "Include/Buffers/SSBOs/BvhQuantizedNodeSsbo.h"
+#include "Include/Buffers/BvhRefitState.h"
+#include "Include/Buffers/SceneBounds.h"
 #include "Include/Buffers/SSBOs/ParticlePotentialCollisionsSsbo.h"
 #include "Include/Buffers/SSBOs/ParticleVelocityVectorGeometrySsbo.h"
 #include "Include/Buffers/SSBOs/ParticleBoundingBoxGeometrySsbo.h"
+#include "Include/ShaderControllers/GpuKeyValueSorter.h"
+#include "Include/MortonCode.h"
+#include "Include/CpuBvhBuilders.h"
 
 
 namespace ShaderControllers
@@ -24,34 +36,107 @@ namespace ShaderControllers
     class ParticleCollisions
     {
     public:
-        ParticleCollisions(const ParticleSsbo::SharedConstPtr particleSsbo, const ParticlePropertiesSsbo::SharedConstPtr particlePropertiesSsbo);
+        // the sort itself lives in GpuKeyValueSorter (see there for the choices)
+        using SortingAlgorithm = GpuKeyValueSorter::Algorithm;
+
+        // how the BVH is built (see SetBvhBuilder(...))
+        enum class BvhBuilder
+        {
+            KARRAS_RADIX_TREE,
+            AGGLOMERATIVE,
+            PLOC,
+            BINNED_SAH_CPU
+        };
+
+        // for comparing the sort keys and the leaf sizes (see MeasureTreeQuality(...))
+        struct TreeQuality
+        {
+            unsigned int _numActiveParticles;
+            unsigned int _numBvhLeaves;
+            float _sahCost;
+            unsigned long long _numNodesVisited;
+            unsigned long long _numPotentialCollisions;
+            unsigned int _numInvalidBvhNodes;
+            long long _durationBuildBvh;
+            long long _durationDetectCollisions;
+        };
+
+        ParticleCollisions(const ParticleSsbo::SharedPtr particleSsbo, const ParticlePropertiesSsbo::SharedConstPtr particlePropertiesSsbo, MortonCodeEncoding mortonCodeEncoding, unsigned int maxParticlesPerBvhLeaf);
         ~ParticleCollisions();
 
+        void SetSortingAlgorithm(SortingAlgorithm algorithm);
+        void SetIncrementalSort(bool useIncrementalSort);
+        void SetLazyParticleReorder(bool useLazyParticleReorder);
+        void SetDynamicMortonCodeBounds(bool useDynamicMortonCodeBounds);
+        void SetBvhRefit(bool useBvhRefit);
+        void SetBvhBuilder(BvhBuilder builder);
+        void SetBvhTreeletRestructuring(bool useBvhTreeletRestructuring);
+        void SetWideBvhTraversal(bool useWideBvhTraversal);
+        void SetQuantizedBvhTraversal(bool useQuantizedBvhTraversal);
         void DetectAndResolve(bool withProfiling, bool generateGeometry) const;
+        TreeQuality MeasureTreeQuality(unsigned int numTraversals) const;
+        BvhRefitState ReadBvhRefitState() const;
+        void ReadBackBvh(std::vector<BvhNode> &nodes, std::vector<BvhNodeBuildData> &buildData) const;
+        SceneBounds ReadSceneBounds() const;
+        void ReadBackCpuBvhBuildInput(unsigned int &numActiveParticles, std::vector<ParticleSortingData> &sortedData, std::vector<ParticleSortingData64> &sortedData64, std::vector<Particle> &particles, std::vector<ParticleProperties> &particleProperties) const;
         const VertexSsboBase &ParticleVelocityVectorSsbo() const;
         const VertexSsboBase &ParticleBoundingBoxSsbo() const;
 
     private:
         unsigned int _numParticles;
-
-        // lots of programs for sorting
-        unsigned int _programIdCopyParticlesToCopyBuffer;
+        MortonCodeEncoding _mortonCodeEncoding;
+        unsigned int _maxParticlesPerBvhLeaf;
+        bool _useLazyParticleReorder;
+        bool _useDynamicMortonCodeBounds;
+        bool _useBvhRefit;
+        BvhBuilder _bvhBuilder;
+        bool _useBvhTreeletRestructuring;
+        bool _useWideBvhTraversal;
+        bool _useQuantizedBvhTraversal;
+
+        // programs for getting the particles ready to sort and moving them once they are
+        unsigned int _programIdComputeSceneBounds;
+        unsigned int _programIdFinalizeSceneBounds;
         unsigned int _programIdGenerateSortingData;
-        unsigned int _programIdClearWorkGroupSums;
-        unsigned int _programIdGetBitForPrefixScan;
-        unsigned int _programIdPrefixScanOverAllData;
-        unsigned int _programIdPrefixScanOverWorkGroupSums;
-        unsigned int _programIdSortSortingDataWithPrefixSums;
+        unsigned int _programIdCompactSortingData;
         unsigned int _programIdSortParticles;
+        unsigned int _programIdMeasureParticleLocality;
+        unsigned int _programIdPlanParticleReorder;
+        unsigned int _programIdCopyParticlesFromBackBuffer;
 
         // and a few more for collisions
-        unsigned int _programIdGuaranteeSortingDataUniqueness;
         unsigned int _programIdGenerateLeafNodeBoundingBoxes;
         unsigned int _programIdGenerateBinaryRadixTree;
         unsigned int _programIdMergeBoundingVolumes;
 
+        // or all of that at once
+        unsigned int _programIdBuildBvhAgglomerative;
+
+        // or a slower one that makes a better tree
+        unsigned int _programIdInitBvhClusters;
+        unsigned int _programIdFindBvhClusterNearestNeighbors;
+        unsigned int _programIdMergeBvhClusters;
+        unsigned int _programIdCompactBvhClusters;
+        unsigned int _programIdCountBvhClusters;
+
+        // for making any of their trees better
+        unsigned int _programIdRestructureBvhTreelets;
+
+        // for going through any of them 4 children at a time
+        unsigned int _programIdCollapseBvhToWideNodes;
+
+        // for going through any of them with half-size nodes
+        unsigned int _programIdQuantizeBvhNodes;
+
+        // for refitting the BVH instead of rebuilding it
+        unsigned int _programIdCountActiveParticles;
+        unsigned int _programIdMeasureBvhArea;
+        unsigned int _programIdPlanBvhRefit;
+
         // all that for the coup de grace
         unsigned int _programIdDetectCollisions;
+        unsigned int _programIdDetectCollisionsWideBvh;
+        unsigned int _programIdDetectCollisionsQuantizedBvh;
         unsigned int _programIdResolveCollisions;
 
         // for drawing pretty things
@@ -59,57 +144,98 @@ namespace ShaderControllers
         unsigned int _programIdGenerateVerticesParticleBoundingBoxes;
 
         void AssembleProgramHeader(const std::string &shaderKey) const;
-        void AssembleProgramCopyParticlesToCopyBuffer();
+        void AssembleProgramComputeSceneBounds();
+        void AssembleProgramFinalizeSceneBounds();
         void AssembleProgramGenerateSortingData();
-        void AssembleProgramClearWorkGroupSums();
-        void AssembleProgramGetBitForPrefixScan();
-        void AssembleProgramPrefixScanOverAllData();
-        void AssembleProgramPrefixScanOverWorkGroupSums();
-        void AssembleProgramSortSortingDataWithPrefixSums();
+        void AssembleProgramCompactSortingData();
         void AssembleProgramSortParticles();
-        void AssembleProgramGuaranteeSortingDataUniqueness();
+        void AssembleProgramMeasureParticleLocality();
+        void AssembleProgramPlanParticleReorder();
+        void AssembleProgramCopyParticlesFromBackBuffer();
         void AssembleProgramGenerateLeafNodeBoundingBoxes();
         void AssembleProgramGenerateBinaryRadixTree();
         void AssembleProgramMergeBoundingVolumes();
+        void AssembleProgramBuildBvhAgglomerative();
+        void AssembleProgramInitBvhClusters();
+        void AssembleProgramFindBvhClusterNearestNeighbors();
+        void AssembleProgramMergeBvhClusters();
+        void AssembleProgramCompactBvhClusters();
+        void AssembleProgramCountBvhClusters();
+        void AssembleProgramRestructureBvhTreelets();
+        void AssembleProgramCollapseBvhToWideNodes();
+        void AssembleProgramQuantizeBvhNodes();
+        void AssembleProgramCountActiveParticles();
+        void AssembleProgramMeasureBvhArea();
+        void AssembleProgramPlanBvhRefit();
         void AssembleProgramDetectCollisions();
+        void AssembleProgramDetectCollisionsWideBvh();
+        void AssembleProgramDetectCollisionsQuantizedBvh();
         void AssembleProgramResolveCollisions();
         void AssembleProgramGenerateVerticesParticleVelocityVectors();
         void AssembleProgramGenerateVerticesParticleBoundingBoxes();
 
 
-        void SortParticlesWithoutProfiling(unsigned int numWorkGroupsX, unsigned int numWorkGroupsXPrefixScan) const;
-        void SortParticlesWithProfiling(unsigned int numWorkGroupsX, unsigned int numWorkGroupsXPrefixScan) const;
+        void CalculateNumWorkGroups(unsigned int &numWorkGroupsX) const;
+
+        void SortParticlesWithoutProfiling(unsigned int numWorkGroupsX) const;
+        void SortParticlesWithProfiling(unsigned int numWorkGroupsX) const;
+
+        void GenerateBvhWithoutProfiling() const;
+        void GenerateBvhWithProfiling() const;
 
-        void GenerateBvhWithoutProfiling(unsigned int numWorkGroupsX) const;
-        void GenerateBvhWithProfiling(unsigned int numWorkGroupsX) const;
+        bool BvhRebuildRequested() const;
+        void ReportBvhRefit(bool rebuilt, long long durationBvh) const;
 
-        void DetectAndResolveCollisionsWithoutProfiling(unsigned int numWorkGroupsX) const;
-        void DetectAndResolveCollisionsWithProfiling(unsigned int numWorkGroupsX) const;
+        void DetectAndResolveCollisionsWithoutProfiling() const;
+        void DetectAndResolveCollisionsWithProfiling() const;
 
         // the "without profiling" and "with profiling" go through these same steps
+        void BindBuffers() const;
         void PrepareToSortParticles(unsigned int numWorkGroupsX) const;
-        void PrepareForPrefixScan(unsigned int bitNumber, unsigned int sortingDataReadOffset) const;
-        void PrefixScanOverParticleSortingData(unsigned int numWorkGroupsX) const;
-        void SortSortingDataWithPrefixScan(unsigned int numWorkGroupsX, unsigned int bitNumber, unsigned int sortingDataReadOffset, unsigned int sortingDataWriteOffset) const;
+        void CompactSortingData(unsigned int numWorkGroupsX) const;
         void SortParticlesWithSortedData(unsigned int numWorkGroupsX, unsigned int sortingDataReadOffset) const;
-        void PrepareForBinaryTree(unsigned int numWorkGroupsX) const;
-        void GenerateBinaryRadixTree(unsigned int numWorkGroupsX) const;
-        void MergeNodesIntoBvh(unsigned int numWorkGroupsX) const;
-        void DetectCollisions(unsigned int numWorkGroupsX) const;
-        void ResolveCollisions(unsigned int numWorkGroupsX) const;
+        void PrepareForBinaryTree() const;
+        void GenerateBinaryRadixTree() const;
+        void MergeNodesIntoBvh() const;
+        void BuildBvhAgglomerative() const;
+        void BuildBvhPloc() const;
+        void BuildBvhBinnedSah() const;
+        void RestructureBvhTreelets() const;
+        void CollapseBvhToWideNodes() const;
+        void QuantizeBvhNodes() const;
+        void RefitBvh(unsigned int numWorkGroupsX) const;
+        void PlanBvhRefit(bool justRebuilt) const;
+        void DetectCollisions() const;
+        void ResolveCollisions() const;
 
         // for drawing pretty things
         void GenerateGeometry(unsigned int numWorkGroupsX) const;
 
         // buffers for sorting, BVH generation, and anything else that's necessary
         ParticleSortingDataSsbo _particleSortingDataSsbo;
-        PrefixSumSsbo _prefixSumSsbo;
+        GpuKeyValueSorter _sorter;
+        ActiveParticlesSsbo _activeParticlesSsbo;
+        ParticleReorderSsbo _particleReorderSsbo;
+        SceneBoundsSsbo _sceneBoundsSsbo;
         BvhNodeSsbo _bvhNodeSsbo;
+        BvhNodeBuildDataSsbo _bvhNodeBuildDataSsbo;
+        BvhRefitSsbo _bvhRefitSsbo;
+        BvhClusterSsbo _bvhClusterSsbo;
+        BvhWideNodeSsbo _bvhWideNodeSsbo;
+        BvhQuantizedNodeSsbo _bvhQuantizedNodeSsbo;
         ParticlePotentialCollisionsSsbo _particlePotentialCollisionsSsbo;
         ParticleVelocityVectorGeometrySsbo _velocityVectorGeometrySsbo;
         ParticleBoundingBoxGeometrySsbo _boundingBoxGeometrySsbo;
 
-        // used for verifying that particle sorting is working
-        const ParticleSsbo::SharedConstPtr _originalParticleSsbo; 
+        // the particle sort swaps its halves (see ParticleSsbo.h) unless the lazy particle 
+        // reorder is on, and it is also used for verifying that particle sorting is working
+        const ParticleSsbo::SharedPtr _particleSsbo; 
+
+        // only used by the CPU builders (see CpuBvhBuilders.h), for the binned SAH tree and for 
+        // checking the GPU's tree against the CPU's
+        const ParticlePropertiesSsbo::SharedConstPtr _particlePropertiesSsbo;
+
+        // made when the binned SAH builder is picked (see SetBvhBuilder(...))
+        WorkStealingThreadPool::SharedPtr _cpuThreadPool;
     };
 }
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    A pool of CPU threads for the CPU BVH builders (see CpuBvhBuilders.h).  Those are the GPU
+    algorithms run on the CPU, so they only ever need one thing: "do this for every item, in
+    parallel, and wait until it is done".  That is ParallelFor(...).
+
+    The items are cut into chunks, and the chunks are dealt out to a queue per thread.  Each
+    thread works through its own queue from the back, and when it runs out, it steals from the
+    front of the others' queues.  Chunks don't all take the same time (a leaf near the root
+    of the tree takes longer to walk up from than one at the bottom, for example), so a thread
+    that finishes early helps out instead of waiting on the slowest one.
+
+    The thread that calls ParallelFor(...) works too, so a pool of N threads has N - 1 workers,
+    and a pool of 1 thread runs everything right there in the caller.  That is handy for
+    measuring how it scales.
+
+    Note: Only one thread at a time may call ParallelFor(...), and the body may not call it
+    again.  The builders do everything in flat passes, so they don't need either.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+class WorkStealingThreadPool
+{
+public:
+    explicit WorkStealingThreadPool(unsigned int numThreads = 0);
+    ~WorkStealingThreadPool();
+    using SharedPtr = std::shared_ptr<WorkStealingThreadPool>;
+
+    unsigned int NumThreads() const;
+    void ParallelFor(unsigned int numItems, unsigned int itemsPerChunk,
+        const std::function<void(unsigned int, unsigned int)> &body);
+
+private:
+    // the std::mutex can't be moved, so each queue is allocated on its own
+    struct TaskQueue
+    {
+        std::mutex _mutex;
+        std::deque<std::function<void()>> _tasks;
+    };
+
+    bool PopTask(unsigned int queueIndex, std::function<void()> &task);
+    void WorkerLoop(unsigned int queueIndex);
+
+    // [0] is the calling thread's, the rest are the workers'
+    std::vector<std::unique_ptr<TaskQueue>> _queues;
+    std::vector<std::thread> _workers;
+
+    // the workers sleep on this when there is nothing to do
+    std::mutex _sleepMutex;
+    std::condition_variable _wakeUp;
+    std::atomic<int> _numQueuedTasks;
+    bool _shuttingDown;
+};
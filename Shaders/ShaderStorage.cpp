@@ -71,7 +71,8 @@ Description:
     Prints errors to stderr.
 Parameters: 
     programKey  The name that will be used to refer to this shader for the rest of the program.
-                If it already exists, it prints a message to stderr and immediately returns.
+                If it already exists and hasn't been compiled yet, it prints a message to 
+                stderr and immediately returns.
 Returns:    None
 Creator:    John Cox, 3/11/2017
 ------------------------------------------------------------------------------------------------*/
@@ -97,13 +98,17 @@ Description:
     Prints errors to stderr.
 Parameters: 
     programKey  The name that will be used to refer to this shader for the rest of the program.
-                If it already exists, it prints a message to stderr and immediately returns.
+                If it already exists and hasn't been compiled yet, it prints a message to 
+                stderr and immediately returns.
 Returns:    None
 Creator:    John Cox, 3/2017
 ------------------------------------------------------------------------------------------------*/
 void ShaderStorage::NewCompositeShader(const std::string &programKey)
 {
-    if (_partialShaderContents.find(programKey) != _partialShaderContents.end())
+    // Note: The contents are cleared after they are compiled, so an empty entry is left over 
+    // from the last time that this key was built and is fine to reuse.
+    _COMPOSITE_SHADER_MAP::iterator itr = _partialShaderContents.find(programKey);
+    if (itr != _partialShaderContents.end() && !itr->second.empty())
     {
         fprintf(stderr, "partial shader file already exists for program key '%s'\n",
             programKey.c_str());
@@ -259,9 +264,34 @@ void ShaderStorage::AddPartialShaderFile(const std::string &programKey, const st
         return;
     }
 
+    AddPartialShaderContents(programKey, fileContents);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Like AddPartialShaderFile(...), but the contents come from a string instead of a file.  
+    This is for the few things that aren't known until the program is running, such as a 
+    #define that a compute controller decides on when it assembles its shaders.
+
+    Prints its own errors to stderr.
+Parameters:
+    programKey  Must have already been created by NewCompositeShader(...).
+    contents    Self-explanatory.
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+void ShaderStorage::AddPartialShaderContents(const std::string &programKey, const std::string &contents)
+{
+    if (_partialShaderContents.find(programKey) == _partialShaderContents.end())
+    {
+        fprintf(stderr, "Could not add shader contents.  No program key '%s'\n",
+            programKey.c_str());
+        return;
+    }
+
     // add a new line just to make sure that there is a clear distinction between any possible 
     // prior file contents and the current file
-    _partialShaderContents[programKey] += ("\n" + fileContents);
+    _partialShaderContents[programKey] += ("\n" + contents);
 }
 
 /*------------------------------------------------------------------------------------------------
@@ -360,6 +390,10 @@ GLuint ShaderStorage::LinkShader(const std::string &programKey)
         glDeleteShader(shaderId);
     }
 
+    // the IDs are dead now, so don't let them get attached again if the same key is built again
+    // (another instance of the same shader controller, for example)
+    itr->second.clear();
+
     // check if the program was built ok
     // Note: Perform this check after the shader objects were already cleaned up.  It makes
     // the program cleanup easier.
@@ -491,7 +525,8 @@ Description:
     Prints errors to stderr.
 Parameters: 
     programKey  The name that will be used to refer to this shader for the rest of the program.
-                If it already exists, it prints a message to stderr and immediately returns.
+                If it already exists and hasn't been compiled yet, it prints a message to 
+                stderr and immediately returns.
 Returns:    None
 Creator:    John Cox, 3/2017
 ------------------------------------------------------------------------------------------------*/
@@ -28,6 +28,7 @@ public:
 
     void AddAndCompileShaderFile(const std::string &programKey, const std::string &filePath, const GLenum shaderType);
     void AddPartialShaderFile(const std::string &programKey, const std::string &filePath);
+    void AddPartialShaderContents(const std::string &programKey, const std::string &contents);
     void CompileCompositeShader(const std::string &programKey, const GLenum shaderType);
     
     GLuint LinkShader(const std::string &programKey);
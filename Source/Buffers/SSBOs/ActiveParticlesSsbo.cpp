@@ -0,0 +1,104 @@
+#include "Include/Buffers/SSBOs/ActiveParticlesSsbo.h"
+
+#include "ThirdParty/glload/include/glload/gl_4_4.h"
+#include "Shaders/ShaderHeaders/ComputeShaderWorkGroupSizes.comp"
+#include "Shaders/ShaderHeaders/SsboBufferBindings.comp"
+#include "Shaders/Compute/ParticleCollisions/IncrementalSortLayout.comp"
+#include "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp"
+
+#include <vector>
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Initializes base class, then allocates space for the SSBO.
+
+    Note: Everything starts at 0, so until CompactSortingData.comp runs for the first time, 
+    every dispatch command has 0 work groups.
+Parameters: 
+    maxParticlesPerBvhLeaf  Only used by SetNumActiveParticles(...).  Must be the same as the 
+                            compute controller's BVH_MAX_PARTICLES_PER_LEAF (see 
+                            BvhLeaves.comp).  Anything that doesn't build a BVH can use 1.
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+ActiveParticlesSsbo::ActiveParticlesSsbo(unsigned int maxParticlesPerBvhLeaf) :
+    SsboBase(),  // generate buffers
+    _maxParticlesPerBvhLeaf(maxParticlesPerBvhLeaf)
+{
+    unsigned int numDispatchCommandUints = 
+        ACTIVE_PARTICLES_NUM_DISPATCH_SLOTS * ACTIVE_PARTICLES_UINTS_PER_DISPATCH_COMMAND;
+    std::vector<unsigned int> v(ACTIVE_PARTICLES_HEADER_UINTS + numDispatchCommandUints);
+
+    // now bind this new buffer to the dedicated buffer binding location
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, ACTIVE_PARTICLES_BUFFER_BINDING, _bufferId);
+
+    // and fill it with new data
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferId);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, v.size() * sizeof(unsigned int), v.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Writes the count and the dispatch commands that go with it from the CPU, the same way that 
+    CompactSortingData.comp writes them on the GPU.  For anything that already knows how many 
+    items it has (the sort benchmark, for example).
+
+    Note: This is a glBufferSubData(...), so it is in line with the GPU commands around it.  
+    Nothing has to wait.
+Parameters: 
+    numActiveParticles  Self-explanatory.
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+void ActiveParticlesSsbo::SetNumActiveParticles(unsigned int numActiveParticles) const
+{
+    unsigned int workGroupCounts[ACTIVE_PARTICLES_NUM_DISPATCH_SLOTS];
+    workGroupCounts[ACTIVE_PARTICLES_DISPATCH_PARTICLES] = (numActiveParticles + WORK_GROUP_SIZE_X - 1) / WORK_GROUP_SIZE_X;
+    workGroupCounts[ACTIVE_PARTICLES_DISPATCH_INCREMENTAL_SORT_TILES] = (numActiveParticles + INCREMENTAL_SORT_ITEMS_PER_TILE - 1) / INCREMENTAL_SORT_ITEMS_PER_TILE;
+    unsigned int numLeaves = (numActiveParticles + _maxParticlesPerBvhLeaf - 1) / _maxParticlesPerBvhLeaf;
+    workGroupCounts[ACTIVE_PARTICLES_DISPATCH_BVH_LEAVES] = (numLeaves + WORK_GROUP_SIZE_X - 1) / WORK_GROUP_SIZE_X;
+
+    std::vector<unsigned int> v;
+    v.push_back(numActiveParticles);
+    for (unsigned int slot = 0; slot < ACTIVE_PARTICLES_NUM_DISPATCH_SLOTS; slot++)
+    {
+        v.push_back(workGroupCounts[slot]);
+        v.push_back(1);
+        v.push_back(1);
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferId);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, v.size() * sizeof(unsigned int), v.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    glDispatchComputeIndirect(...) takes a byte offset into the GL_DISPATCH_INDIRECT_BUFFER.  
+    This calculates where the given dispatch slot's command is.
+Parameters: 
+    dispatchSlot    One of the ACTIVE_PARTICLES_DISPATCH_* values in ActiveParticlesLayout.comp.
+Returns:    
+    See Description.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int ActiveParticlesSsbo::DispatchCommandByteOffset(unsigned int dispatchSlot) const
+{
+    unsigned int uintOffset = ACTIVE_PARTICLES_HEADER_UINTS + 
+        (dispatchSlot * ACTIVE_PARTICLES_UINTS_PER_DISPATCH_COMMAND);
+    return uintOffset * sizeof(unsigned int);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    For profiling.  Reading this value back will stall the pipeline, so don't do it otherwise.
+Parameters: None
+Returns:    
+    The byte offset of ActiveParticlesBuffer::numActiveParticles.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int ActiveParticlesSsbo::NumActiveParticlesByteOffset() const
+{
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include "Include/Buffers/SSBOs/BvhClusterSsbo.h"
+
+#include "ThirdParty/glload/include/glload/gl_4_4.h"
+#include "Shaders/ShaderHeaders/SsboBufferBindings.comp"
+#include "Shaders/Compute/ParticleCollisions/BvhClusterLayout.comp"
+
+#include <vector>
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Initializes base class, then allocates space for the SSBO.
+
+    Note: Everything starts at 0.  InitBvhClusters.comp writes everything before anything 
+    reads it.
+Parameters: 
+    numParticles        The most particles that there can be in the tree.
+    maxParticlesPerLeaf The compute controller's BVH_MAX_PARTICLES_PER_LEAF (see 
+                        BvhLeaves.comp).
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+BvhClusterSsbo::BvhClusterSsbo(unsigned int numParticles, unsigned int maxParticlesPerLeaf) :
+    SsboBase()  // generate buffers
+{
+    unsigned int numLeaves = (numParticles + maxParticlesPerLeaf - 1) / maxParticlesPerLeaf;
+    unsigned int numDispatchCommandUints = 
+        BVH_CLUSTER_NUM_DISPATCH_SLOTS * BVH_CLUSTER_UINTS_PER_DISPATCH_COMMAND;
+    std::vector<unsigned int> v(BVH_CLUSTER_HEADER_UINTS + numDispatchCommandUints + 
+        (numLeaves * BVH_CLUSTER_INTS_PER_CLUSTER));
+
+    // now bind this new buffer to the dedicated buffer binding location
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BVH_CLUSTER_BUFFER_BINDING, _bufferId);
+
+    // and fill it with new data
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferId);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, v.size() * sizeof(unsigned int), v.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Sets the number of clusters and every dispatch command back to 0.  InitBvhClusters.comp 
+    isn't dispatched at all when there are no active particles, and without this the clusters 
+    would carry on from the last tree.
+
+    Note: This is a glBufferSubData(...), so it is in line with the GPU commands around it.  
+    Nothing has to wait.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+void BvhClusterSsbo::ClearClusters() const
+{
+    unsigned int numDispatchCommandUints = 
+        BVH_CLUSTER_NUM_DISPATCH_SLOTS * BVH_CLUSTER_UINTS_PER_DISPATCH_COMMAND;
+    std::vector<unsigned int> v(BVH_CLUSTER_HEADER_UINTS + numDispatchCommandUints);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferId);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, v.size() * sizeof(unsigned int), v.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    glDispatchComputeIndirect(...) takes a byte offset into the GL_DISPATCH_INDIRECT_BUFFER.  
+    This calculates where the given dispatch slot's command is.
+Parameters: 
+    dispatchSlot    One of the BVH_CLUSTER_DISPATCH_* values in BvhClusterLayout.comp.
+Returns:    
+    See Description.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int BvhClusterSsbo::DispatchCommandByteOffset(unsigned int dispatchSlot) const
+{
+    unsigned int uintOffset = BVH_CLUSTER_HEADER_UINTS + 
+        (dispatchSlot * BVH_CLUSTER_UINTS_PER_DISPATCH_COMMAND);
+    return uintOffset * sizeof(unsigned int);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Reading this value back will stall the pipeline until the GPU is done with the round that 
+    wrote it, so only read it every so often (see BVH_CLUSTER_ROUNDS_PER_CHECK).
+Parameters: None
+Returns:    
+    The byte offset of BvhClusterBuffer::numBvhClusters.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int BvhClusterSsbo::NumClustersByteOffset() const
+{
+    return 0;
+}
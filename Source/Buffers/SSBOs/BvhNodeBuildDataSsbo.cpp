@@ -0,0 +1,36 @@
+#include "Include/Buffers/SSBOs/BvhNodeBuildDataSsbo.h"
+
+#include "ThirdParty/glload/include/glload/gl_4_4.h"
+#include "Shaders/ShaderHeaders/SsboBufferBindings.comp"
+
+#include "Include/Buffers/BvhNode.h"
+
+#include <vector>
+
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Initializes base class, then allocates space for the SSBO.  Every node starts out with no 
+    parent and with its thread entrance counter at 0, which is how the builders expect to find 
+    them (see MergeBoundingVolumes.comp).
+Parameters: 
+    numParticles        Same as for the BvhNodeSsbo.
+    maxParticlesPerLeaf Same as for the BvhNodeSsbo.
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+BvhNodeBuildDataSsbo::BvhNodeBuildDataSsbo(unsigned int numParticles, unsigned int maxParticlesPerLeaf) :
+    SsboBase()  // generate buffers
+{
+    // same number as in the BvhNodeSsbo
+    unsigned int numLeaves = (numParticles + maxParticlesPerLeaf - 1) / maxParticlesPerLeaf;
+    std::vector<BvhNodeBuildData> v(numLeaves + (numLeaves - 1));
+
+    // now bind this new buffer to the dedicated buffer binding location
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BVH_NODE_BUILD_DATA_BUFFER_BINDING, _bufferId);
+
+    // and fill it with new data
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferId);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, v.size() * sizeof(BvhNodeBuildData), v.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
@@ -14,24 +14,25 @@ Description:
     Initializes base class, then gives derived class members initial values and allocates space 
     for the SSBO.
 Parameters: 
-    numLeaves   Expected to be the same size as the number of particles.  If it isn't, then 
-                there is a risk of particle buffer overrun.
+    numParticles        Expected to be the same size as the number of particles.  If it 
+                        isn't, then there is a risk of particle buffer overrun.
+    maxParticlesPerLeaf The compute controller's BVH_MAX_PARTICLES_PER_LEAF (see 
+                        BvhLeaves.comp).  1 gives every particle its own leaf.
 Returns:    None
 Creator:    John Cox, 5/2017
 ------------------------------------------------------------------------------------------------*/
-BvhNodeSsbo::BvhNodeSsbo(unsigned int numParticles) :
+BvhNodeSsbo::BvhNodeSsbo(unsigned int numParticles, unsigned int maxParticlesPerLeaf) :
     SsboBase()
 {
     // binary trees with N leaves have N-1 branches
-    _numLeaves = numParticles;
-    _numInternalNodes = numParticles - 1;
+    _numLeaves = (numParticles + maxParticlesPerLeaf - 1) / maxParticlesPerLeaf;
+    _numInternalNodes = _numLeaves - 1;
     _numTotalNodes = _numLeaves + _numInternalNodes;
-    std::vector<BvhNode> v(_numTotalNodes);
 
-    for (unsigned int leafNodeIndex = 0; leafNodeIndex < _numLeaves; leafNodeIndex++)
-    {
-        v[leafNodeIndex]._isLeaf = true;
-    }
+    // Note: Leaves are told apart by their parents (see BvhNodeLayout.comp), so nothing needs 
+    // to be marked.  The parent indexes and thread entrance counters are in the 
+    // BvhNodeBuildDataSsbo.
+    std::vector<BvhNode> v(_numTotalNodes);
 
     // now bind this new buffer to the dedicated buffer binding location
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BVH_NODE_BUFFER_BINDING, _bufferId);
@@ -0,0 +1,205 @@
+#include "Include/Buffers/SSBOs/BvhRefitSsbo.h"
+
+#include "ThirdParty/glload/include/glload/gl_4_4.h"
+#include "Shaders/ShaderHeaders/ComputeShaderWorkGroupSizes.comp"
+#include "Shaders/ShaderHeaders/SsboBufferBindings.comp"
+#include "Include/Buffers/BvhRefitState.h"
+
+#include <cstddef>
+#include <vector>
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Initializes base class, then allocates space for the SSBO.
+
+    Note: The state starts out asking for a rebuild (see BvhRefitState.h), so there is always a 
+    tree to refit.  The partial sums start at 0.  MeasureBvhArea.comp writes them before 
+    anything reads them.
+Parameters: 
+    numParticles    The most leaves that there can be in the tree.
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+BvhRefitSsbo::BvhRefitSsbo(unsigned int numParticles) :
+    SsboBase(),  // generate buffers
+    _rebuildDecisionBufferId(0),
+    _rebuildDecisionPtr(0),
+    _rebuildDecisionFence(0)
+{
+    BvhRefitState initialState;
+    unsigned int numPartialSums = (numParticles + WORK_GROUP_SIZE_X - 1) / WORK_GROUP_SIZE_X;
+    std::vector<float> partialSums(numPartialSums);
+    unsigned int partialSumsSizeBytes = partialSums.size() * sizeof(float);
+
+    // now bind this new buffer to the dedicated buffer binding location
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BVH_REFIT_BUFFER_BINDING, _bufferId);
+
+    // and fill it with new data
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferId);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(BvhRefitState) + partialSumsSizeBytes, 0, GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(BvhRefitState), &initialState);
+    if (partialSumsSizeBytes > 0)
+    {
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(BvhRefitState), partialSumsSizeBytes, partialSums.data());
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    // the CPU's copy of the rebuild decision (see RebuildRequested())
+    // Note: Only ever written by glCopyBufferSubData(...), so it only needs to be readable on 
+    // the CPU side.
+    GLuint flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &_rebuildDecisionBufferId);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _rebuildDecisionBufferId);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, sizeof(unsigned int), &initialState._bvhRebuildRequested, flags);
+    void *voidPtr = glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, sizeof(unsigned int), flags);
+    _rebuildDecisionPtr = static_cast<unsigned int *>(voidPtr);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Unmaps and deletes the rebuild decision's buffer and its fence.  The base class cleans up 
+    the rest.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+BvhRefitSsbo::~BvhRefitSsbo()
+{
+    if (_rebuildDecisionFence != 0)
+    {
+        glDeleteSync(static_cast<GLsync>(_rebuildDecisionFence));
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _rebuildDecisionBufferId);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glDeleteBuffers(1, &_rebuildDecisionBufferId);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Makes the next frame rebuild the tree no matter what PlanBvhRefit.comp decided.  For when 
+    the tree was built without going through it (turning the refit on, for example, or 
+    ParticleCollisions::MeasureTreeQuality(...)), so there is nothing to compare against and 
+    the thread entrance counters weren't put back (see MeasureBvhArea.comp).
+
+    Note: This is a glBufferSubData(...), so it is in line with the GPU commands around it.  
+    Nothing has to wait.  The CPU's copy of the decision is queued right behind it, so 
+    RebuildRequested() sees it too.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+void BvhRefitSsbo::RequestRebuild() const
+{
+    unsigned int rebuildRequested = 1;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferId);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, offsetof(BvhRefitState, _bvhRebuildRequested), sizeof(unsigned int), &rebuildRequested);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    QueueRebuildDecisionReadback();
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Has the GPU copy BvhRefitState::_bvhRebuildRequested into the persistently mapped buffer 
+    and puts a fence after it.  Nothing waits here.
+
+    Note: Expects a glMemoryBarrier(...) with GL_BUFFER_UPDATE_BARRIER_BIT after whichever 
+    shader wrote the decision (see PlanBvhRefit.comp).
+Parameters: None
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+void BvhRefitSsbo::QueueRebuildDecisionReadback() const
+{
+    // the last copy hasn't been looked at, but this one replaces it
+    if (_rebuildDecisionFence != 0)
+    {
+        glDeleteSync(static_cast<GLsync>(_rebuildDecisionFence));
+    }
+
+    glBindBuffer(GL_COPY_READ_BUFFER, _bufferId);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _rebuildDecisionBufferId);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offsetof(BvhRefitState, _bvhRebuildRequested), 0, sizeof(unsigned int));
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    _rebuildDecisionFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Reads the last decision that was queued with QueueRebuildDecisionReadback().  
+
+    Note: This only waits if the GPU hasn't gotten as far as the copy.  It is queued at the 
+    end of a frame's BVH work, and the per-frame sync (ParticleUpdate reads its atomic counter 
+    back after a fence every frame) has already waited past it by the time the next frame 
+    asks.
+Parameters: None
+Returns:    
+    True if the next frame should re-sort the particles and rebuild the tree, false if it 
+    should refit it.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+bool BvhRefitSsbo::RebuildRequested() const
+{
+    WaitForRebuildDecisionReadback();
+    return (*_rebuildDecisionPtr != 0);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Waits on the fence after the last copy of the decision, if there is one, and then gets rid 
+    of it so that the next call doesn't wait on it again.
+
+    Note: Thanks to this article for the idea for the wait sync loop (same as 
+    PersistentAtomicCounterBuffer).
+    https://www.codeproject.com/Articles/872417/Persistent-Mapped-Buffers-in-OpenGL
+Parameters: None
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+void BvhRefitSsbo::WaitForRebuildDecisionReadback() const
+{
+    if (_rebuildDecisionFence == 0)
+    {
+        return;
+    }
+
+    GLsync fence = static_cast<GLsync>(_rebuildDecisionFence);
+    GLenum waitReturn = GL_UNSIGNALED;
+    while (waitReturn != GL_ALREADY_SIGNALED && waitReturn != GL_CONDITION_SATISFIED)
+    {
+        waitReturn = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1);
+    }
+    glDeleteSync(fence);
+    _rebuildDecisionFence = 0;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    The BvhRefitState is the first thing in the buffer.  Reading it back will stall the 
+    pipeline until PlanBvhRefit.comp is done with it.
+Parameters: None
+Returns:    
+    See Description.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int BvhRefitSsbo::StateByteOffset() const
+{
+    return 0;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    How many bytes to read back for a BvhRefitState.
+Parameters: None
+Returns:    
+    See Description.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int BvhRefitSsbo::StateSizeBytes() const
+{
+    return sizeof(BvhRefitState);
+}
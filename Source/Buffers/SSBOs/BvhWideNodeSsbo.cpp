@@ -0,0 +1,38 @@
+#include "Include/Buffers/SSBOs/BvhWideNodeSsbo.h"
+
+#include "ThirdParty/glload/include/glload/gl_4_4.h"
+#include "Shaders/ShaderHeaders/SsboBufferBindings.comp"
+
+#include "Include/Buffers/BvhWideNode.h"
+
+#include <algorithm>
+#include <vector>
+
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Initializes base class, then allocates space for the SSBO.
+
+    Note: A binary tree with N leaves has N-1 internal nodes, and each one gets a wide node.  
+    There is always room for at least 1 so that the buffer is never empty.
+Parameters: 
+    numParticles        The most particles that there can be in the tree.
+    maxParticlesPerLeaf The compute controller's BVH_MAX_PARTICLES_PER_LEAF (see 
+                        BvhLeaves.comp).
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+BvhWideNodeSsbo::BvhWideNodeSsbo(unsigned int numParticles, unsigned int maxParticlesPerLeaf) :
+    SsboBase()  // generate buffers
+{
+    unsigned int numLeaves = (numParticles + maxParticlesPerLeaf - 1) / maxParticlesPerLeaf;
+    std::vector<BvhWideNode> v(std::max(numLeaves, 2u) - 1);
+
+    // now bind this new buffer to the dedicated buffer binding location
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BVH_WIDE_NODE_BUFFER_BINDING, _bufferId);
+
+    // and fill it with new data
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferId);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, v.size() * sizeof(BvhWideNode), v.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
@@ -0,0 +1,60 @@
+#include "Include/Buffers/SSBOs/ParticleReorderSsbo.h"
+
+#include "ThirdParty/glload/include/glload/gl_4_4.h"
+#include "Shaders/ShaderHeaders/SsboBufferBindings.comp"
+#include "Shaders/Compute/ParticleCollisions/ParticleReorderLayout.comp"
+
+#include <vector>
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Initializes base class, then allocates space for the SSBO.
+
+    Note: Everything starts at 0.  PlanParticleReorder.comp writes the dispatch command before 
+    anything uses it.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+ParticleReorderSsbo::ParticleReorderSsbo() :
+    SsboBase()  // generate buffers
+{
+    std::vector<unsigned int> v(PARTICLE_REORDER_NUM_COUNTERS + PARTICLE_REORDER_UINTS_PER_DISPATCH_COMMAND);
+
+    // now bind this new buffer to the dedicated buffer binding location
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLE_REORDER_BUFFER_BINDING, _bufferId);
+
+    // and fill it with new data
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferId);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, v.size() * sizeof(unsigned int), v.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    glDispatchComputeIndirect(...) takes a byte offset into the GL_DISPATCH_INDIRECT_BUFFER.  
+    This is where PlanParticleReorder.comp writes its command.
+Parameters: None
+Returns:    
+    See Description.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int ParticleReorderSsbo::DispatchCommandByteOffset() const
+{
+    return PARTICLE_REORDER_DISPATCH_COMMAND_FIRST_UINT * sizeof(unsigned int);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    For profiling.  The counters are the first PARTICLE_REORDER_NUM_COUNTERS uints, in the 
+    order that they are declared in ParticleReorderBuffer.comp.  Reading them back will stall 
+    the pipeline, so don't do it otherwise.
+Parameters: None
+Returns:    
+    See Description.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int ParticleReorderSsbo::CountersByteOffset() const
+{
+    return 0;
+}
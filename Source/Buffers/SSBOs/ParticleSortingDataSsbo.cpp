@@ -12,25 +12,43 @@
 Description:
     Initializes base class, then gives derived class members initial values and allocates space 
     for the SSBO.
+
+    Note: GenerateSortingData.comp finds each particle through last frame's sorted data in the 
+    first half (see LeafToParticleIndex.comp), so before the first sort it has to point every 
+    item at its own particle.
 Parameters: 
     numParticles    Self-explanatory.
+    keyWidth        Decides whether the items are ParticleSortingData or 
+                    ParticleSortingData64.  Must match the SortingKey*.comp file that the 
+                    shaders that use this buffer were assembled with.
 Returns:    None
 Creator:    John Cox, 5/2017
 ------------------------------------------------------------------------------------------------*/
-ParticleSortingDataSsbo::ParticleSortingDataSsbo(unsigned int numParticles) :
+ParticleSortingDataSsbo::ParticleSortingDataSsbo(unsigned int numParticles, SortingKeyWidth keyWidth) :
     SsboBase(),  // generate buffers
-    _numItems(numParticles)
+    _numItems(numParticles),
+    _keyWidth(keyWidth)
 {
     // allocate enough space for these structures to be moved from a "read" section to a 
     // "write" section and back again
+    // Note: The two item types only differ in the key, so fill out whichever one it is and 
+    // upload its bytes.
     std::vector<ParticleSortingData> v(numParticles * 2);
+    std::vector<ParticleSortingData64> v64(numParticles * 2);
+    for (unsigned int particleIndex = 0; particleIndex < numParticles; particleIndex++)
+    {
+        v[particleIndex]._preSortedParticleIndex = static_cast<int>(particleIndex);
+        v64[particleIndex]._preSortedParticleIndex = static_cast<int>(particleIndex);
+    }
+    const void *initialData = (keyWidth == SortingKeyWidth::KEY_64_BIT) ? 
+        static_cast<const void *>(v64.data()) : static_cast<const void *>(v.data());
 
     // now bind this new buffer to the dedicated buffer binding location
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLE_SORTING_DATA_BUFFER_BINDING, _bufferId);
 
     // and fill it with new data
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferId);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, v.size() * sizeof(ParticleSortingData), v.data(), GL_DYNAMIC_DRAW);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, numParticles * 2 * ItemSizeBytes(), initialData, GL_DYNAMIC_DRAW);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 }
 
@@ -64,3 +82,32 @@ unsigned int ParticleSortingDataSsbo::NumItems() const
     return _numItems;
 }
 
+/*------------------------------------------------------------------------------------------------
+Description:
+    A simple getter for the value that was passed in on creation.
+Parameters: None
+Returns:    
+    See Description.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+SortingKeyWidth ParticleSortingDataSsbo::KeyWidth() const
+{
+    return _keyWidth;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    The size of one item in the buffer.  Anybody that reads the buffer back needs this.
+Parameters: None
+Returns:    
+    Either sizeof(ParticleSortingData) or sizeof(ParticleSortingData64).
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int ParticleSortingDataSsbo::ItemSizeBytes() const
+{
+    if (_keyWidth == SortingKeyWidth::KEY_64_BIT)
+    {
+        return sizeof(ParticleSortingData64);
+    }
+    return sizeof(ParticleSortingData);
+}
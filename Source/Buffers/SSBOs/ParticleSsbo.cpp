@@ -73,9 +73,14 @@ Description:
     Initializes base class, then gives derived class members initial values and allocates space 
     for the SSBO.
 
-    Allocates space for 2x the number of particles.  The second half is used during particle 
-    sorting so that particles can be copied to the second half, then copied back to their sorted 
-    positions in the first half.
+    Allocates space for 2x the number of particles.  One half is the front and the other is 
+    where particle sorting puts the sorted particles (see SortParticles.comp), and then they 
+    swap.  The first half starts as the front.
+
+    The halves are bound with glBindBufferRange(...), and the offset has to be a multiple of 
+    GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, so each half is padded with a few particles that 
+    nobody uses.  The padding is a whole number of particles so that rendering can still find 
+    the front half with a vertex index.
 
     Also generates random initial particle positions and velocities, but all particles are still 
     default inactive.  See description in InitializeWithRandomData(...).
@@ -88,7 +93,10 @@ Returns:    None
 Creator:    John Cox, 4/2017
 ------------------------------------------------------------------------------------------------*/
 ParticleSsbo::ParticleSsbo(unsigned int numParticles) :
-    SsboBase()  // generate buffers
+    SsboBase(),  // generate buffers
+    _numParticles(numParticles),
+    _numParticlesPerHalf(numParticles),
+    _frontHalfIndex(0)
 {
     std::vector<Particle> v(numParticles);
     InitializeWithRandomData(v);
@@ -98,19 +106,30 @@ ParticleSsbo::ParticleSsbo(unsigned int numParticles) :
     // Note: This can't be set in the class initializer list.  The class initializer list is for 
     // members of this class only (ParticleSsbo), not for base class members. 
     _numVertices = numParticles;
-    _numParticles = numParticles;
 
-    // the second half has no need for initial data
-    v.resize(numParticles * 2);
+    // pad each half out to the binding offset alignment
+    // Note: The alignment is a power of 2 no larger than 256, so this only adds a handful of 
+    // particles.
+    GLint offsetAlignment = 0;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+    while ((_numParticlesPerHalf * sizeof(Particle)) % offsetAlignment != 0)
+    {
+        _numParticlesPerHalf++;
+    }
 
-    // now bind this new buffer to the dedicated buffer binding location
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLE_BUFFER_BINDING, _bufferId);
+    // the padding and the back half have no need for initial data
+    v.resize(_numParticlesPerHalf * 2);
 
     // and fill it with the new data
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferId);
     glBufferData(GL_SHADER_STORAGE_BUFFER, v.size() * sizeof(Particle), v.data(), GL_DYNAMIC_DRAW);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 
+    // now bind the halves to their dedicated buffer binding locations
+    // Note: Unlike glBindBufferBase(...), glBindBufferRange(...) needs the buffer's storage to 
+    // exist first.
+    BindHalves();
+
     // set up the VAO
     ConfigureRender();
 }
@@ -145,6 +164,67 @@ unsigned int ParticleSsbo::NumParticles() const
     return _numParticles;
 }
 
+/*------------------------------------------------------------------------------------------------
+Description:
+    Called after SortParticles.comp has gathered the particles into the back half.  The back 
+    half becomes the front and vice versa, and the bindings are updated to match.
+
+    Note: This only changes bindings.  No particles are moved.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+void ParticleSsbo::SwapHalves()
+{
+    _frontHalfIndex = 1 - _frontHalfIndex;
+    BindHalves();
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    For reading the particles back.  Whatever is in the back half is left over from the last 
+    sort.
+Parameters: None
+Returns:    
+    The byte offset of the first particle in the front half.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int ParticleSsbo::FrontHalfByteOffset() const
+{
+    return FrontHalfFirstVertex() * sizeof(Particle);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    The VAO's vertex attributes start at the beginning of the buffer, so rendering skips to the 
+    front half by starting at this vertex in glDrawArrays(...).
+Parameters: None
+Returns:    
+    The index of the first particle in the front half.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int ParticleSsbo::FrontHalfFirstVertex() const
+{
+    return _frontHalfIndex * _numParticlesPerHalf;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Binds the front half to PARTICLE_BUFFER_BINDING (see ParticleBuffer.comp) and the back half 
+    to PARTICLE_BACK_BUFFER_BINDING (see ParticleBackBuffer.comp).
+Parameters: None
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+void ParticleSsbo::BindHalves() const
+{
+    unsigned int halfSizeBytes = _numParticlesPerHalf * sizeof(Particle);
+    unsigned int frontOffsetBytes = _frontHalfIndex * halfSizeBytes;
+    unsigned int backOffsetBytes = (1 - _frontHalfIndex) * halfSizeBytes;
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, PARTICLE_BUFFER_BINDING, _bufferId, frontOffsetBytes, halfSizeBytes);
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, PARTICLE_BACK_BUFFER_BINDING, _bufferId, backOffsetBytes, halfSizeBytes);
+}
+
 /*------------------------------------------------------------------------------------------------
 Description:
     Sets up the vertex attribute pointers for this SSBO's VAO.
@@ -0,0 +1,55 @@
+#include "Include/Buffers/SSBOs/PrefixScanLookBackSsbo.h"
+
+#include "ThirdParty/glload/include/glload/gl_4_4.h"
+
+#include "Shaders/ShaderHeaders/ComputeShaderWorkGroupSizes.comp"
+#include "Shaders/ShaderHeaders/SsboBufferBindings.comp"
+
+#include <vector>
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Initializes the base class, then allocates space for the SSBO.
+
+    Each work group in the prefix scan needs one status flag, and there are two sets of them 
+    (see PrefixScanLookBackBuffer.comp), so the number of status flags is a function of the 
+    largest prefix scan that will be run.  The ticket counter and the current status flag set 
+    start at 0, and so do the status flags (0 is "not ready").
+Parameters: 
+    numDataEntries  The largest number of items that will be prefix scanned.  Expected to be 
+                    PrefixSumSsbo::NumDataEntries().
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+PrefixScanLookBackSsbo::PrefixScanLookBackSsbo(unsigned int numDataEntries) :
+    SsboBase(),  // generate buffers
+    _numStatusFlagsPerSet(0)
+{
+    _numStatusFlagsPerSet = numDataEntries / PREFIX_SCAN_ITEMS_PER_WORK_GROUP;
+    _numStatusFlagsPerSet += (numDataEntries % PREFIX_SCAN_ITEMS_PER_WORK_GROUP == 0) ? 0 : 1;
+
+    // the std::vector<...>(...) constructor will set everything to 0
+    // Note: The +2 is for the ticket counter and the current status flag set.
+    std::vector<unsigned int> v(2 + (_numStatusFlagsPerSet * 2));
+
+    // now bind this new buffer to the dedicated buffer binding location
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PREFIX_SCAN_LOOK_BACK_BUFFER_BINDING, _bufferId);
+
+    // and fill it with 0s
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferId);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, v.size() * sizeof(unsigned int), v.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Returns the maximum number of work groups that a single prefix scan can use.
+Parameters: None
+Returns:    
+    See Description.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int PrefixScanLookBackSsbo::NumStatusFlagsPerSet() const
+{
+    return _numStatusFlagsPerSet;
+}
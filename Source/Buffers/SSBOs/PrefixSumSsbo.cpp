@@ -107,14 +107,12 @@ Description:
     Initializes the base class, then initializes derived class members and allocates space for 
     the SSBO.
 Parameters: 
-    numDataEntries  How many items the user wants to have.  The only restriction is that it be 
-    less than (due to restrictions in the PrefixScan) 1024x1024 = 1,048,576.
+    numDataEntries  How many items the user wants to have.  
 Returns:    None
 Creator:    John Cox, 3/2017
 ------------------------------------------------------------------------------------------------*/
 PrefixSumSsbo::PrefixSumSsbo(unsigned int numDataEntries) :
     SsboBase(),  // generate buffers
-    _numPerGroupPrefixSums(0),
     _numDataEntries(0)
 {
     // see explanation essay at the top of the file
@@ -126,22 +124,12 @@ PrefixSumSsbo::PrefixSumSsbo(unsigned int numDataEntries) :
     _numDataEntries += (numDataEntries % PREFIX_SCAN_ITEMS_PER_WORK_GROUP == 0) ? 0 : 1;
     _numDataEntries *= PREFIX_SCAN_ITEMS_PER_WORK_GROUP;
 
-    // use one work group's worth of data for the per-work-group prefix sums
-    // Note: The prefix scan of the "per work group sums" is a necessary step in preparation for 
-    // Radix Sort, so the individual work groups' prefix sums are rather useless without the 
-    // results of each work group being tallied and one more chunk of data is required.  This 
-    // data will also have the prefix scan run on it, so it must be the size of one work group's 
-    // worth of data.  
-    // Also Note: If the original data set is larger than 
-    // PREFIX_SCAN_ITEMS_PER_WORK_GROUP * PREFIX_SCAN_ITEMS_PER_WORK_GROUP 
-    // (number of work group sums * amount of data that each work group operates on), then 
-    // PREFIX_SCAN_ITEMS_PER_WORK_GROUP will need to be increased.
-    _numPerGroupPrefixSums = PREFIX_SCAN_ITEMS_PER_WORK_GROUP;
-
     // the std::vector<...>(...) constructor will set everything to 0
     // Note: The +1 is because of a single uint in the buffer, totalNumberOfOnes.  See 
     // explanation in PrefixScanBuffer.comp.
-    std::vector<unsigned int> v(_numPerGroupPrefixSums + 1 + _numDataEntries);
+    // Also Note: There used to be a work group's worth of "per work group sums" in here too, 
+    // but the prefix scan now does that in a single pass with PrefixScanLookBackSsbo.
+    std::vector<unsigned int> v(1 + _numDataEntries);
 
     // now bind this new buffer to the dedicated buffer binding location
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PREFIX_SCAN_BUFFER_BINDING, _bufferId);
@@ -194,6 +182,6 @@ Creator:    John Cox, 3/2017
 ------------------------------------------------------------------------------------------------*/
 unsigned int PrefixSumSsbo::TotalBufferEntries() const
 {
-    return _numDataEntries + 1 + _numPerGroupPrefixSums;
+    return _numDataEntries + 1;
 }
 
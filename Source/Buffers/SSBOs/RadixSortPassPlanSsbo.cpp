@@ -0,0 +1,99 @@
+#include "Include/Buffers/SSBOs/RadixSortPassPlanSsbo.h"
+
+#include "ThirdParty/glload/include/glload/gl_4_4.h"
+#include "Shaders/ShaderHeaders/SsboBufferBindings.comp"
+#include "Shaders/Compute/ParticleCollisions/RadixSortPassPlanLayout.comp"
+
+#include <vector>
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Initializes base class, then allocates space for the SSBO.
+
+    Note: The AND mask starts with all bits set and the OR mask with none so that the first 
+    GenerateSortingData.comp has something to AND and OR into.  After that, 
+    PlanRadixSortPasses.comp resets them every frame.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+RadixSortPassPlanSsbo::RadixSortPassPlanSsbo() :
+    SsboBase()  // generate buffers
+{
+    unsigned int numDispatchCommandUints = 
+        RADIX_SORT_MAX_NUM_PASSES * RADIX_SORT_NUM_DISPATCH_SLOTS * RADIX_SORT_UINTS_PER_DISPATCH_COMMAND;
+    std::vector<unsigned int> v(RADIX_SORT_PASS_PLAN_HEADER_UINTS + RADIX_SORT_MAX_NUM_PASSES + numDispatchCommandUints);
+    v[0] = 0;           // sortingDataOrMask
+    v[1] = 0xffffffff;  // sortingDataAndMask
+    v[2] = 0;           // sortingDataOrMaskHigh
+    v[3] = 0xffffffff;  // sortingDataAndMaskHigh
+
+    // now bind this new buffer to the dedicated buffer binding location
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, RADIX_SORT_PASS_PLAN_BUFFER_BINDING, _bufferId);
+
+    // and fill it with new data
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferId);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, v.size() * sizeof(unsigned int), v.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    glDispatchComputeIndirect(...) takes a byte offset into the GL_DISPATCH_INDIRECT_BUFFER.  
+    This calculates where the given pass's dispatch command is.
+Parameters: 
+    passNumber      0 - (RADIX_SORT_MAX_NUM_PASSES - 1)
+    dispatchSlot    One of the RADIX_SORT_DISPATCH_* values in RadixSortPassPlanLayout.comp.
+Returns:    
+    See Description.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int RadixSortPassPlanSsbo::DispatchCommandByteOffset(unsigned int passNumber, 
+    unsigned int dispatchSlot) const
+{
+    unsigned int commandIndex = (passNumber * RADIX_SORT_NUM_DISPATCH_SLOTS) + dispatchSlot;
+    unsigned int uintOffset = RADIX_SORT_PASS_PLAN_HEADER_UINTS + RADIX_SORT_MAX_NUM_PASSES + 
+        (commandIndex * RADIX_SORT_UINTS_PER_DISPATCH_COMMAND);
+    return uintOffset * sizeof(unsigned int);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    For profiling.  Reading this value back will stall the pipeline, so don't do it otherwise.
+Parameters: None
+Returns:    
+    The byte offset of RadixSortPassPlanBuffer::numActiveRadixSortPasses.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int RadixSortPassPlanSsbo::NumActivePassesByteOffset() const
+{
+    return RADIX_SORT_NUM_ACTIVE_PASSES_UINT * sizeof(unsigned int);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    For profiling.  The counters are numIncrementalSorts, numIncrementalSortsOverThreshold, and 
+    numIncrementalSortFallbacks, in that order, after numUnsortedSortingDataNeighbors.  Reading 
+    them back will stall the pipeline, so don't do it otherwise.
+Parameters: None
+Returns:    
+    The byte offset of RadixSortPassPlanBuffer::numUnsortedSortingDataNeighbors.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int RadixSortPassPlanSsbo::IncrementalSortCountersByteOffset() const
+{
+    return INCREMENTAL_SORT_COUNTERS_FIRST_UINT * sizeof(unsigned int);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Like DispatchCommandByteOffset(...), but for the incremental sort's one dispatch command.
+Parameters: None
+Returns:    
+    The byte offset of RadixSortPassPlanBuffer::IncrementalSortDispatchCommand.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int RadixSortPassPlanSsbo::IncrementalSortDispatchCommandByteOffset() const
+{
+    return INCREMENTAL_SORT_DISPATCH_COMMAND_FIRST_UINT * sizeof(unsigned int);
+}
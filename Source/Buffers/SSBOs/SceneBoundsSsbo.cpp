@@ -0,0 +1,65 @@
+#include "Include/Buffers/SSBOs/SceneBoundsSsbo.h"
+
+#include "ThirdParty/glload/include/glload/gl_4_4.h"
+#include "Shaders/ShaderHeaders/SsboBufferBindings.comp"
+#include "Shaders/Compute/ParticleRegionBoundaries.comp"
+#include "Include/Buffers/SceneBounds.h"
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    A SceneBounds that covers the whole fixed particle region.
+Parameters: None
+Returns:    
+    See Description.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+static SceneBounds ParticleRegionSceneBounds()
+{
+    glm::vec4 regionMin(PARTICLE_REGION_MIN_X, PARTICLE_REGION_MIN_Y, PARTICLE_REGION_MIN_Z, 0.0f);
+    glm::vec4 regionInverseRange(PARTICLE_REGION_INVERSE_RANGE_X, PARTICLE_REGION_INVERSE_RANGE_Y, PARTICLE_REGION_INVERSE_RANGE_Z, 0.0f);
+    return SceneBounds(regionMin, regionInverseRange);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Initializes base class, then allocates space for the SSBO.
+
+    Note: The bounds start out as the fixed particle region, so the Morton Codes are the same 
+    as they always were until FinalizeSceneBounds.comp runs for the first time.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+SceneBoundsSsbo::SceneBoundsSsbo() :
+    SsboBase()  // generate buffers
+{
+    SceneBounds initialBounds = ParticleRegionSceneBounds();
+
+    // now bind this new buffer to the dedicated buffer binding location
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SCENE_BOUNDS_BUFFER_BINDING, _bufferId);
+
+    // and fill it with new data
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferId);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(SceneBounds), &initialBounds, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Puts the bounds back to the fixed particle region and resets the accumulators.  For when 
+    the dynamic bounds are turned off.  Otherwise the Morton Codes would keep being normalized 
+    against whatever the last frame's bounds were.
+
+    Note: This is a glBufferSubData(...), so it is in line with the GPU commands around it.  
+    Nothing has to wait.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+void SceneBoundsSsbo::ResetToParticleRegion() const
+{
+    SceneBounds bounds = ParticleRegionSceneBounds();
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bufferId);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(SceneBounds), &bounds);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
@@ -0,0 +1,366 @@
+#include "Include/BvhQuality.h"
+
+#include <algorithm>
+
+// the relative costs of looking at an internal node and at a leaf
+// Note: These are the values from Karras and Aila, "Fast Parallel Construction of 
+// High-Quality Bounding Volume Hierarchies" (2013).  Only the ratio matters.
+static const float SAH_COST_INTERNAL_NODE = 1.2f;
+static const float SAH_COST_LEAF = 1.0f;
+
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    The 2D version of a bounding box's surface area.  A box's area says how likely a random 
+    point is to land in it, but the chance of a random line or box running into it goes with 
+    its perimeter.  Only the ratio to the root's is used, so half of it is enough.
+Parameters: 
+    box     Self-explanatory.
+Returns:    
+    Width + height.  0 for an empty or inverted box.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+static float HalfPerimeter(const BoundingBox &box)
+{
+    float width = std::max(box._right - box._left, 0.0f);
+    float height = std::max(box._top - box._bottom, 0.0f);
+    return width + height;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    The CPU version of BoundingBoxesOverlap(...) in DetectCollisions.comp.  Touching edges 
+    don't count.
+Parameters: 
+    a   Self-explanatory.
+    b   Self-explanatory.
+Returns:    
+    True if they overlap, otherwise false.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+static bool BoundingBoxesOverlap(const BoundingBox &a, const BoundingBox &b)
+{
+    float overlapBoxLeft = std::max(a._left, b._left);
+    float overlapBoxRight = std::min(a._right, b._right);
+    float overlapBoxBottom = std::max(a._bottom, b._bottom);
+    float overlapBoxTop = std::min(a._top, b._top);
+    return ((overlapBoxRight - overlapBoxLeft) > 0.0f) && ((overlapBoxTop - overlapBoxBottom) > 0.0f);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Leaf N has the particles [N * maxParticlesPerLeaf, (N + 1) * maxParticlesPerLeaf), except 
+    that the last leaf may have fewer (see BvhLeaves.comp).
+Parameters: 
+    leafIndex           Self-explanatory.
+    numParticles        How many particles are in the tree (the number of active particles).
+    maxParticlesPerLeaf Self-explanatory.
+Returns:    
+    How many particles are in the leaf.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+static unsigned int NumParticlesInLeaf(unsigned int leafIndex, unsigned int numParticles, 
+    unsigned int maxParticlesPerLeaf)
+{
+    unsigned int firstParticle = leafIndex * maxParticlesPerLeaf;
+    return (firstParticle >= numParticles) ? 0 : 
+        std::min(maxParticlesPerLeaf, numParticles - firstParticle);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Adds up every node's half perimeter (see HalfPerimeter(...)) times what it costs to look 
+    at it, then divides by the root's half perimeter.  That is the expected cost of a random 
+    query that is already known to be inside the root.
+
+    Note: The tree is walked from the root instead of going through the buffer in order, 
+    because the buffer has room for more nodes than the tree is using.
+
+    Also Note: Looking into a leaf means checking each of its particles, so a leaf costs 
+    SAH_COST_LEAF per particle.  That is what keeps the cost from always going down as the 
+    leaves get bigger.
+Parameters: 
+    nodes               The whole BVH, as read back from the BvhNodeSsbo.
+    rootIndex           Self-explanatory.
+    numParticles        How many particles are in the tree (the number of active particles).
+    maxParticlesPerLeaf See BvhLeaves.comp.
+Returns:    
+    The SAH cost.  0 for an empty tree or one whose root has no size.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+float BvhSahCost(const std::vector<BvhNode> &nodes, int rootIndex, unsigned int numParticles, 
+    unsigned int maxParticlesPerLeaf)
+{
+    if (rootIndex < 0 || rootIndex >= static_cast<int>(nodes.size()))
+    {
+        return 0.0f;
+    }
+
+    float rootHalfPerimeter = HalfPerimeter(nodes[rootIndex]._boundingBox);
+    if (rootHalfPerimeter <= 0.0f)
+    {
+        return 0.0f;
+    }
+
+    // double so that a million small terms don't get lost
+    double cost = 0.0;
+    std::vector<int> nodeStack;
+    nodeStack.push_back(rootIndex);
+    while (!nodeStack.empty())
+    {
+        int nodeIndex = nodeStack.back();
+        const BvhNode &node = nodes[nodeIndex];
+        nodeStack.pop_back();
+
+        // the leaves are the nodes before the root (see BvhNodeSsbo)
+        if (nodeIndex < rootIndex)
+        {
+            unsigned int numParticlesInLeaf = NumParticlesInLeaf(nodeIndex, numParticles, maxParticlesPerLeaf);
+            cost += SAH_COST_LEAF * numParticlesInLeaf * HalfPerimeter(node._boundingBox);
+        }
+        else
+        {
+            cost += SAH_COST_INTERNAL_NODE * HalfPerimeter(node._boundingBox);
+            nodeStack.push_back(BvhNode::ChildIndex(node._leftChild));
+            nodeStack.push_back(BvhNode::ChildIndex(node._rightChild));
+        }
+    }
+
+    return static_cast<float>(cost / rootHalfPerimeter);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Runs the same traversal as DetectCollisions.comp for each of the leaves in use and 
+    counts how many internal nodes it goes through, the root included.  Every internal node 
+    that is gone through but doesn't lead to an overlapping leaf is a false overlap, and that 
+    is where a badly shaped tree loses its time.
+
+    Note: The shader gives up when its stack is full (64 entries).  This doesn't, so a tree 
+    that deep would count more here than the shader actually looks at.
+
+    Also Note: The shader runs a traversal for every particle, not every leaf, and the query 
+    is the particle's own box (see DetectCollisions.comp).  The particles' boxes aren't in the 
+    tree, so each leaf's traversal is counted once for every particle in it.  A particle's box 
+    is inside its leaf's, so with more than 1 particle per leaf this is an upper bound.
+Parameters: 
+    nodes               The whole BVH, as read back from the BvhNodeSsbo.
+    rootIndex           Self-explanatory.
+    numParticles        How many particles are in the tree (the number of active particles).
+    maxParticlesPerLeaf See BvhLeaves.comp.
+Returns:    
+    The total over all particles.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+unsigned long long CountBvhNodesVisited(const std::vector<BvhNode> &nodes, int rootIndex, 
+    unsigned int numParticles, unsigned int maxParticlesPerLeaf)
+{
+    // a tree of 0 or 1 leaves has nothing to look through (see DetectCollisions.comp)
+    unsigned int numLeaves = (numParticles + maxParticlesPerLeaf - 1) / maxParticlesPerLeaf;
+    if (numLeaves < 2)
+    {
+        return 0;
+    }
+
+    unsigned long long numNodesVisited = 0;
+    std::vector<int> nodeStack;
+    for (unsigned int leafIndex = 0; leafIndex < numLeaves; leafIndex++)
+    {
+        const BoundingBox &leafBox = nodes[leafIndex]._boundingBox;
+        unsigned int numParticlesInLeaf = NumParticlesInLeaf(leafIndex, numParticles, maxParticlesPerLeaf);
+        nodeStack.clear();
+        nodeStack.push_back(rootIndex);
+        while (!nodeStack.empty())
+        {
+            const BvhNode &node = nodes[nodeStack.back()];
+            nodeStack.pop_back();
+            numNodesVisited += numParticlesInLeaf;
+
+            // the node has copies of its children's boxes (see BvhNodeBuffer.comp)
+            if (!BvhNode::ChildIsNull(node._leftChild) && !BvhNode::ChildIsLeaf(node._leftChild) && 
+                BoundingBoxesOverlap(leafBox, node._leftChildBoundingBox))
+            {
+                nodeStack.push_back(BvhNode::ChildIndex(node._leftChild));
+            }
+            if (!BvhNode::ChildIsNull(node._rightChild) && !BvhNode::ChildIsLeaf(node._rightChild) && 
+                BoundingBoxesOverlap(leafBox, node._rightChildBoundingBox))
+            {
+                nodeStack.push_back(BvhNode::ChildIndex(node._rightChild));
+            }
+        }
+    }
+
+    return numNodesVisited;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Like CountBvhNodesVisited(...), but for the traversal through the 4-wide BVH (see 
+    TraverseWideBvh(...) in DetectCollisions.comp).  The wide nodes aren't read back.  A wide 
+    node's children are its binary node's grandchildren, or the child itself if that is a 
+    leaf (see CollapseBvhToWideNodes.comp), so the same thing is done here with the binary 
+    nodes.
+
+    Note: The wide traversal checks the same boxes, just 4 at a time, so this is about half of 
+    CountBvhNodesVisited(...).  The boxes checked don't go down.  The node reads do.
+Parameters: 
+    nodes               The whole BVH, as read back from the BvhNodeSsbo.
+    rootIndex           Self-explanatory.
+    numParticles        How many particles are in the tree (the number of active particles).
+    maxParticlesPerLeaf See BvhLeaves.comp.
+Returns:    
+    The total over all particles.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+unsigned long long CountBvhWideNodesVisited(const std::vector<BvhNode> &nodes, int rootIndex, 
+    unsigned int numParticles, unsigned int maxParticlesPerLeaf)
+{
+    // a tree of 0 or 1 leaves has nothing to look through (see DetectCollisions.comp)
+    unsigned int numLeaves = (numParticles + maxParticlesPerLeaf - 1) / maxParticlesPerLeaf;
+    if (numLeaves < 2)
+    {
+        return 0;
+    }
+
+    unsigned long long numNodesVisited = 0;
+    std::vector<int> nodeStack;
+    std::vector<unsigned int> wideChildren;
+    std::vector<BoundingBox> wideChildBoundingBoxes;
+    for (unsigned int leafIndex = 0; leafIndex < numLeaves; leafIndex++)
+    {
+        const BoundingBox &leafBox = nodes[leafIndex]._boundingBox;
+        unsigned int numParticlesInLeaf = NumParticlesInLeaf(leafIndex, numParticles, maxParticlesPerLeaf);
+        nodeStack.clear();
+        nodeStack.push_back(rootIndex);
+        while (!nodeStack.empty())
+        {
+            const BvhNode &node = nodes[nodeStack.back()];
+            nodeStack.pop_back();
+            numNodesVisited += numParticlesInLeaf;
+
+            // the wide node's children
+            wideChildren.clear();
+            wideChildBoundingBoxes.clear();
+            unsigned int children[2] = { node._leftChild, node._rightChild };
+            const BoundingBox *childBoundingBoxes[2] = { &node._leftChildBoundingBox, &node._rightChildBoundingBox };
+            for (int childCount = 0; childCount < 2; childCount++)
+            {
+                unsigned int child = children[childCount];
+                if (BvhNode::ChildIsLeaf(child) || BvhNode::ChildIsNull(child))
+                {
+                    wideChildren.push_back(child);
+                    wideChildBoundingBoxes.push_back(*childBoundingBoxes[childCount]);
+                }
+                else
+                {
+                    const BvhNode &childNode = nodes[BvhNode::ChildIndex(child)];
+                    wideChildren.push_back(childNode._leftChild);
+                    wideChildBoundingBoxes.push_back(childNode._leftChildBoundingBox);
+                    wideChildren.push_back(childNode._rightChild);
+                    wideChildBoundingBoxes.push_back(childNode._rightChildBoundingBox);
+                }
+            }
+
+            for (size_t wideChildCount = 0; wideChildCount < wideChildren.size(); wideChildCount++)
+            {
+                unsigned int wideChild = wideChildren[wideChildCount];
+                if (!BvhNode::ChildIsNull(wideChild) && !BvhNode::ChildIsLeaf(wideChild) && 
+                    BoundingBoxesOverlap(leafBox, wideChildBoundingBoxes[wideChildCount]))
+                {
+                    nodeStack.push_back(BvhNode::ChildIndex(wideChild));
+                }
+            }
+        }
+    }
+
+    return numNodesVisited;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Checks that every node in use has a reciprocated parent-child relationship: every node 
+    except the root has a parent, and that parent names it as a child exactly once.  The 
+    parent's flags and its copy of the child's box (see BvhNodeBuffer.comp) have to agree with 
+    the child too, or DetectCollisions.comp would go through a box that isn't there anymore.
+
+    Note: Only the active particles are in the tree (see BvhLeaves.comp).  The leaves are 
+    [0, leaves in use) and the internal nodes are [root, root + leaves in use - 1).  The rest 
+    of the buffers are left over from whenever they were last used, so they aren't checked.
+Parameters: 
+    nodes               The whole BVH, as read back from the BvhNodeSsbo.
+    buildData           The parents, as read back from the BvhNodeBuildDataSsbo.
+    rootIndex           Self-explanatory.
+    numParticles        How many particles are in the tree (the number of active particles).
+    maxParticlesPerLeaf See BvhLeaves.comp.
+Returns:    
+    How many nodes are wrong.  0 for a valid tree.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int CountInvalidBvhNodes(const std::vector<BvhNode> &nodes, 
+    const std::vector<BvhNodeBuildData> &buildData, int rootIndex, unsigned int numParticles, 
+    unsigned int maxParticlesPerLeaf)
+{
+    // a tree of 0 or 1 leaves has no internal nodes to check
+    unsigned int numLeaves = (numParticles + maxParticlesPerLeaf - 1) / maxParticlesPerLeaf;
+    if (numLeaves < 2)
+    {
+        return 0;
+    }
+
+    std::vector<int> nodesInTree;
+    for (unsigned int leafIndex = 0; leafIndex < numLeaves; leafIndex++)
+    {
+        nodesInTree.push_back(static_cast<int>(leafIndex));
+    }
+    for (unsigned int internalCount = 0; internalCount < numLeaves - 1; internalCount++)
+    {
+        nodesInTree.push_back(rootIndex + static_cast<int>(internalCount));
+    }
+
+    unsigned int numInvalidNodes = 0;
+    for (int nodeIndex : nodesInTree)
+    {
+        int parentIndex = buildData[nodeIndex]._parentIndex;
+        if (parentIndex == -1)
+        {
+            // only the root has no parent
+            if (nodeIndex != rootIndex)
+            {
+                numInvalidNodes++;
+            }
+            continue;
+        }
+        if (nodeIndex == rootIndex || parentIndex < rootIndex || 
+            parentIndex >= static_cast<int>(nodes.size()))
+        {
+            // the root has a parent, or the parent is not an internal node
+            numInvalidNodes++;
+            continue;
+        }
+
+        const BvhNode &parentNode = nodes[parentIndex];
+        bool isLeftChild = (nodeIndex == BvhNode::ChildIndex(parentNode._leftChild));
+        bool isRightChild = (nodeIndex == BvhNode::ChildIndex(parentNode._rightChild));
+        if (isLeftChild == isRightChild)
+        {
+            // parent-child relationship not reciprocated, or the parent has it twice
+            numInvalidNodes++;
+            continue;
+        }
+
+        unsigned int child = isLeftChild ? parentNode._leftChild : parentNode._rightChild;
+        const BoundingBox &childBb = isLeftChild ? 
+            parentNode._leftChildBoundingBox : parentNode._rightChildBoundingBox;
+        const BoundingBox &thisBb = nodes[nodeIndex]._boundingBox;
+        if ((BvhNode::ChildIsLeaf(child) != (nodeIndex < rootIndex)) || 
+            (BvhNode::ChildIsNull(child) != (thisBb._left > thisBb._right)) || 
+            (childBb._left != thisBb._left) || (childBb._right != thisBb._right) || 
+            (childBb._bottom != thisBb._bottom) || (childBb._top != thisBb._top))
+        {
+            // parent's copy is stale
+            numInvalidNodes++;
+        }
+    }
+
+    return numInvalidNodes;
+}
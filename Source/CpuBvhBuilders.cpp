@@ -0,0 +1,1190 @@
+#include "Include/CpuBvhBuilders.h"
+
+#include "Shaders/Compute/ParticleCollisions/BvhRefitLayout.comp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <mutex>
+
+// how many leaves or nodes each task of the thread pool gets (see
+// WorkStealingThreadPool::ParallelFor(...))
+// Note: Big enough that the task queues are nowhere near a bottleneck, and a million particles
+// still make hundreds of tasks to spread out.
+static const unsigned int ITEMS_PER_CHUNK = 2048;
+
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    The CPU version of GLSL's findMSB(...): the index of the most significant 1 bit.
+Parameters:
+    value   Self-explanatory.
+Returns:
+    0-63, or -1 if the value is 0.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+static int FindMsb(unsigned long long value)
+{
+    if (value == 0)
+    {
+        return -1;
+    }
+
+    // binary search for it instead of shifting 1 bit at a time
+    int msb = 0;
+    for (int shift = 32; shift > 0; shift >>= 1)
+    {
+        if ((value >> shift) != 0)
+        {
+            value >>= shift;
+            msb += shift;
+        }
+    }
+    return msb;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    The CPU version of GetSortingKey(...) (see SortingKey32.comp and SortingKey64.comp).  The
+    64-bit key is put back together so that both are just integers here.
+Parameters:
+    sortingData     Self-explanatory.
+Returns:
+    The key.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+static unsigned long long SortingKey(const ParticleSortingData &sortingData)
+{
+    return sortingData._sortingData;
+}
+
+static unsigned long long SortingKey(const ParticleSortingData64 &sortingData)
+{
+    return sortingData.Key();
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    The CPU version of SORTING_KEY_NUM_BITS.  The argument is only there to pick the overload.
+Parameters:
+    sortingData     Any item of the sorting data.
+Returns:
+    Self-explanatory.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+static int SortingKeyNumBits(const ParticleSortingData &)
+{
+    return 32;
+}
+
+static int SortingKeyNumBits(const ParticleSortingData64 &)
+{
+    return 64;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    The CPU version of BvhLeafBoundingBox(...) in ParticleBoundingBox.comp: the box around the
+    collision circles of the leaf's active particles, or an inside-out box if there aren't
+    any.
+Parameters:
+    sortedData          Self-explanatory.
+    firstSortedIndex    The leaf's first particle in the sorted data.
+    numActiveParticles  Self-explanatory.
+    particles           The particles that the sorted data points at.
+    particleProperties  Self-explanatory.
+    maxParticlesPerLeaf Self-explanatory.
+Returns:
+    See Description.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+template <typename SortingDataType>
+static BoundingBox LeafBoundingBox(const std::vector<SortingDataType> &sortedData,
+    unsigned int firstSortedIndex, unsigned int numActiveParticles,
+    const std::vector<Particle> &particles,
+    const std::vector<ParticleProperties> &particleProperties, unsigned int maxParticlesPerLeaf)
+{
+    BoundingBox leafBb;
+    leafBb._left = BVH_REFIT_NULL_LEAF_BOX_EXTENT;
+    leafBb._right = -BVH_REFIT_NULL_LEAF_BOX_EXTENT;
+    leafBb._bottom = BVH_REFIT_NULL_LEAF_BOX_EXTENT;
+    leafBb._top = -BVH_REFIT_NULL_LEAF_BOX_EXTENT;
+
+    for (unsigned int offset = 0; offset < maxParticlesPerLeaf; offset++)
+    {
+        unsigned int sortedIndex = firstSortedIndex + offset;
+        if (sortedIndex >= numActiveParticles)
+        {
+            break;
+        }
+
+        const Particle &p = particles[sortedData[sortedIndex]._preSortedParticleIndex];
+        if (p._isActive == 0)
+        {
+            continue;
+        }
+
+        float r = particleProperties[p._particleTypeIndex]._collisionRadius;
+        leafBb._left = std::min(leafBb._left, p._pos.x - r);
+        leafBb._right = std::max(leafBb._right, p._pos.x + r);
+        leafBb._bottom = std::min(leafBb._bottom, p._pos.y - r);
+        leafBb._top = std::max(leafBb._top, p._pos.y + r);
+    }
+
+    return leafBb;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    The CPU version of SetBvhNode(...) in BvhNodeBuffer.comp: hooks up an internal node to its
+    children with the flags (see BvhNodeLayout.comp) and copies of their boxes, and gives it
+    its own box around both.  The whole node is written at once.
+Parameters:
+    nodes           Self-explanatory.
+    nodeIndex       The internal node.
+    leftChildIndex  Self-explanatory.
+    rightChildIndex Self-explanatory.
+    numLeaves       How many leaves there is room for.  Anything below that is a leaf.
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+static void SetBvhNode(std::vector<BvhNode> &nodes, int nodeIndex, int leftChildIndex,
+    int rightChildIndex, unsigned int numLeaves)
+{
+    // the CPU version of PackBvhChild(...)
+    auto packChild = [numLeaves](int childIndex, const BoundingBox &bb)
+    {
+        unsigned int child = static_cast<unsigned int>(childIndex) & BVH_CHILD_INDEX_MASK;
+        if (static_cast<unsigned int>(childIndex) < numLeaves)
+        {
+            child |= BVH_CHILD_LEAF_BIT;
+        }
+        if (bb._left > bb._right)
+        {
+            child |= BVH_CHILD_NULL_BIT;
+        }
+        return child;
+    };
+
+    const BoundingBox &leftBb = nodes[leftChildIndex]._boundingBox;
+    const BoundingBox &rightBb = nodes[rightChildIndex]._boundingBox;
+
+    BvhNode node;
+    node._leftChildBoundingBox = leftBb;
+    node._rightChildBoundingBox = rightBb;
+    node._leftChild = packChild(leftChildIndex, leftBb);
+    node._rightChild = packChild(rightChildIndex, rightBb);
+    node._boundingBox._left = std::min(leftBb._left, rightBb._left);
+    node._boundingBox._right = std::max(leftBb._right, rightBb._right);
+    node._boundingBox._bottom = std::min(leftBb._bottom, rightBb._bottom);
+    node._boundingBox._top = std::max(leftBb._top, rightBb._top);
+    nodes[nodeIndex] = node;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    The parts of GenerateBinaryRadixTree.comp that look at the keys.  The functions have the
+    same names and the same math as there, so see there for how they work.  It is a structure
+    only so that the sorted data and the number of leaves don't have to be passed to every
+    one of them.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+template <typename SortingDataType>
+struct KarrasRadixTree
+{
+    const std::vector<SortingDataType> &_sortedData;
+    int _numLeavesInUse;
+    unsigned int _maxParticlesPerLeaf;
+
+    // the key width in bits (SORTING_KEY_NUM_BITS)
+    int _numKeyBits;
+
+    int LengthOfCommonPrefix(int indexA, int indexB) const
+    {
+        if (indexB < 0 || indexB >= _numLeavesInUse)
+        {
+            return -1;
+        }
+
+        // a leaf's key is its first particle's key (see BvhLeaves.comp)
+        unsigned long long valueA = SortingKey(_sortedData[indexA * _maxParticlesPerLeaf]);
+        unsigned long long valueB = SortingKey(_sortedData[indexB * _maxParticlesPerLeaf]);
+
+        // identical keys come out 1 longer than the key and are told apart by their indices
+        // Note: This is the same count as the shader's, which is 1 more than the number of
+        // leading zeros.  Only how they compare matters, but the tree has to come out the
+        // same.
+        int commonPrefixLength = _numKeyBits - FindMsb(valueA ^ valueB);
+        if (commonPrefixLength > _numKeyBits)
+        {
+            unsigned int indexDifference = static_cast<unsigned int>(indexA) ^ static_cast<unsigned int>(indexB);
+            commonPrefixLength = _numKeyBits + (32 - FindMsb(indexDifference));
+        }
+        return commonPrefixLength;
+    }
+
+    int DetermineRange(int startNodeIndex, int direction) const
+    {
+        int minimumCommonPrefixLength = LengthOfCommonPrefix(startNodeIndex, startNodeIndex - direction);
+
+        int maxPossibleLength = 2;
+        int secondNodeIndex = startNodeIndex + (maxPossibleLength * direction);
+        while (LengthOfCommonPrefix(startNodeIndex, secondNodeIndex) > minimumCommonPrefixLength)
+        {
+            maxPossibleLength *= 2;
+            secondNodeIndex = startNodeIndex + (maxPossibleLength * direction);
+        }
+
+        int actualLengthSans1 = 0;
+        for (int rangeIncrement = maxPossibleLength >> 1; rangeIncrement >= 1; rangeIncrement >>= 1)
+        {
+            secondNodeIndex = startNodeIndex + ((actualLengthSans1 + rangeIncrement) * direction);
+            if (LengthOfCommonPrefix(startNodeIndex, secondNodeIndex) > minimumCommonPrefixLength)
+            {
+                actualLengthSans1 += rangeIncrement;
+            }
+        }
+
+        return actualLengthSans1;
+    }
+
+    int FindSplitPosition(int startNodeIndex, int length, int direction) const
+    {
+        int otherEndIndex = startNodeIndex + (length * direction);
+        int commonPrefixLengthBetweenBeginAndEnd = LengthOfCommonPrefix(startNodeIndex, otherEndIndex);
+        int splitOffset = 0;
+
+        // Note: A float, like the shader's, so that it rounds the same way.
+        float rangeIncrement = static_cast<float>(length);
+        do
+        {
+            rangeIncrement = std::ceil(rangeIncrement * 0.5f);
+            int rangeIncrementInteger = static_cast<int>(rangeIncrement);
+            int secondNodeIndex = startNodeIndex + ((splitOffset + rangeIncrementInteger) * direction);
+            if (LengthOfCommonPrefix(startNodeIndex, secondNodeIndex) > commonPrefixLengthBetweenBeginAndEnd)
+            {
+                splitOffset += rangeIncrementInteger;
+            }
+        } while (rangeIncrement > 1.0f);
+
+        return startNodeIndex + (splitOffset * direction) + std::min(direction, 0);
+    }
+};
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    The CPU version of GenerateLeafNodeBoundingBoxes.comp, and the first pass of every CPU
+    builder.  Sizes the arrays like the BvhNodeSsbo and the BvhNodeBuildDataSsbo and gives the
+    leaves that are in use their boxes.
+
+    Note: Only resized, so an array that is used over and over isn't filled every time.  The
+    slots that the tree doesn't use are left as they were, like on the GPU.
+
+    Also Note: The leaves don't have children (see BvhNodeLayout.comp).
+Parameters:
+    See BuildBvhKarrasCpu(...).
+Returns:
+    How many leaves there is room for, which is also the root's index.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+template <typename SortingDataType>
+static unsigned int GenerateLeafNodeBoundingBoxesCpu(const std::vector<SortingDataType> &sortedData,
+    unsigned int numActiveParticles, const std::vector<Particle> &particles,
+    const std::vector<ParticleProperties> &particleProperties, unsigned int maxParticlesPerLeaf,
+    WorkStealingThreadPool &threadPool, std::vector<BvhNode> &nodes,
+    std::vector<BvhNodeBuildData> &buildData)
+{
+    unsigned int numLeaves = (static_cast<unsigned int>(particles.size()) + maxParticlesPerLeaf - 1) / maxParticlesPerLeaf;
+    unsigned int numTotalNodes = std::max(numLeaves, 1u) * 2 - 1;
+    nodes.resize(numTotalNodes);
+    buildData.resize(numTotalNodes);
+
+    unsigned int numLeavesInUse = (numActiveParticles + maxParticlesPerLeaf - 1) / maxParticlesPerLeaf;
+    threadPool.ParallelFor(numLeavesInUse, ITEMS_PER_CHUNK,
+        [&](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int leafIndex = begin; leafIndex < end; leafIndex++)
+        {
+            BvhNode leaf;
+            leaf._boundingBox = LeafBoundingBox(sortedData, leafIndex * maxParticlesPerLeaf,
+                numActiveParticles, particles, particleProperties, maxParticlesPerLeaf);
+            nodes[leafIndex] = leaf;
+            buildData[leafIndex]._threadEntranceCounter = 0;
+        }
+    });
+
+    return numLeaves;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    The CPU version of MergeBoundingVolumes.comp, and the last pass of every CPU builder.  By
+    now every internal node has the indexes of its children (without the flags) and every
+    node in the tree has its parent, so all that is left is the boxes.  Each leaf walks up
+    toward the root, and the first thread up to a node stops there and the second one carries
+    on, same as the shader.
+
+    Note: The counters are std::atomic's of their own because the ones in BvhNodeBuildData are
+    plain ints so that they match the GPU.  The plain ones are left at 0, which is where the
+    GPU's end up too.
+
+    Also Note: The counter is acquire-release, so the second thread through a node sees the
+    box that the first one wrote below it.
+Parameters:
+    numLeaves       How many leaves there is room for, which is also the root's index.
+    numLeavesInUse  Self-explanatory.  At least 2.
+    threadPool      Self-explanatory.
+    nodes           Self-explanatory.
+    buildData       Self-explanatory.
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+static void MergeBoundingVolumesCpu(unsigned int numLeaves, unsigned int numLeavesInUse,
+    WorkStealingThreadPool &threadPool, std::vector<BvhNode> &nodes,
+    const std::vector<BvhNodeBuildData> &buildData)
+{
+    int rootIndex = static_cast<int>(numLeaves);
+
+    // Note: The "()" starts the counters at 0.
+    std::unique_ptr<std::atomic<int>[]> threadEntranceCounters(new std::atomic<int>[numLeavesInUse - 1]());
+
+    threadPool.ParallelFor(numLeavesInUse, ITEMS_PER_CHUNK,
+        [&](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int leafIndex = begin; leafIndex < end; leafIndex++)
+        {
+            int nodeIndex = buildData[leafIndex]._parentIndex;
+            while (nodeIndex != -1)
+            {
+                std::atomic<int> &counter = threadEntranceCounters[nodeIndex - rootIndex];
+                if (counter.fetch_add(1, std::memory_order_acq_rel) == 0)
+                {
+                    // the other child isn't done yet, and whoever does it will come back up
+                    break;
+                }
+                counter.store(0, std::memory_order_relaxed);
+
+                const BvhNode &node = nodes[nodeIndex];
+                SetBvhNode(nodes, nodeIndex, BvhNode::ChildIndex(node._leftChild),
+                    BvhNode::ChildIndex(node._rightChild), numLeaves);
+                nodeIndex = buildData[nodeIndex]._parentIndex;
+            }
+        }
+    });
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Does the work of both BuildBvhKarrasCpu(...)s.  The same 3 passes as the GPU, each one a
+    ParallelFor(...) over what the GPU has a thread for:
+    (1) the leaves' boxes (see GenerateLeafNodeBoundingBoxesCpu(...))
+    (2) the internal nodes' children and the parents (GenerateBinaryRadixTree.comp)
+    (3) the boxes merged up from the leaves (see MergeBoundingVolumesCpu(...))
+Parameters:
+    See BuildBvhKarrasCpu(...).
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+template <typename SortingDataType>
+static void BuildBvhKarrasCpuImpl(const std::vector<SortingDataType> &sortedData,
+    unsigned int numActiveParticles, const std::vector<Particle> &particles,
+    const std::vector<ParticleProperties> &particleProperties, unsigned int maxParticlesPerLeaf,
+    WorkStealingThreadPool &threadPool, std::vector<BvhNode> &nodes,
+    std::vector<BvhNodeBuildData> &buildData)
+{
+    maxParticlesPerLeaf = std::max(maxParticlesPerLeaf, 1u);
+
+    // (1) leaf boxes
+    unsigned int numLeaves = GenerateLeafNodeBoundingBoxesCpu(sortedData, numActiveParticles,
+        particles, particleProperties, maxParticlesPerLeaf, threadPool, nodes, buildData);
+
+    // with only 1 leaf there are no internal nodes (see MergeBoundingVolumes.comp)
+    unsigned int numLeavesInUse = (numActiveParticles + maxParticlesPerLeaf - 1) / maxParticlesPerLeaf;
+    if (numLeavesInUse < 2)
+    {
+        return;
+    }
+
+    // (2) the tree
+    KarrasRadixTree<SortingDataType> tree =
+    {
+        sortedData,
+        static_cast<int>(numLeavesInUse),
+        maxParticlesPerLeaf,
+        SortingKeyNumBits(sortedData[0])
+    };
+
+    int rootIndex = static_cast<int>(numLeaves);
+    buildData[rootIndex]._parentIndex = -1;
+    threadPool.ParallelFor(numLeavesInUse - 1, ITEMS_PER_CHUNK,
+        [&](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int threadIndex = begin; threadIndex < end; threadIndex++)
+        {
+            int thisLeafIndex = static_cast<int>(threadIndex);
+            int thisInternalNodeIndex = rootIndex + thisLeafIndex;
+            buildData[thisInternalNodeIndex]._threadEntranceCounter = 0;
+
+            int commonPrefixLengthBefore = tree.LengthOfCommonPrefix(thisLeafIndex, thisLeafIndex - 1);
+            int commonPrefixLengthAfter = tree.LengthOfCommonPrefix(thisLeafIndex, thisLeafIndex + 1);
+            int d = (commonPrefixLengthAfter > commonPrefixLengthBefore) - (commonPrefixLengthAfter < commonPrefixLengthBefore);
+            int range = tree.DetermineRange(thisLeafIndex, d);
+            int splitIndex = tree.FindSplitPosition(thisLeafIndex, range, d);
+            int otherEndIndex = thisLeafIndex + (range * d);
+
+            int leftChildIndex = (std::min(thisLeafIndex, otherEndIndex) == splitIndex) ?
+                splitIndex : rootIndex + splitIndex;
+            int rightChildIndex = (std::max(thisLeafIndex, otherEndIndex) == (splitIndex + 1)) ?
+                splitIndex + 1 : rootIndex + splitIndex + 1;
+
+            // only the indexes for now, and the rest when the boxes are merged
+            nodes[thisInternalNodeIndex]._leftChild = static_cast<unsigned int>(leftChildIndex);
+            nodes[thisInternalNodeIndex]._rightChild = static_cast<unsigned int>(rightChildIndex);
+            buildData[leftChildIndex]._parentIndex = thisInternalNodeIndex;
+            buildData[rightChildIndex]._parentIndex = thisInternalNodeIndex;
+        }
+    });
+
+    // (3) merge the boxes up to the root
+    MergeBoundingVolumesCpu(numLeaves, numLeavesInUse, threadPool, nodes, buildData);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Builds the binary radix tree and its boxes on the CPU (see the top of CpuBvhBuilders.h).
+    One for each sort key width.
+
+    Note: The sorting data is what is in the first half of the ParticleSortingDataSsbo after
+    the sort: the active particles' items in sorted order, each pointing at its particle (see
+    LeafToParticleIndex.comp).  Only the first numActiveParticles are looked at.
+Parameters:
+    sortedData          Self-explanatory.
+    numActiveParticles  How many items at the front of the sorted data are in the tree.
+    particles           All of them, active or not.  The size is the tree's capacity.
+    particleProperties  Self-explanatory.
+    maxParticlesPerLeaf The BVH_MAX_PARTICLES_PER_LEAF that the GPU tree is built with (see
+                        BvhLeaves.comp).
+    threadPool          Self-explanatory.
+    nodes               Receives the nodes.  Resized to the BvhNodeSsbo's size.
+    buildData           Receives the parents and counters.  Resized the same.
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+void BuildBvhKarrasCpu(const std::vector<ParticleSortingData> &sortedData,
+    unsigned int numActiveParticles, const std::vector<Particle> &particles,
+    const std::vector<ParticleProperties> &particleProperties, unsigned int maxParticlesPerLeaf,
+    WorkStealingThreadPool &threadPool, std::vector<BvhNode> &nodes,
+    std::vector<BvhNodeBuildData> &buildData)
+{
+    BuildBvhKarrasCpuImpl(sortedData, numActiveParticles, particles, particleProperties,
+        maxParticlesPerLeaf, threadPool, nodes, buildData);
+}
+
+void BuildBvhKarrasCpu(const std::vector<ParticleSortingData64> &sortedData,
+    unsigned int numActiveParticles, const std::vector<Particle> &particles,
+    const std::vector<ParticleProperties> &particleProperties, unsigned int maxParticlesPerLeaf,
+    WorkStealingThreadPool &threadPool, std::vector<BvhNode> &nodes,
+    std::vector<BvhNodeBuildData> &buildData)
+{
+    BuildBvhKarrasCpuImpl(sortedData, numActiveParticles, particles, particleProperties,
+        maxParticlesPerLeaf, threadPool, nodes, buildData);
+}
+
+// how many bins along each axis the binned SAH builder tries splits between
+// Note: 16 is the usual number.  More bins make a slightly better tree for a slower build.
+static const int SAH_NUM_BINS = 16;
+
+// a task with at least this many leaves is split with a ParallelFor(...) of its own, and
+// anything smaller has its whole subtree built by one thread
+static const unsigned int SAH_MIN_LEAVES_FOR_PARALLEL_SPLIT = 4 * ITEMS_PER_CHUNK;
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Which edges of a box go with which axis, so that the binned SAH builder can try both axes
+    with the same code.  0 is X and 1 is Y.
+Parameters:
+    box     Self-explanatory.
+    axis    Self-explanatory.
+Returns:
+    The left or bottom, or the right or top.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+static float BoxLow(const BoundingBox &box, int axis)
+{
+    return (axis == 0) ? box._left : box._bottom;
+}
+
+static float BoxHigh(const BoundingBox &box, int axis)
+{
+    return (axis == 0) ? box._right : box._top;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    An inside-out box that any other box can be merged into, and the merge.  The null leaves'
+    boxes are inside out too, so merging one in changes nothing.
+Parameters:
+    box     The box to grow.
+    other   The box to grow it by.
+Returns:
+    See Description.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+static BoundingBox EmptyBox()
+{
+    BoundingBox box;
+    box._left = BVH_REFIT_NULL_LEAF_BOX_EXTENT;
+    box._right = -BVH_REFIT_NULL_LEAF_BOX_EXTENT;
+    box._bottom = BVH_REFIT_NULL_LEAF_BOX_EXTENT;
+    box._top = -BVH_REFIT_NULL_LEAF_BOX_EXTENT;
+    return box;
+}
+
+static void GrowBox(BoundingBox &box, const BoundingBox &other)
+{
+    box._left = std::min(box._left, other._left);
+    box._right = std::max(box._right, other._right);
+    box._bottom = std::min(box._bottom, other._bottom);
+    box._top = std::max(box._top, other._top);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    The same as in BvhQuality.cpp: the 2D stand-in for surface area.
+Parameters:
+    box     Self-explanatory.
+Returns:
+    Width + height.  0 for an empty or inverted box.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+static float HalfPerimeter(const BoundingBox &box)
+{
+    float width = std::max(box._right - box._left, 0.0f);
+    float height = std::max(box._top - box._bottom, 0.0f);
+    return width + height;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    A piece of the binned SAH build: the leaves [_begin, _end) of the leaf order, which will
+    be the subtree under _nodeIndex.
+
+    A subtree of N leaves has N - 1 internal nodes, so each task is given a block of that many
+    node indexes, starting with its own.  Its left child gets the block right after it and its
+    right child the one after that.  That way every node's index is known as soon as its
+    parent is split, and the tasks don't have to wait on each other to number them.  The root
+    has the block [number of leaves, number of leaves + leaves in use - 1), the same as every
+    other builder (see BvhLeaves.comp).
+
+    Note: The box around the leaves' centers, not around the leaves, is what the bins are cut
+    from.  The parent's bins already know it, so it is handed down instead of measured again.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+struct SahTask
+{
+    unsigned int _begin;
+    unsigned int _end;
+    int _nodeIndex;
+    BoundingBox _centroidBounds;
+};
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    What the binned SAH builder knows about a leaf besides its box: the center of the box, or
+    that it has no box at all.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+struct SahLeaf
+{
+    float _centroid[2];
+    bool _isNull;
+};
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    The leaves of a task dropped into SAH_NUM_BINS bins along each axis by their centers, with
+    how many are in each bin, the box around them, and the box around their centers.
+
+    Note: Everything is either a count or a min/max, so it comes out the same whatever order
+    the leaves go in.  That is what lets the bins be filled in chunks on different threads and
+    merged afterwards without the tree depending on how many threads there were.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+struct SahBins
+{
+    SahBins()
+    {
+        for (int axis = 0; axis < 2; axis++)
+        {
+            for (int bin = 0; bin < SAH_NUM_BINS; bin++)
+            {
+                _counts[axis][bin] = 0;
+                _boxes[axis][bin] = EmptyBox();
+                _centroidBounds[axis][bin] = EmptyBox();
+            }
+        }
+    }
+
+    void Merge(const SahBins &other)
+    {
+        for (int axis = 0; axis < 2; axis++)
+        {
+            for (int bin = 0; bin < SAH_NUM_BINS; bin++)
+            {
+                _counts[axis][bin] += other._counts[axis][bin];
+                GrowBox(_boxes[axis][bin], other._boxes[axis][bin]);
+                GrowBox(_centroidBounds[axis][bin], other._centroidBounds[axis][bin]);
+            }
+        }
+    }
+
+    unsigned int _counts[2][SAH_NUM_BINS];
+    BoundingBox _boxes[2][SAH_NUM_BINS];
+    BoundingBox _centroidBounds[2][SAH_NUM_BINS];
+};
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Where a task is split.  If no split plane separates the leaves (they all have the same
+    center, or there are only null leaves), then _axis is -1 and the task is cut in half
+    where it is instead.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+struct SahSplit
+{
+    int _axis;
+    int _lastLeftBin;
+    BoundingBox _leftCentroidBounds;
+    BoundingBox _rightCentroidBounds;
+};
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Which bin a leaf's center falls into along an axis of a task.  Null leaves have no center,
+    so they go into bin 0.
+
+    Note: The task's center box is at least as big as the center, so this is never below 0,
+    and the one at the top edge is clamped into the last bin.
+Parameters:
+    leaf            Self-explanatory.
+    axis            Self-explanatory.
+    centroidBounds  The task's.  Must not be flat along the axis.
+Returns:
+    0 to SAH_NUM_BINS - 1.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+static int SahBinIndex(const SahLeaf &leaf, int axis, const BoundingBox &centroidBounds)
+{
+    if (leaf._isNull)
+    {
+        return 0;
+    }
+
+    float low = BoxLow(centroidBounds, axis);
+    float extent = BoxHigh(centroidBounds, axis) - low;
+    int bin = static_cast<int>(((leaf._centroid[axis] - low) / extent) * SAH_NUM_BINS);
+    return std::min(std::max(bin, 0), SAH_NUM_BINS - 1);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Drops [begin, end) of the leaf order into the bins (see SahBins).  An axis along which the
+    task's centers are flat can't be split, so it is skipped.
+Parameters:
+    leafOrder       Self-explanatory.
+    begin           Self-explanatory.
+    end             Self-explanatory.
+    sahLeaves       Self-explanatory.
+    nodes           The leaves' boxes are in here.
+    centroidBounds  The task's.
+    bins            Receives the leaves.
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+static void FillSahBins(const std::vector<unsigned int> &leafOrder, unsigned int begin,
+    unsigned int end, const std::vector<SahLeaf> &sahLeaves, const std::vector<BvhNode> &nodes,
+    const BoundingBox &centroidBounds, SahBins &bins)
+{
+    for (int axis = 0; axis < 2; axis++)
+    {
+        if (BoxHigh(centroidBounds, axis) <= BoxLow(centroidBounds, axis))
+        {
+            continue;
+        }
+
+        for (unsigned int orderIndex = begin; orderIndex < end; orderIndex++)
+        {
+            unsigned int leafIndex = leafOrder[orderIndex];
+            const SahLeaf &leaf = sahLeaves[leafIndex];
+            int bin = SahBinIndex(leaf, axis, centroidBounds);
+            bins._counts[axis][bin]++;
+            GrowBox(bins._boxes[axis][bin], nodes[leafIndex]._boundingBox);
+            if (!leaf._isNull)
+            {
+                BoundingBox centroid;
+                centroid._left = leaf._centroid[0];
+                centroid._right = leaf._centroid[0];
+                centroid._bottom = leaf._centroid[1];
+                centroid._top = leaf._centroid[1];
+                GrowBox(bins._centroidBounds[axis][bin], centroid);
+            }
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Tries every plane between two bins along both axes and picks the one with the lowest SAH
+    cost: each side's half perimeter (see HalfPerimeter(...)) times how many leaves are on
+    that side.  The cost of the node itself is the same for every split, so it is left out.
+
+    Note: A plane with nothing on one side isn't a split, so it is skipped.  If the centers
+    aren't flat along an axis, then the lowest one is in bin 0 and the highest in the last
+    bin, so there is always at least one real split along it.
+
+    Also Note: The first of any that cost the same wins, so the tree doesn't depend on
+    anything but the leaves.
+Parameters:
+    bins            The task's, all of them merged.
+    centroidBounds  The task's.
+Returns:
+    See SahSplit.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+static SahSplit ChooseSahSplit(const SahBins &bins, const BoundingBox &centroidBounds)
+{
+    SahSplit split;
+    split._axis = -1;
+    split._lastLeftBin = -1;
+    split._leftCentroidBounds = centroidBounds;
+    split._rightCentroidBounds = centroidBounds;
+
+    float lowestCost = 0.0f;
+    for (int axis = 0; axis < 2; axis++)
+    {
+        if (BoxHigh(centroidBounds, axis) <= BoxLow(centroidBounds, axis))
+        {
+            continue;
+        }
+
+        // sweep from the right first so that the left sweep can look up the other side
+        float rightCosts[SAH_NUM_BINS];
+        BoundingBox rightBox = EmptyBox();
+        unsigned int rightCount = 0;
+        for (int bin = SAH_NUM_BINS - 1; bin > 0; bin--)
+        {
+            GrowBox(rightBox, bins._boxes[axis][bin]);
+            rightCount += bins._counts[axis][bin];
+            rightCosts[bin] = HalfPerimeter(rightBox) * rightCount;
+        }
+
+        BoundingBox leftBox = EmptyBox();
+        unsigned int leftCount = 0;
+        unsigned int totalCount = rightCount + bins._counts[axis][0];
+        for (int bin = 0; bin < SAH_NUM_BINS - 1; bin++)
+        {
+            GrowBox(leftBox, bins._boxes[axis][bin]);
+            leftCount += bins._counts[axis][bin];
+            if (leftCount == 0 || leftCount == totalCount)
+            {
+                continue;
+            }
+
+            float cost = (HalfPerimeter(leftBox) * leftCount) + rightCosts[bin + 1];
+            if (split._axis == -1 || cost < lowestCost)
+            {
+                lowestCost = cost;
+                split._axis = axis;
+                split._lastLeftBin = bin;
+            }
+        }
+    }
+
+    if (split._axis != -1)
+    {
+        split._leftCentroidBounds = EmptyBox();
+        split._rightCentroidBounds = EmptyBox();
+        for (int bin = 0; bin < SAH_NUM_BINS; bin++)
+        {
+            BoundingBox &side = (bin <= split._lastLeftBin) ?
+                split._leftCentroidBounds : split._rightCentroidBounds;
+            GrowBox(side, bins._centroidBounds[split._axis][bin]);
+        }
+    }
+
+    return split;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Hooks a split task up to its two children: the indexes (see SahTask for how they are
+    numbered) go into the node, the node goes into the children's parents, and any child with
+    more than one leaf becomes a task of its own.  The boxes come later (see
+    MergeBoundingVolumesCpu(...)).
+Parameters:
+    task            The task that was split.
+    middle          Where its leaves were split.  The left child has [_begin, middle).
+    split           Self-explanatory.
+    leafOrder       Self-explanatory.
+    nodes           Self-explanatory.
+    buildData       Self-explanatory.
+    leftTask        Receives the left child's task, if there is one.
+    rightTask       Receives the right child's task, if there is one.
+Returns:
+    Bit 0 if there is a left task, bit 1 if there is a right task.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+static int LinkSahChildren(const SahTask &task, unsigned int middle, const SahSplit &split,
+    const std::vector<unsigned int> &leafOrder, std::vector<BvhNode> &nodes,
+    std::vector<BvhNodeBuildData> &buildData, SahTask &leftTask, SahTask &rightTask)
+{
+    unsigned int numLeftLeaves = middle - task._begin;
+    unsigned int numRightLeaves = task._end - middle;
+    int childTasks = 0;
+
+    int leftChildIndex = static_cast<int>(leafOrder[task._begin]);
+    if (numLeftLeaves > 1)
+    {
+        leftChildIndex = task._nodeIndex + 1;
+        leftTask._begin = task._begin;
+        leftTask._end = middle;
+        leftTask._nodeIndex = leftChildIndex;
+        leftTask._centroidBounds = split._leftCentroidBounds;
+        childTasks |= 1;
+    }
+
+    int rightChildIndex = static_cast<int>(leafOrder[middle]);
+    if (numRightLeaves > 1)
+    {
+        rightChildIndex = task._nodeIndex + static_cast<int>(numLeftLeaves);
+        rightTask._begin = middle;
+        rightTask._end = task._end;
+        rightTask._nodeIndex = rightChildIndex;
+        rightTask._centroidBounds = split._rightCentroidBounds;
+        childTasks |= 2;
+    }
+
+    nodes[task._nodeIndex]._leftChild = static_cast<unsigned int>(leftChildIndex);
+    nodes[task._nodeIndex]._rightChild = static_cast<unsigned int>(rightChildIndex);
+    buildData[task._nodeIndex]._threadEntranceCounter = 0;
+    buildData[leftChildIndex]._parentIndex = task._nodeIndex;
+    buildData[rightChildIndex]._parentIndex = task._nodeIndex;
+    return childTasks;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Builds the whole subtree of a small task on 1 thread.  The tasks are split one after
+    another off of a stack, with the bins filled, the split chosen, and the leaves partitioned
+    all right here.
+
+    Note: The partition is stable, the same as the big tasks', so the leaves on each side stay
+    in the order that they were sorted in.
+Parameters:
+    rootTask        Self-explanatory.
+    leafOrder       Self-explanatory.  Only the task's own range is touched.
+    sahLeaves       Self-explanatory.
+    nodes           Self-explanatory.
+    buildData       Self-explanatory.
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+static void BuildSahSubtree(const SahTask &rootTask, std::vector<unsigned int> &leafOrder,
+    const std::vector<SahLeaf> &sahLeaves, std::vector<BvhNode> &nodes,
+    std::vector<BvhNodeBuildData> &buildData)
+{
+    std::vector<SahTask> taskStack(1, rootTask);
+    while (!taskStack.empty())
+    {
+        SahTask task = taskStack.back();
+        taskStack.pop_back();
+
+        SahBins bins;
+        FillSahBins(leafOrder, task._begin, task._end, sahLeaves, nodes, task._centroidBounds, bins);
+        SahSplit split = ChooseSahSplit(bins, task._centroidBounds);
+
+        unsigned int middle = task._begin + ((task._end - task._begin) / 2);
+        if (split._axis != -1)
+        {
+            auto first = leafOrder.begin() + task._begin;
+            auto last = leafOrder.begin() + task._end;
+            auto middleIter = std::stable_partition(first, last, [&](unsigned int leafIndex)
+            {
+                return SahBinIndex(sahLeaves[leafIndex], split._axis, task._centroidBounds) <= split._lastLeftBin;
+            });
+            middle = static_cast<unsigned int>(middleIter - leafOrder.begin());
+        }
+
+        SahTask leftTask;
+        SahTask rightTask;
+        int childTasks = LinkSahChildren(task, middle, split, leafOrder, nodes, buildData, leftTask, rightTask);
+        if (childTasks & 2)
+        {
+            taskStack.push_back(rightTask);
+        }
+        if (childTasks & 1)
+        {
+            taskStack.push_back(leftTask);
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Splits a big task with every thread: the bins are filled a chunk at a time and merged, and
+    then the leaves are partitioned by counting how many of each chunk go left, adding those
+    up, and having each chunk copy its leaves to where they go.  That is the same as
+    std::stable_partition(...), just in parallel.
+Parameters:
+    task            Self-explanatory.
+    leafOrder       Self-explanatory.
+    scratchOrder    The same size as the leaf order, for the partition to copy into.
+    sahLeaves       Self-explanatory.
+    threadPool      Self-explanatory.
+    nodes           Self-explanatory.
+    buildData       Self-explanatory.
+    leftTask        Receives the left child's task, if there is one.
+    rightTask       Receives the right child's task, if there is one.
+Returns:
+    See LinkSahChildren(...).
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+static int SplitSahTaskInParallel(const SahTask &task, std::vector<unsigned int> &leafOrder,
+    std::vector<unsigned int> &scratchOrder, const std::vector<SahLeaf> &sahLeaves,
+    WorkStealingThreadPool &threadPool, std::vector<BvhNode> &nodes,
+    std::vector<BvhNodeBuildData> &buildData, SahTask &leftTask, SahTask &rightTask)
+{
+    unsigned int numTaskLeaves = task._end - task._begin;
+    SahBins bins;
+    std::mutex binsMutex;
+    threadPool.ParallelFor(numTaskLeaves, ITEMS_PER_CHUNK,
+        [&](unsigned int begin, unsigned int end)
+    {
+        SahBins chunkBins;
+        FillSahBins(leafOrder, task._begin + begin, task._begin + end, sahLeaves, nodes,
+            task._centroidBounds, chunkBins);
+        std::lock_guard<std::mutex> lock(binsMutex);
+        bins.Merge(chunkBins);
+    });
+    SahSplit split = ChooseSahSplit(bins, task._centroidBounds);
+
+    unsigned int middle = task._begin + (numTaskLeaves / 2);
+    if (split._axis != -1)
+    {
+        auto goesLeft = [&](unsigned int leafIndex)
+        {
+            return SahBinIndex(sahLeaves[leafIndex], split._axis, task._centroidBounds) <= split._lastLeftBin;
+        };
+
+        // the chunks are the same ones as ParallelFor(...) makes, so each one can find its count
+        unsigned int numChunks = (numTaskLeaves + ITEMS_PER_CHUNK - 1) / ITEMS_PER_CHUNK;
+        std::vector<unsigned int> numLeftInChunk(numChunks, 0);
+        threadPool.ParallelFor(numTaskLeaves, ITEMS_PER_CHUNK,
+            [&](unsigned int begin, unsigned int end)
+        {
+            unsigned int numLeft = 0;
+            for (unsigned int orderIndex = task._begin + begin; orderIndex < task._begin + end; orderIndex++)
+            {
+                numLeft += goesLeft(leafOrder[orderIndex]) ? 1 : 0;
+            }
+            numLeftInChunk[begin / ITEMS_PER_CHUNK] = numLeft;
+        });
+
+        // exclusive scan, so each chunk knows where its leaves start on either side
+        std::vector<unsigned int> firstLeftInChunk(numChunks, 0);
+        unsigned int numLeftLeaves = 0;
+        for (unsigned int chunk = 0; chunk < numChunks; chunk++)
+        {
+            firstLeftInChunk[chunk] = numLeftLeaves;
+            numLeftLeaves += numLeftInChunk[chunk];
+        }
+        middle = task._begin + numLeftLeaves;
+
+        threadPool.ParallelFor(numTaskLeaves, ITEMS_PER_CHUNK,
+            [&](unsigned int begin, unsigned int end)
+        {
+            unsigned int chunk = begin / ITEMS_PER_CHUNK;
+            unsigned int leftWrite = task._begin + firstLeftInChunk[chunk];
+            unsigned int rightWrite = middle + (begin - firstLeftInChunk[chunk]);
+            for (unsigned int orderIndex = task._begin + begin; orderIndex < task._begin + end; orderIndex++)
+            {
+                unsigned int leafIndex = leafOrder[orderIndex];
+                if (goesLeft(leafIndex))
+                {
+                    scratchOrder[leftWrite++] = leafIndex;
+                }
+                else
+                {
+                    scratchOrder[rightWrite++] = leafIndex;
+                }
+            }
+        });
+
+        threadPool.ParallelFor(numTaskLeaves, ITEMS_PER_CHUNK,
+            [&](unsigned int begin, unsigned int end)
+        {
+            std::copy(scratchOrder.begin() + task._begin + begin, scratchOrder.begin() + task._begin + end,
+                leafOrder.begin() + task._begin + begin);
+        });
+    }
+
+    return LinkSahChildren(task, middle, split, leafOrder, nodes, buildData, leftTask, rightTask);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Does the work of both BuildBvhBinnedSahCpu(...)s:
+    (1) the leaves' boxes (see GenerateLeafNodeBoundingBoxesCpu(...)) and their centers
+    (2) the tree, top down (see SahTask)
+    (3) the boxes merged up from the leaves (see MergeBoundingVolumesCpu(...))
+
+    In (2), the tasks near the top are too few to go around, so each one is split with all
+    the threads (see SplitSahTaskInParallel(...)), one after another, until they are small.
+    By then there are plenty of them, so each thread takes whole subtrees (see
+    BuildSahSubtree(...)).
+
+    Note: The split for a task only depends on its leaves, so the tree comes out the same for
+    any number of threads.
+Parameters:
+    See BuildBvhBinnedSahCpu(...).
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+template <typename SortingDataType>
+static void BuildBvhBinnedSahCpuImpl(const std::vector<SortingDataType> &sortedData,
+    unsigned int numActiveParticles, const std::vector<Particle> &particles,
+    const std::vector<ParticleProperties> &particleProperties, unsigned int maxParticlesPerLeaf,
+    WorkStealingThreadPool &threadPool, std::vector<BvhNode> &nodes,
+    std::vector<BvhNodeBuildData> &buildData)
+{
+    maxParticlesPerLeaf = std::max(maxParticlesPerLeaf, 1u);
+
+    // (1) leaf boxes
+    unsigned int numLeaves = GenerateLeafNodeBoundingBoxesCpu(sortedData, numActiveParticles,
+        particles, particleProperties, maxParticlesPerLeaf, threadPool, nodes, buildData);
+
+    // with only 1 leaf there are no internal nodes (see MergeBoundingVolumes.comp)
+    unsigned int numLeavesInUse = (numActiveParticles + maxParticlesPerLeaf - 1) / maxParticlesPerLeaf;
+    if (numLeavesInUse < 2)
+    {
+        return;
+    }
+
+    // the leaves' centers and the box around all of them
+    std::vector<SahLeaf> sahLeaves(numLeavesInUse);
+    std::vector<unsigned int> leafOrder(numLeavesInUse);
+    BoundingBox rootCentroidBounds = EmptyBox();
+    std::mutex boundsMutex;
+    threadPool.ParallelFor(numLeavesInUse, ITEMS_PER_CHUNK,
+        [&](unsigned int begin, unsigned int end)
+    {
+        BoundingBox chunkCentroidBounds = EmptyBox();
+        for (unsigned int leafIndex = begin; leafIndex < end; leafIndex++)
+        {
+            const BoundingBox &bb = nodes[leafIndex]._boundingBox;
+            SahLeaf &leaf = sahLeaves[leafIndex];
+            leaf._isNull = (bb._left > bb._right);
+            leaf._centroid[0] = leaf._isNull ? 0.0f : (bb._left + bb._right) * 0.5f;
+            leaf._centroid[1] = leaf._isNull ? 0.0f : (bb._bottom + bb._top) * 0.5f;
+            leafOrder[leafIndex] = leafIndex;
+            if (!leaf._isNull)
+            {
+                BoundingBox centroid;
+                centroid._left = leaf._centroid[0];
+                centroid._right = leaf._centroid[0];
+                centroid._bottom = leaf._centroid[1];
+                centroid._top = leaf._centroid[1];
+                GrowBox(chunkCentroidBounds, centroid);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(boundsMutex);
+        GrowBox(rootCentroidBounds, chunkCentroidBounds);
+    });
+
+    // (2) the tree
+    SahTask rootTask;
+    rootTask._begin = 0;
+    rootTask._end = numLeavesInUse;
+    rootTask._nodeIndex = static_cast<int>(numLeaves);
+    rootTask._centroidBounds = rootCentroidBounds;
+    buildData[rootTask._nodeIndex]._parentIndex = -1;
+
+    std::vector<SahTask> bigTasks;
+    std::vector<SahTask> smallTasks;
+    std::vector<unsigned int> scratchOrder;
+    if (numLeavesInUse >= SAH_MIN_LEAVES_FOR_PARALLEL_SPLIT)
+    {
+        bigTasks.push_back(rootTask);
+        scratchOrder.resize(numLeavesInUse);
+    }
+    else
+    {
+        smallTasks.push_back(rootTask);
+    }
+
+    while (!bigTasks.empty())
+    {
+        SahTask task = bigTasks.back();
+        bigTasks.pop_back();
+
+        SahTask childTasks[2];
+        int hasChildTask = SplitSahTaskInParallel(task, leafOrder, scratchOrder, sahLeaves,
+            threadPool, nodes, buildData, childTasks[0], childTasks[1]);
+        for (int child = 0; child < 2; child++)
+        {
+            if ((hasChildTask & (1 << child)) == 0)
+            {
+                continue;
+            }
+
+            const SahTask &childTask = childTasks[child];
+            std::vector<SahTask> &tasks = ((childTask._end - childTask._begin) >= SAH_MIN_LEAVES_FOR_PARALLEL_SPLIT) ?
+                bigTasks : smallTasks;
+            tasks.push_back(childTask);
+        }
+    }
+
+    // Note: 1 task per chunk, because one task can be thousands of times bigger than another.
+    threadPool.ParallelFor(static_cast<unsigned int>(smallTasks.size()), 1,
+        [&](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int taskIndex = begin; taskIndex < end; taskIndex++)
+        {
+            BuildSahSubtree(smallTasks[taskIndex], leafOrder, sahLeaves, nodes, buildData);
+        }
+    });
+
+    // (3) merge the boxes up to the root
+    MergeBoundingVolumesCpu(numLeaves, numLeavesInUse, threadPool, nodes, buildData);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Builds a binned SAH tree and its boxes on the CPU (see the top of CpuBvhBuilders.h).  One
+    for each sort key width, although only the particle indexes are used.
+Parameters:
+    See BuildBvhKarrasCpu(...).
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+void BuildBvhBinnedSahCpu(const std::vector<ParticleSortingData> &sortedData,
+    unsigned int numActiveParticles, const std::vector<Particle> &particles,
+    const std::vector<ParticleProperties> &particleProperties, unsigned int maxParticlesPerLeaf,
+    WorkStealingThreadPool &threadPool, std::vector<BvhNode> &nodes,
+    std::vector<BvhNodeBuildData> &buildData)
+{
+    BuildBvhBinnedSahCpuImpl(sortedData, numActiveParticles, particles, particleProperties,
+        maxParticlesPerLeaf, threadPool, nodes, buildData);
+}
+
+void BuildBvhBinnedSahCpu(const std::vector<ParticleSortingData64> &sortedData,
+    unsigned int numActiveParticles, const std::vector<Particle> &particles,
+    const std::vector<ParticleProperties> &particleProperties, unsigned int maxParticlesPerLeaf,
+    WorkStealingThreadPool &threadPool, std::vector<BvhNode> &nodes,
+    std::vector<BvhNodeBuildData> &buildData)
+{
+    BuildBvhBinnedSahCpuImpl(sortedData, numActiveParticles, particles, particleProperties,
+        maxParticlesPerLeaf, threadPool, nodes, buildData);
+}
@@ -0,0 +1,529 @@
+#include "Include/MortonCode.h"
+
+#include <algorithm>
+
+#include "Shaders/Compute/ParticleRegionBoundaries.comp"
+
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    The CPU version of ExpandBits(...) in PositionToMortonCode.comp.  Puts 2 zeros between each 
+    of the lower 10 bits.
+Parameters: 
+    i   An unsigned integer within the range 0-1023 (2^10 - 1).
+Returns:    
+    A 30bit version of the input.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+static unsigned int ExpandBits3D(unsigned int i)
+{
+    unsigned int expandedI = i;
+    expandedI = (expandedI * 0x00010001u) & 0xFF0000FFu;
+    expandedI = (expandedI * 0x00000101u) & 0x0F00F00Fu;
+    expandedI = (expandedI * 0x00000011u) & 0xC30C30C3u;
+    expandedI = (expandedI * 0x00000005u) & 0x49249249u;
+    return expandedI;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Undoes ExpandBits3D(...).  Each step pulls the groups of bits back together in the reverse 
+    order that they were pulled apart.
+Parameters: 
+    i   A Morton Code shifted so that the wanted axis' bits are in bits 0, 3, 6, ..., 27.
+Returns:    
+    The 10bit coordinate.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+static unsigned int CompactBits3D(unsigned int i)
+{
+    unsigned int compactedI = i & 0x09249249u;
+    compactedI = (compactedI | (compactedI >> 2)) & 0x030C30C3u;
+    compactedI = (compactedI | (compactedI >> 4)) & 0x0300F00Fu;
+    compactedI = (compactedI | (compactedI >> 8)) & 0xFF0000FFu;
+    compactedI = (compactedI | (compactedI >> 16)) & 0x000003FFu;
+    return compactedI;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    The CPU version of ExpandBits2D(...) in PositionToMortonCode2D.comp.  Puts 1 zero between 
+    each of the lower 16 bits.
+Parameters: 
+    i   An unsigned integer within the range 0-65535 (2^16 - 1).
+Returns:    
+    A 32bit version of the input.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+static unsigned int ExpandBits2D(unsigned int i)
+{
+    unsigned int expandedI = i & 0x0000FFFFu;
+    expandedI = (expandedI | (expandedI << 8)) & 0x00FF00FFu;
+    expandedI = (expandedI | (expandedI << 4)) & 0x0F0F0F0Fu;
+    expandedI = (expandedI | (expandedI << 2)) & 0x33333333u;
+    expandedI = (expandedI | (expandedI << 1)) & 0x55555555u;
+    return expandedI;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Undoes ExpandBits2D(...).
+Parameters: 
+    i   A Morton Code shifted so that the wanted axis' bits are in the even bits.
+Returns:    
+    The 16bit coordinate.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+static unsigned int CompactBits2D(unsigned int i)
+{
+    unsigned int compactedI = i & 0x55555555u;
+    compactedI = (compactedI | (compactedI >> 1)) & 0x33333333u;
+    compactedI = (compactedI | (compactedI >> 2)) & 0x0F0F0F0Fu;
+    compactedI = (compactedI | (compactedI >> 4)) & 0x00FF00FFu;
+    compactedI = (compactedI | (compactedI >> 8)) & 0x0000FFFFu;
+    return compactedI;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Same as the shaders: reduces the coordinate to [0,1] over the particle region and then 
+    turns it into an integer with the given number of steps, clamped to the last one.
+Parameters: 
+    coordinate      Self-explanatory.
+    regionMin       PARTICLE_REGION_MIN_* for this axis.
+    inverseRange    PARTICLE_REGION_INVERSE_RANGE_* for this axis.
+    numSteps        1024 for 10 bits, 65536 for 16 bits.
+Returns:    
+    See Description.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+static unsigned int CoordinateToInteger(float coordinate, float regionMin, float inverseRange, 
+    float numSteps)
+{
+    float normalized = (coordinate - regionMin) * inverseRange;
+    return static_cast<unsigned int>(std::min(std::max(normalized * numSteps, 0.0f), numSteps - 1.0f));
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Undoes CoordinateToInteger(...).  The integer only says which cell the coordinate was in, 
+    so this gives the center of that cell.
+Parameters: 
+    i               The integer coordinate.
+    regionMin       PARTICLE_REGION_MIN_* for this axis.
+    range           PARTICLE_REGION_RANGE_* for this axis.
+    numSteps        1024 for 10 bits, 65536 for 16 bits.
+Returns:    
+    See Description.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+static float IntegerToCoordinate(unsigned int i, float regionMin, float range, float numSteps)
+{
+    return regionMin + (((static_cast<float>(i) + 0.5f) / numSteps) * range);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Like CoordinateToInteger(...), but in double like PositionToMortonCode2D64.comp.  A float 
+    can't count to 2^32 in steps of 1.
+Parameters: 
+    coordinate      Self-explanatory.
+    regionMin       PARTICLE_REGION_MIN_* for this axis.
+    inverseRange    PARTICLE_REGION_INVERSE_RANGE_* for this axis.
+    numSteps        4294967296 for 32 bits.
+Returns:    
+    See Description.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+static unsigned int CoordinateToIntegerDouble(float coordinate, float regionMin, float inverseRange, 
+    double numSteps)
+{
+    double normalized = (static_cast<double>(coordinate) - static_cast<double>(regionMin)) * static_cast<double>(inverseRange);
+    return static_cast<unsigned int>(std::min(std::max(normalized * numSteps, 0.0), numSteps - 1.0));
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Like IntegerToCoordinate(...), but in double.
+
+    Note: The result is still a float, so for 32 bits per axis the cell center is rounded to 
+    the nearest float.  Turning that back into a Morton Code may not give the same code.
+Parameters: 
+    i               The integer coordinate.
+    regionMin       PARTICLE_REGION_MIN_* for this axis.
+    range           PARTICLE_REGION_RANGE_* for this axis.
+    numSteps        4294967296 for 32 bits.
+Returns:    
+    See Description.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+static float IntegerToCoordinateDouble(unsigned int i, float regionMin, float range, double numSteps)
+{
+    return static_cast<float>(regionMin + (((static_cast<double>(i) + 0.5) / numSteps) * range));
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    ParticleCollisions adds the returned file to the shaders that need a Morton Code.  All the 
+    files define PositionToMortonCode(...) and the MORTON_CODE_* values.
+Parameters: 
+    encoding    Self-explanatory.
+Returns:    
+    The path to the shader file, relative to the project root like all the others.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+std::string MortonCodeShaderFilePath(MortonCodeEncoding encoding)
+{
+    switch (encoding)
+    {
+    case MortonCodeEncoding::MORTON_CODE_3D_10_BITS:
+        return "Shaders/Compute/PositionToMortonCode.comp";
+    case MortonCodeEncoding::MORTON_CODE_3D_21_BITS_64:
+        return "Shaders/Compute/PositionToMortonCode64.comp";
+    case MortonCodeEncoding::MORTON_CODE_2D_32_BITS_64:
+        return "Shaders/Compute/PositionToMortonCode2D64.comp";
+    case MortonCodeEncoding::HILBERT_CODE_2D_16_BITS:
+        return "Shaders/Compute/PositionToHilbertCode2D.comp";
+    default:
+        return "Shaders/Compute/PositionToMortonCode2D.comp";
+    }
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    The 64-bit encodings return a uvec2 from PositionToMortonCode(...), so the sorting data 
+    and the sort have to be made for 64-bit keys.
+Parameters: 
+    encoding    Self-explanatory.
+Returns:    
+    The sort key width that goes with the encoding.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+SortingKeyWidth MortonCodeKeyWidth(MortonCodeEncoding encoding)
+{
+    if (encoding == MortonCodeEncoding::MORTON_CODE_3D_21_BITS_64 || 
+        encoding == MortonCodeEncoding::MORTON_CODE_2D_32_BITS_64)
+    {
+        return SortingKeyWidth::KEY_64_BIT;
+    }
+    return SortingKeyWidth::KEY_32_BIT;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    The CPU version of PositionToMortonCode(...) in PositionToMortonCode.comp.
+Parameters: 
+    pos     Self-explanatory.  W is ignored.
+Returns:    
+    A 30bit Morton Code.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int PositionToMortonCode3D(const glm::vec4 &pos)
+{
+    unsigned int x = CoordinateToInteger(pos.x, PARTICLE_REGION_MIN_X, PARTICLE_REGION_INVERSE_RANGE_X, 1024.0f);
+    unsigned int y = CoordinateToInteger(pos.y, PARTICLE_REGION_MIN_Y, PARTICLE_REGION_INVERSE_RANGE_Y, 1024.0f);
+    unsigned int z = CoordinateToInteger(pos.z, PARTICLE_REGION_MIN_Z, PARTICLE_REGION_INVERSE_RANGE_Z, 1024.0f);
+    return (ExpandBits3D(x) * 4) + (ExpandBits3D(y) * 2) + ExpandBits3D(z);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    The CPU version of PositionToMortonCode(...) in PositionToMortonCode2D.comp.
+Parameters: 
+    pos     Self-explanatory.  Z and W are ignored.
+Returns:    
+    A 32bit Morton Code.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int PositionToMortonCode2D(const glm::vec4 &pos)
+{
+    glm::vec4 regionMin(PARTICLE_REGION_MIN_X, PARTICLE_REGION_MIN_Y, PARTICLE_REGION_MIN_Z, 0.0f);
+    glm::vec4 regionInverseRange(PARTICLE_REGION_INVERSE_RANGE_X, PARTICLE_REGION_INVERSE_RANGE_Y, PARTICLE_REGION_INVERSE_RANGE_Z, 0.0f);
+    return PositionToMortonCode2D(pos, regionMin, regionInverseRange);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    The CPU version of PositionToMortonCode(...) in PositionToMortonCode2D.comp that takes the 
+    region to normalize against.  This is what the GPU does when it uses the scene bounds (see 
+    SceneBoundsLayout.comp), so the GPU's keys can be checked against the bounds that it read 
+    back (see SceneBounds).
+Parameters: 
+    pos                 Self-explanatory.  Z and W are ignored.
+    regionMin           Where each axis starts (W is ignored).
+    regionInverseRange  1 / the length of each axis (W is ignored).
+Returns:    
+    A 32bit Morton Code.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int PositionToMortonCode2D(const glm::vec4 &pos, const glm::vec4 &regionMin, 
+    const glm::vec4 &regionInverseRange)
+{
+    unsigned int x = CoordinateToInteger(pos.x, regionMin.x, regionInverseRange.x, 65536.0f);
+    unsigned int y = CoordinateToInteger(pos.y, regionMin.y, regionInverseRange.y, 65536.0f);
+    return (ExpandBits2D(x) << 1) | ExpandBits2D(y);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    The CPU version of PositionToMortonCode(...) in PositionToMortonCode64.comp.  The shader 
+    builds the code in three pieces because of the uvec2.  This does the same so that the two 
+    are easy to compare.
+Parameters: 
+    pos     Self-explanatory.  W is ignored.
+Returns:    
+    A 63bit Morton Code.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+unsigned long long PositionToMortonCode3D64(const glm::vec4 &pos)
+{
+    unsigned int x = CoordinateToInteger(pos.x, PARTICLE_REGION_MIN_X, PARTICLE_REGION_INVERSE_RANGE_X, 2097152.0f);
+    unsigned int y = CoordinateToInteger(pos.y, PARTICLE_REGION_MIN_Y, PARTICLE_REGION_INVERSE_RANGE_Y, 2097152.0f);
+    unsigned int z = CoordinateToInteger(pos.z, PARTICLE_REGION_MIN_Z, PARTICLE_REGION_INVERSE_RANGE_Z, 2097152.0f);
+
+    unsigned long long lowBits = (ExpandBits3D(x & 0x3FF) * 4) + (ExpandBits3D(y & 0x3FF) * 2) + ExpandBits3D(z & 0x3FF);
+    unsigned long long middleBits = (ExpandBits3D((x >> 10) & 0x3FF) * 4) + (ExpandBits3D((y >> 10) & 0x3FF) * 2) + ExpandBits3D((z >> 10) & 0x3FF);
+    unsigned long long highBits = ((x >> 20) * 4) + ((y >> 20) * 2) + (z >> 20);
+    return lowBits | (middleBits << 30) | (highBits << 60);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    The CPU version of PositionToMortonCode(...) in PositionToMortonCode2D64.comp.
+Parameters: 
+    pos     Self-explanatory.  Z and W are ignored.
+Returns:    
+    A 64bit Morton Code.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+unsigned long long PositionToMortonCode2D64(const glm::vec4 &pos)
+{
+    unsigned int x = CoordinateToIntegerDouble(pos.x, PARTICLE_REGION_MIN_X, PARTICLE_REGION_INVERSE_RANGE_X, 4294967296.0);
+    unsigned int y = CoordinateToIntegerDouble(pos.y, PARTICLE_REGION_MIN_Y, PARTICLE_REGION_INVERSE_RANGE_Y, 4294967296.0);
+
+    unsigned long long lowHalf = (ExpandBits2D(x) << 1) | ExpandBits2D(y);
+    unsigned long long highHalf = (ExpandBits2D(x >> 16) << 1) | ExpandBits2D(y >> 16);
+    return lowHalf | (highHalf << 32);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    The CPU version of PositionToMortonCode(...) in PositionToHilbertCode2D.comp.  See there 
+    for how it works.
+Parameters: 
+    pos     Self-explanatory.  Z and W are ignored.
+Returns:    
+    A 32bit Hilbert code.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int PositionToHilbertCode2D(const glm::vec4 &pos)
+{
+    unsigned int x = CoordinateToInteger(pos.x, PARTICLE_REGION_MIN_X, PARTICLE_REGION_INVERSE_RANGE_X, 65536.0f);
+    unsigned int y = CoordinateToInteger(pos.y, PARTICLE_REGION_MIN_Y, PARTICLE_REGION_INVERSE_RANGE_Y, 65536.0f);
+
+    unsigned int hilbertCode = 0;
+    for (unsigned int cellSize = 1u << 15; cellSize > 0; cellSize >>= 1)
+    {
+        unsigned int quadrantX = ((x & cellSize) != 0) ? 1 : 0;
+        unsigned int quadrantY = ((y & cellSize) != 0) ? 1 : 0;
+        hilbertCode += cellSize * cellSize * ((3 * quadrantX) ^ quadrantY);
+        if (quadrantY == 0)
+        {
+            if (quadrantX == 1)
+            {
+                x = 0xFFFF - x;
+                y = 0xFFFF - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return hilbertCode;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Calls whichever of the encoders is asked for.  The 32bit codes are widened so that they 
+    can all be treated the same.
+Parameters: 
+    pos         Self-explanatory.
+    encoding    Self-explanatory.
+Returns:    
+    The Morton Code.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+unsigned long long PositionToMortonCode(const glm::vec4 &pos, MortonCodeEncoding encoding)
+{
+    switch (encoding)
+    {
+    case MortonCodeEncoding::MORTON_CODE_3D_10_BITS:
+        return PositionToMortonCode3D(pos);
+    case MortonCodeEncoding::MORTON_CODE_3D_21_BITS_64:
+        return PositionToMortonCode3D64(pos);
+    case MortonCodeEncoding::MORTON_CODE_2D_32_BITS_64:
+        return PositionToMortonCode2D64(pos);
+    case MortonCodeEncoding::HILBERT_CODE_2D_16_BITS:
+        return PositionToHilbertCode2D(pos);
+    default:
+        return PositionToMortonCode2D(pos);
+    }
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Turns a 3D Morton Code back into a position.  The code only says which cell of the 
+    1024x1024x1024 grid the position was in, so this gives the center of that cell.
+Parameters: 
+    mortonCode  Self-explanatory.
+Returns:    
+    The position, with W = 1.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+glm::vec4 MortonCode3DToPosition(unsigned int mortonCode)
+{
+    unsigned int x = CompactBits3D(mortonCode >> 2);
+    unsigned int y = CompactBits3D(mortonCode >> 1);
+    unsigned int z = CompactBits3D(mortonCode);
+    return glm::vec4(
+        IntegerToCoordinate(x, PARTICLE_REGION_MIN_X, PARTICLE_REGION_RANGE_X, 1024.0f),
+        IntegerToCoordinate(y, PARTICLE_REGION_MIN_Y, PARTICLE_REGION_RANGE_Y, 1024.0f),
+        IntegerToCoordinate(z, PARTICLE_REGION_MIN_Z, PARTICLE_REGION_RANGE_Z, 1024.0f),
+        1.0f);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Turns a 2D Morton Code back into a position.  The code only says which cell of the 
+    65536x65536 grid the position was in, so this gives the center of that cell.
+Parameters: 
+    mortonCode  Self-explanatory.
+Returns:    
+    The position, with Z = 0 and W = 1.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+glm::vec4 MortonCode2DToPosition(unsigned int mortonCode)
+{
+    unsigned int x = CompactBits2D(mortonCode >> 1);
+    unsigned int y = CompactBits2D(mortonCode);
+    return glm::vec4(
+        IntegerToCoordinate(x, PARTICLE_REGION_MIN_X, PARTICLE_REGION_RANGE_X, 65536.0f),
+        IntegerToCoordinate(y, PARTICLE_REGION_MIN_Y, PARTICLE_REGION_RANGE_Y, 65536.0f),
+        0.0f,
+        1.0f);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Turns a 63bit 3D Morton Code back into a position.  Undoes PositionToMortonCode3D64(...) 
+    one piece at a time.
+Parameters: 
+    mortonCode  Self-explanatory.
+Returns:    
+    The center of the code's cell in the 2^21 x 2^21 x 2^21 grid, with W = 1.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+glm::vec4 MortonCode3D64ToPosition(unsigned long long mortonCode)
+{
+    unsigned int lowBits = static_cast<unsigned int>(mortonCode & 0x3FFFFFFFull);
+    unsigned int middleBits = static_cast<unsigned int>((mortonCode >> 30) & 0x3FFFFFFFull);
+    unsigned int highBits = static_cast<unsigned int>(mortonCode >> 60);
+    unsigned int x = CompactBits3D(lowBits >> 2) | (CompactBits3D(middleBits >> 2) << 10) | (((highBits >> 2) & 1) << 20);
+    unsigned int y = CompactBits3D(lowBits >> 1) | (CompactBits3D(middleBits >> 1) << 10) | (((highBits >> 1) & 1) << 20);
+    unsigned int z = CompactBits3D(lowBits) | (CompactBits3D(middleBits) << 10) | ((highBits & 1) << 20);
+    return glm::vec4(
+        IntegerToCoordinateDouble(x, PARTICLE_REGION_MIN_X, PARTICLE_REGION_RANGE_X, 2097152.0),
+        IntegerToCoordinateDouble(y, PARTICLE_REGION_MIN_Y, PARTICLE_REGION_RANGE_Y, 2097152.0),
+        IntegerToCoordinateDouble(z, PARTICLE_REGION_MIN_Z, PARTICLE_REGION_RANGE_Z, 2097152.0),
+        1.0f);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Turns a 64bit 2D Morton Code back into a position.  See the note in 
+    IntegerToCoordinateDouble(...) about precision.
+Parameters: 
+    mortonCode  Self-explanatory.
+Returns:    
+    The center of the code's cell in the 2^32 x 2^32 grid, with Z = 0 and W = 1.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+glm::vec4 MortonCode2D64ToPosition(unsigned long long mortonCode)
+{
+    unsigned int lowHalf = static_cast<unsigned int>(mortonCode);
+    unsigned int highHalf = static_cast<unsigned int>(mortonCode >> 32);
+    unsigned int x = CompactBits2D(lowHalf >> 1) | (CompactBits2D(highHalf >> 1) << 16);
+    unsigned int y = CompactBits2D(lowHalf) | (CompactBits2D(highHalf) << 16);
+    return glm::vec4(
+        IntegerToCoordinateDouble(x, PARTICLE_REGION_MIN_X, PARTICLE_REGION_RANGE_X, 4294967296.0),
+        IntegerToCoordinateDouble(y, PARTICLE_REGION_MIN_Y, PARTICLE_REGION_RANGE_Y, 4294967296.0),
+        0.0f,
+        1.0f);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Turns a 2D Hilbert code back into a position.  This is the usual "d2xy" loop, which goes 
+    from the bottom level up, undoing the rotations as it goes (see 
+    PositionToHilbertCode2D.comp).
+Parameters: 
+    hilbertCode     Self-explanatory.
+Returns:    
+    The center of the code's cell in the 65536x65536 grid, with Z = 0 and W = 1.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+glm::vec4 HilbertCode2DToPosition(unsigned int hilbertCode)
+{
+    unsigned int x = 0;
+    unsigned int y = 0;
+    unsigned int remainingCode = hilbertCode;
+    for (unsigned int cellSize = 1; cellSize < 65536; cellSize <<= 1)
+    {
+        unsigned int quadrantX = 1 & (remainingCode >> 1);
+        unsigned int quadrantY = 1 & (remainingCode ^ quadrantX);
+
+        // at this level, only the cells so far are in the quadrant, so flip within them
+        if (quadrantY == 0)
+        {
+            if (quadrantX == 1)
+            {
+                x = cellSize - 1 - x;
+                y = cellSize - 1 - y;
+            }
+            std::swap(x, y);
+        }
+        x += cellSize * quadrantX;
+        y += cellSize * quadrantY;
+        remainingCode >>= 2;
+    }
+    return glm::vec4(
+        IntegerToCoordinate(x, PARTICLE_REGION_MIN_X, PARTICLE_REGION_RANGE_X, 65536.0f),
+        IntegerToCoordinate(y, PARTICLE_REGION_MIN_Y, PARTICLE_REGION_RANGE_Y, 65536.0f),
+        0.0f,
+        1.0f);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Calls whichever of the decoders is asked for.
+Parameters: 
+    mortonCode  Self-explanatory.  32bit codes only use the low bits.
+    encoding    Self-explanatory.
+Returns:    
+    The position.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+glm::vec4 MortonCodeToPosition(unsigned long long mortonCode, MortonCodeEncoding encoding)
+{
+    switch (encoding)
+    {
+    case MortonCodeEncoding::MORTON_CODE_3D_10_BITS:
+        return MortonCode3DToPosition(static_cast<unsigned int>(mortonCode));
+    case MortonCodeEncoding::MORTON_CODE_3D_21_BITS_64:
+        return MortonCode3D64ToPosition(mortonCode);
+    case MortonCodeEncoding::MORTON_CODE_2D_32_BITS_64:
+        return MortonCode2D64ToPosition(mortonCode);
+    case MortonCodeEncoding::HILBERT_CODE_2D_16_BITS:
+        return HilbertCode2DToPosition(static_cast<unsigned int>(mortonCode));
+    default:
+        return MortonCode2DToPosition(static_cast<unsigned int>(mortonCode));
+    }
+}
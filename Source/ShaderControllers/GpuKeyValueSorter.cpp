@@ -0,0 +1,1372 @@
+#include "Include/ShaderControllers/GpuKeyValueSorter.h"
+
+#include "Shaders/ShaderStorage.h"
+#include "ThirdParty/glload/include/glload/gl_4_4.h"
+
+// for profiling and checking results
+#include "Include/ShaderControllers/ProfilingWaitToFinish.h"
+
+#include "Shaders/ShaderHeaders/ComputeShaderWorkGroupSizes.comp"
+#include "Shaders/ShaderHeaders/CrossShaderUniformLocations.comp"
+#include "Shaders/ShaderHeaders/SsboBufferBindings.comp"
+#include "Shaders/Compute/ParticleCollisions/RadixSortDigitSize.comp"
+#include "Shaders/Compute/ParticleCollisions/RadixSortPassPlanLayout.comp"
+#include "Shaders/Compute/ParticleCollisions/IncrementalSortLayout.comp"
+#include "Shaders/Compute/ParticleCollisions/SharedMemorySortLayout.comp"
+#include "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+using std::cout;
+using std::endl;
+
+
+namespace ShaderControllers
+{
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Gives members initial values, allocates the scratch buffers, and generates the compute
+        shaders for every sort that this sorter can do.
+    Parameters:
+        maxNumItems     The most key-value pairs that will ever be sorted at once.  The
+                        ParticleSortingDataSsbo that is handed to Sort(...) is expected to have
+                        been created with the same number (it holds 2x that many pairs).
+        keyWidth        The width of the keys that this sorter's shaders are assembled for.
+                        The ParticleSortingDataSsbo is expected to have the same width.
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    GpuKeyValueSorter::GpuKeyValueSorter(unsigned int maxNumItems, SortingKeyWidth keyWidth) :
+        _maxNumItems(maxNumItems),
+        _keyWidth(keyWidth),
+        _algorithm((maxNumItems <= SHARED_MEMORY_SORT_MAX_ITEMS) ?
+            Algorithm::SHARED_MEMORY_SORT : Algorithm::RADIX_SORT_MULTI_BIT),
+        _useIncrementalSort(true),
+        _programIdGetSortingDataBitMasks(0),
+        _programIdMeasureSortingDataDisorder(0),
+        _programIdPlanIncrementalSort(0),
+        _programIdSortSortingDataTiles(0),
+        _programIdPlanRadixSortPasses(0),
+        _programIdGetBitForPrefixScan(0),
+        _programIdPrefixScanOverAllData(0),
+        _programIdSortSortingDataWithPrefixSums(0),
+        _programIdGetDigitCountsForPrefixScan(0),
+        _programIdSortSortingDataWithDigitPrefixSums(0),
+        _programIdSortSortingDataInSharedMemory(0),
+        _prefixSumSsbo(maxNumItems),
+        _prefixScanLookBackSsbo(maxNumItems),
+        _radixSortPassPlanSsbo()
+    {
+        AssembleProgramGetSortingDataBitMasks();
+        AssembleProgramMeasureSortingDataDisorder();
+        AssembleProgramPlanIncrementalSort();
+        AssembleProgramSortSortingDataTiles();
+        AssembleProgramPlanRadixSortPasses();
+        AssembleProgramGetBitForPrefixScan();
+        AssembleProgramPrefixScanOverAllData();
+        AssembleProgramSortSortingDataWithPrefixSums();
+        AssembleProgramGetDigitCountsForPrefixScan();
+        AssembleProgramSortSortingDataWithDigitPrefixSums();
+        AssembleProgramSortSortingDataInSharedMemory();
+
+        _prefixSumSsbo.ConfigureConstantUniforms(_programIdGetBitForPrefixScan);
+        _prefixSumSsbo.ConfigureConstantUniforms(_programIdPrefixScanOverAllData);
+        _prefixSumSsbo.ConfigureConstantUniforms(_programIdSortSortingDataWithPrefixSums);
+        _prefixSumSsbo.ConfigureConstantUniforms(_programIdGetDigitCountsForPrefixScan);
+        _prefixSumSsbo.ConfigureConstantUniforms(_programIdSortSortingDataWithDigitPrefixSums);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Cleans up shader programs that were created for this sorter.  The SSBOs clean
+        themselves up.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    GpuKeyValueSorter::~GpuKeyValueSorter()
+    {
+        glDeleteProgram(_programIdGetSortingDataBitMasks);
+        glDeleteProgram(_programIdMeasureSortingDataDisorder);
+        glDeleteProgram(_programIdPlanIncrementalSort);
+        glDeleteProgram(_programIdSortSortingDataTiles);
+        glDeleteProgram(_programIdPlanRadixSortPasses);
+        glDeleteProgram(_programIdGetBitForPrefixScan);
+        glDeleteProgram(_programIdPrefixScanOverAllData);
+        glDeleteProgram(_programIdSortSortingDataWithPrefixSums);
+        glDeleteProgram(_programIdGetDigitCountsForPrefixScan);
+        glDeleteProgram(_programIdSortSortingDataWithDigitPrefixSums);
+        glDeleteProgram(_programIdSortSortingDataInSharedMemory);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Chooses which sort runs on the next call to Sort(...).  They all leave the sorted data
+        in the same place, so they can be swapped at any time to compare them.
+
+        Note: If the shared memory sort is requested but the sorter was made for too many items,
+        this complains to stderr and keeps the current sort.
+    Parameters:
+        algorithm   Self-explanatory.
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void GpuKeyValueSorter::SetAlgorithm(Algorithm algorithm)
+    {
+        if (algorithm == Algorithm::SHARED_MEMORY_SORT && _maxNumItems > SHARED_MEMORY_SORT_MAX_ITEMS)
+        {
+            fprintf(stderr, "GpuKeyValueSorter: %u items is too many for the shared memory sort (max %u)\n",
+                _maxNumItems, SHARED_MEMORY_SORT_MAX_ITEMS);
+            return;
+        }
+
+        _algorithm = algorithm;
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Turns the incremental sort (see IncrementalSortLayout.comp) on or off for the next call
+        to Sort(...).  When it is on, the radix sort chosen by SetAlgorithm(...) only runs as
+        the fallback.  When it is off, the radix sort runs every time.
+
+        Note: The incremental sort only pays off if the pairs come in nearly sorted (last
+        frame's order, for example).  For data that is shuffled every time, turn it off.
+    Parameters:
+        useIncrementalSort  Self-explanatory.
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void GpuKeyValueSorter::SetIncrementalSort(bool useIncrementalSort)
+    {
+        _useIncrementalSort = useIncrementalSort;
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        A simple getter for the value that was passed in on creation.
+    Parameters: None
+    Returns:
+        See Description.
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    unsigned int GpuKeyValueSorter::MaxNumItems() const
+    {
+        return _maxNumItems;
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        A simple getter for the value that was passed in on creation.
+    Parameters: None
+    Returns:
+        See Description.
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    SortingKeyWidth GpuKeyValueSorter::KeyWidth() const
+    {
+        return _keyWidth;
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Gives a shader that reads or writes the PrefixScanBuffer the size uniforms for this
+        sorter's prefix scan buffer (see PrefixSumSsbo).  Any shader that fills out the prefix
+        scan for PrefixScanOverAllItems() or PrefixScanIndirect(...), or that reads the sums
+        afterwards, needs this once after it is linked.
+    Parameters:
+        computeProgramId    Self-explanatory.
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void GpuKeyValueSorter::ConfigurePrefixScanUniforms(unsigned int computeProgramId) const
+    {
+        _prefixSumSsbo.ConfigureConstantUniforms(computeProgramId);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Binds the prefix scan buffer and the prefix scan look-back buffer to their binding
+        points.  Sort(...) does this too, so this is for a prefix scan that runs before the
+        first sort or after one.
+
+        Note: The look-back buffer keeps track of which set of status flags the next prefix
+        scan uses (see PrefixScanLookBackBuffer.comp), and every prefix scan leaves it ready
+        for the next one, so it doesn't matter whether the last one was for the sort or not.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void GpuKeyValueSorter::BindPrefixScanBuffers() const
+    {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PREFIX_SCAN_BUFFER_BINDING, _prefixSumSsbo.BufferId());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PREFIX_SCAN_LOOK_BACK_BUFFER_BINDING, _prefixScanLookBackSsbo.BufferId());
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Runs the prefix scan over all MaxNumItems() items in the PrefixScanBuffer.  This is for
+        a scan whose item count is only known on the GPU, like the active flags for stream
+        compaction.  Items past the real count are expected to be 0, so they cost a read and
+        nothing else.
+
+        Note: Expects BindPrefixScanBuffers() (or a Sort(...)) since the last time anything
+        else was bound to the prefix scan binding points.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void GpuKeyValueSorter::PrefixScanOverAllItems() const
+    {
+        // 2 items per thread (see PREFIX_SCAN_ITEMS_PER_WORK_GROUP)
+        unsigned int numItems = _prefixSumSsbo.NumDataEntries();
+        unsigned int numWorkGroupsX = numItems / PREFIX_SCAN_ITEMS_PER_WORK_GROUP;
+        unsigned int remainder = numItems % PREFIX_SCAN_ITEMS_PER_WORK_GROUP;
+        numWorkGroupsX += (remainder == 0) ? 0 : 1;
+
+        glUseProgram(_programIdPrefixScanOverAllData);
+        glDispatchCompute(numWorkGroupsX, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Runs the prefix scan with a work group count that was written on the GPU.  Same as
+        PrefixScanOverAllItems() otherwise.
+
+        Note: Expects whichever buffer holds the dispatch command to be bound to
+        GL_DISPATCH_INDIRECT_BUFFER.
+    Parameters:
+        dispatchCommandByteOffset   Where in that buffer the dispatch command is.
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void GpuKeyValueSorter::PrefixScanIndirect(unsigned int dispatchCommandByteOffset) const
+    {
+        glUseProgram(_programIdPrefixScanOverAllData);
+        glDispatchComputeIndirect(dispatchCommandByteOffset);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Sorts the first numActiveParticles key-value pairs (see ActiveParticlesBuffer.comp) in
+        the first half of the given SSBO by key, smallest to largest.  The sorted pairs end up
+        back in the first half.  Nothing is read back, so this doesn't stall the pipeline.
+
+        The steps are as follows:
+        (1) if the incremental sort is on, repair the nearly-sorted order that the pairs came
+            in with (see IncrementalSortLayout.comp)
+        (2) OR and AND every key together and plan which radix sort passes are necessary (bits
+            that are the same in every key don't need sorting, and none are necessary if the
+            incremental sort worked)
+        (3) loop bits 0-31 (or 0-63 for 64-bit keys; passes that weren't planned are
+            dispatched with 0 work groups)
+            (a) get next bit for prefix scan
+            (b) prefix scan over all sorting data (single pass; see
+                PrefixScanLookBackBuffer.comp)
+            (c) sort sorting data with prefix sums
+            Or, with the multi-bit sort, loop over the same bits RADIX_SORT_BITS_PER_DIGIT at a
+            time
+            (a) sort each work group's data locally by the digit and count the digits
+            (b) prefix scan over the digit counts
+            (c) sort sorting data with the digit prefix sums
+        Or, with the shared memory sort, skip all that and sort everything in one dispatch (see
+        SharedMemorySortLayout.comp).
+
+        Note: Only the keys are looked at.  The sort treats the value as a passenger.
+    Parameters:
+        keyValueSsbo    The pairs are in the first half.  The second half is scratch space.
+        itemCountSsbo   How many pairs to sort and the indirect dispatch commands for that
+                        many (see ActiveParticlesLayout.comp).  Expected to be no more than
+                        MaxNumItems().
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void GpuKeyValueSorter::Sort(const ParticleSortingDataSsbo &keyValueSsbo,
+        const ActiveParticlesSsbo &itemCountSsbo) const
+    {
+        if (!BindBuffers(keyValueSsbo, itemCountSsbo))
+        {
+            return;
+        }
+
+        if (_algorithm == Algorithm::SHARED_MEMORY_SORT)
+        {
+            // the whole sort is one dispatch, so there are no passes for the incremental sort
+            // or the planner to save
+            SortSortingDataInSharedMemory();
+            glUseProgram(0);
+            return;
+        }
+
+        if (_useIncrementalSort)
+        {
+            IncrementalSort(itemCountSsbo);
+        }
+        PlanRadixSortPasses(itemCountSsbo);
+
+        // parallel radix sorting algorithm over each bit of the keys
+        // Note: The planner drops passes over bits that don't change, so there is no need to
+        // know ahead of time how many bits the keys actually use.
+        unsigned int totalBitCount = KeyNumBits();
+
+        // the multi-bit sort does the same thing, but several bits at a time
+        // Note: The prefix scan in the multi-bit sort is over the per-work-group digit counts
+        // (much smaller than the sorting data), so it has its own work group count.
+        bool useMultiBitSort = (_algorithm == Algorithm::RADIX_SORT_MULTI_BIT);
+        unsigned int bitsPerPass = useMultiBitSort ? RADIX_SORT_BITS_PER_DIGIT : 1;
+        unsigned int totalPassCount = totalBitCount / bitsPerPass;
+
+        // PlanRadixSortPasses.comp decided which passes actually need to run and gave the rest
+        // dispatch commands with 0 work groups, so every pass can be issued without the CPU
+        // needing to know which ones will do anything
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, _radixSortPassPlanSsbo.BufferId());
+        bool writeToSecondBuffer = true;
+        for (unsigned int passNumber = 0; passNumber < totalPassCount; passNumber++)
+        {
+            unsigned int sortingDataReadBufferOffset = static_cast<unsigned int>(!writeToSecondBuffer) * _maxNumItems;
+            unsigned int sortingDataWriteBufferOffset = static_cast<unsigned int>(writeToSecondBuffer) * _maxNumItems;
+
+            if (useMultiBitSort)
+            {
+                PrepareForDigitPrefixScan(passNumber, sortingDataReadBufferOffset);
+                PrefixScanOverSortingData(passNumber);
+                SortSortingDataWithDigitPrefixScan(passNumber, sortingDataReadBufferOffset, sortingDataWriteBufferOffset);
+            }
+            else
+            {
+                PrepareForPrefixScan(passNumber, sortingDataReadBufferOffset);
+                PrefixScanOverSortingData(passNumber);
+                SortSortingDataWithPrefixScan(passNumber, sortingDataReadBufferOffset, sortingDataWriteBufferOffset);
+            }
+
+            // swap read/write buffers and do it again
+            writeToSecondBuffer = !writeToSecondBuffer;
+        }
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+
+        // the planner always plans an even number of passes, so the sorting data's final
+        // location is always the first half of the sorting data buffer
+        glUseProgram(0);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Like Sort(...), but with
+        (1) std::chrono calls
+        (2) forced wait for shader to finish so that the std::chrono calls get an accurate
+            reading for how long the shader takes
+        (3) verification against the CPU reference sort (see MatchesCpuSort(...))
+        (4) writing the output to stdout and to a file
+
+        This is the benchmark.  Anything that uses the sorter can call this instead of Sort(...)
+        to see how the sort is doing on its data.
+    Parameters:
+        keyValueSsbo    See Sort(...).
+        itemCountSsbo   See Sort(...).
+    Returns:
+        The total sorting time in microseconds (not counting the readbacks or the
+        verification).
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    long long GpuKeyValueSorter::SortWithProfiling(const ParticleSortingDataSsbo &keyValueSsbo,
+        const ActiveParticlesSsbo &itemCountSsbo) const
+    {
+        if (!BindBuffers(keyValueSsbo, itemCountSsbo))
+        {
+            return 0;
+        }
+
+        bool useSharedMemorySort = (_algorithm == Algorithm::SHARED_MEMORY_SORT);
+        bool useMultiBitSort = (_algorithm == Algorithm::RADIX_SORT_MULTI_BIT);
+        unsigned int bitsPerPass = useMultiBitSort ? RADIX_SORT_BITS_PER_DIGIT : 1;
+        unsigned int totalBitCount = KeyNumBits();
+
+        // the shared memory sort has no passes, so the per-pass loop below is skipped
+        unsigned int totalPassCount = useSharedMemorySort ? 0 : (totalBitCount / bitsPerPass);
+
+        // the CPU reference needs the pairs as they were before the sort
+        // Note: This readback stalls the pipeline, which is fine when profiling but is why
+        // Sort(...) never asks.
+        std::vector<ParticleSortingData64> unsortedKeyValuePairs = ReadKeyValuePairs(keyValueSsbo, itemCountSsbo);
+        unsigned int numItems = static_cast<unsigned int>(unsortedKeyValuePairs.size());
+        if (useSharedMemorySort)
+        {
+            cout << "sorting " << numItems << " items in shared memory" << endl;
+        }
+        else
+        {
+            cout << "sorting " << numItems << " " << totalBitCount << "-bit keys " << bitsPerPass << " bit(s) at a time" << endl;
+        }
+
+        // for profiling
+        using namespace std::chrono;
+        steady_clock::time_point start;
+        steady_clock::time_point end;
+        long long durationPlanRadixSortPasses = 0;
+        long long durationIncrementalSort = 0;
+        long long durationSharedMemorySort = 0;
+        long long durationSortVerification = 0;
+        std::vector<long long> durationsPrepareForPrefixScan(totalPassCount);
+        std::vector<long long> durationsPrefixScan(totalPassCount);
+        std::vector<long long> durationsSortSortingData(totalPassCount);
+
+        if (useSharedMemorySort)
+        {
+            start = high_resolution_clock::now();
+            SortSortingDataInSharedMemory();
+            WaitForComputeToFinish();
+            end = high_resolution_clock::now();
+            durationSharedMemorySort = duration_cast<microseconds>(end - start).count();
+        }
+        else
+        {
+            if (_useIncrementalSort)
+            {
+                start = high_resolution_clock::now();
+                IncrementalSort(itemCountSsbo);
+                WaitForComputeToFinish();
+                end = high_resolution_clock::now();
+                durationIncrementalSort = duration_cast<microseconds>(end - start).count();
+            }
+
+            start = high_resolution_clock::now();
+            PlanRadixSortPasses(itemCountSsbo);
+            WaitForComputeToFinish();
+            end = high_resolution_clock::now();
+            durationPlanRadixSortPasses = duration_cast<microseconds>(end - start).count();
+        }
+
+        // how many passes did the planner decide were necessary, and how often has the
+        // incremental sort had to fall back on the radix sort?
+        unsigned int numActivePasses = 0;
+        unsigned int incrementalSortCounters[INCREMENTAL_SORT_NUM_COUNTERS] = { 0 };
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _radixSortPassPlanSsbo.BufferId());
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, _radixSortPassPlanSsbo.NumActivePassesByteOffset(), sizeof(unsigned int), &numActivePasses);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, _radixSortPassPlanSsbo.IncrementalSortCountersByteOffset(), sizeof(incrementalSortCounters), incrementalSortCounters);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        unsigned int numIncrementalSorts = incrementalSortCounters[1];
+        unsigned int numIncrementalSortsOverThreshold = incrementalSortCounters[2];
+        unsigned int numIncrementalSortFallbacks = incrementalSortCounters[3];
+
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, _radixSortPassPlanSsbo.BufferId());
+        bool writeToSecondBuffer = true;
+        for (unsigned int passNumber = 0; passNumber < totalPassCount; passNumber++)
+        {
+            unsigned int sortingDataReadBufferOffset = static_cast<unsigned int>(!writeToSecondBuffer) * _maxNumItems;
+            unsigned int sortingDataWriteBufferOffset = static_cast<unsigned int>(writeToSecondBuffer) * _maxNumItems;
+
+            start = high_resolution_clock::now();
+            if (useMultiBitSort)
+            {
+                PrepareForDigitPrefixScan(passNumber, sortingDataReadBufferOffset);
+            }
+            else
+            {
+                PrepareForPrefixScan(passNumber, sortingDataReadBufferOffset);
+            }
+            WaitForComputeToFinish();
+            end = high_resolution_clock::now();
+            durationsPrepareForPrefixScan[passNumber] = duration_cast<microseconds>(end - start).count();
+
+            start = high_resolution_clock::now();
+            PrefixScanOverSortingData(passNumber);
+            WaitForComputeToFinish();
+            end = high_resolution_clock::now();
+            durationsPrefixScan[passNumber] = duration_cast<microseconds>(end - start).count();
+
+            start = high_resolution_clock::now();
+            if (useMultiBitSort)
+            {
+                SortSortingDataWithDigitPrefixScan(passNumber, sortingDataReadBufferOffset, sortingDataWriteBufferOffset);
+            }
+            else
+            {
+                SortSortingDataWithPrefixScan(passNumber, sortingDataReadBufferOffset, sortingDataWriteBufferOffset);
+            }
+            WaitForComputeToFinish();
+            end = high_resolution_clock::now();
+            durationsSortSortingData[passNumber] = duration_cast<microseconds>(end - start).count();
+
+            // swap read/write buffers and do it again
+            writeToSecondBuffer = !writeToSecondBuffer;
+        }
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+
+        // verify sorted data
+        // Note: An even number of passes always leaves the sorting data in the first half.
+        start = high_resolution_clock::now();
+        std::vector<ParticleSortingData64> sortedKeyValuePairs = ReadKeyValuePairs(keyValueSsbo, itemCountSsbo);
+        bool sortIsCorrect = MatchesCpuSort(unsortedKeyValuePairs, sortedKeyValuePairs);
+        end = high_resolution_clock::now();
+        durationSortVerification = duration_cast<microseconds>(end - start).count();
+
+        long long totalSortingTime = durationPlanRadixSortPasses + durationIncrementalSort + durationSharedMemorySort;
+        for (unsigned int passCounter = 0; passCounter < totalPassCount; passCounter++)
+        {
+            totalSortingTime += durationsPrepareForPrefixScan[passCounter];
+            totalSortingTime += durationsPrefixScan[passCounter];
+            totalSortingTime += durationsSortSortingData[passCounter];
+        }
+
+        // report results
+        // Note: Write the results to a tab-delimited text file so that I can dump them into an
+        // Excel spreadsheet.
+        std::ofstream outFile("ParallelSortDurations.txt");
+        if (outFile.is_open())
+        {
+            if (useSharedMemorySort)
+            {
+                cout << "shared memory sort" << endl;
+                outFile << "shared memory sort" << endl;
+            }
+            else
+            {
+                cout << "bits per radix sort pass: " << bitsPerPass << endl;
+                outFile << "bits per radix sort pass: " << bitsPerPass << endl;
+            }
+
+            cout << "items: " << numItems << " of " << _maxNumItems << endl;
+            outFile << "items: " << numItems << " of " << _maxNumItems << endl;
+
+            cout << "key bits: " << totalBitCount << endl;
+            outFile << "key bits: " << totalBitCount << endl;
+
+            if (!useSharedMemorySort)
+            {
+                cout << "active radix sort passes: " << numActivePasses << " of " << totalPassCount << endl;
+                outFile << "active radix sort passes: " << numActivePasses << " of " << totalPassCount << endl;
+            }
+
+            if (_useIncrementalSort && !useSharedMemorySort)
+            {
+                // Note: The counts are since this sorter was created, not just this sort.
+                cout << "incremental sort fallbacks: " << numIncrementalSortFallbacks << " of " << numIncrementalSorts
+                    << " sorts (" << numIncrementalSortsOverThreshold << " over the disorder threshold)" << endl;
+                outFile << "incremental sort fallbacks: " << numIncrementalSortFallbacks << " of " << numIncrementalSorts
+                    << " sorts (" << numIncrementalSortsOverThreshold << " over the disorder threshold)" << endl;
+            }
+
+            cout << "matches CPU sort: " << (sortIsCorrect ? "yes" : "NO") << endl;
+            outFile << "matches CPU sort: " << (sortIsCorrect ? "yes" : "NO") << endl;
+
+            cout << "total sorting time: " << totalSortingTime << "\tmicroseconds" << endl;
+            outFile << "total sorting time: " << totalSortingTime << "\tmicroseconds" << endl;
+
+            cout << "sort verification: " << durationSortVerification << "\tmicroseconds" << endl;
+            outFile << "sort verification: " << durationSortVerification << "\tmicroseconds" << endl;
+
+            cout << "plan radix sort passes: " << durationPlanRadixSortPasses << "\tmicroseconds" << endl;
+            outFile << "plan radix sort passes: " << durationPlanRadixSortPasses << "\tmicroseconds" << endl;
+
+            cout << "incremental sort: " << durationIncrementalSort << "\tmicroseconds" << endl;
+            outFile << "incremental sort: " << durationIncrementalSort << "\tmicroseconds" << endl;
+
+            cout << "shared memory sort: " << durationSharedMemorySort << "\tmicroseconds" << endl;
+            outFile << "shared memory sort: " << durationSharedMemorySort << "\tmicroseconds" << endl;
+
+            cout << endl << "prepare for prefix scan:" << endl;
+            outFile << endl << "prepare for prefix scan:" << endl;
+            for (size_t i = 0; i < durationsPrepareForPrefixScan.size(); i++)
+            {
+                cout << "\t" << durationsPrepareForPrefixScan[i] << "\tmicroseconds" << endl;
+                outFile << "\t" << durationsPrepareForPrefixScan[i] << "\tmicroseconds" << endl;
+            }
+
+            cout << endl << "prefix scan:" << endl;
+            outFile << endl << "prefix scan:" << endl;
+            for (size_t i = 0; i < durationsPrefixScan.size(); i++)
+            {
+                cout << "\t" << durationsPrefixScan[i] << "\tmicroseconds" << endl;
+                outFile << "\t" << durationsPrefixScan[i] << "\tmicroseconds" << endl;
+            }
+
+            cout << endl << "sort sorting data:" << endl;
+            outFile << endl << "sort sorting data:" << endl;
+            for (size_t i = 0; i < durationsSortSortingData.size(); i++)
+            {
+                cout << "\t" << durationsSortSortingData[i] << "\tmicroseconds" << endl;
+                outFile << "\t" << durationsSortSortingData[i] << "\tmicroseconds" << endl;
+            }
+        }
+        outFile.close();
+
+        // all done
+        glUseProgram(0);
+        return totalSortingTime;
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        The CPU reference sort.  A stable sort by key, smallest to largest, which is what the
+        radix sorts do.
+
+        Note: The bitonic sorts (the incremental sort's tiles and the shared memory sort) are
+        not stable, so pairs with equal keys may come out of the GPU in a different order than
+        they come out of this.  See MatchesCpuSort(...).
+    Parameters:
+        keyValuePairs   Sorted in place.
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void GpuKeyValueSorter::SortOnCpu(std::vector<ParticleSortingData64> &keyValuePairs)
+    {
+        std::stable_sort(keyValuePairs.begin(), keyValuePairs.end(),
+            [](const ParticleSortingData64 &a, const ParticleSortingData64 &b)
+        {
+            return a.Key() < b.Key();
+        });
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Checks a GPU sort's output against the CPU reference sort.  The keys have to come out in
+        exactly the same order, and the pairs have to be the same pairs that went in (no pair
+        lost, duplicated, or split from its value).  Pairs with equal keys are allowed to come
+        out in any order (see SortOnCpu(...)).
+
+        Prints the first problem that it finds to stdout.
+    Parameters:
+        unsortedKeyValuePairs   What went into the sort.
+        sortedKeyValuePairs     What came out.
+    Returns:
+        True if the output is a correct sort of the input, otherwise false.
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    bool GpuKeyValueSorter::MatchesCpuSort(const std::vector<ParticleSortingData64> &unsortedKeyValuePairs,
+        const std::vector<ParticleSortingData64> &sortedKeyValuePairs)
+    {
+        if (unsortedKeyValuePairs.size() != sortedKeyValuePairs.size())
+        {
+            printf("sorted %u items, but %u went in\n",
+                static_cast<unsigned int>(sortedKeyValuePairs.size()),
+                static_cast<unsigned int>(unsortedKeyValuePairs.size()));
+            return false;
+        }
+
+        std::vector<ParticleSortingData64> expected(unsortedKeyValuePairs);
+        SortOnCpu(expected);
+        for (size_t i = 0; i < expected.size(); i++)
+        {
+            if (sortedKeyValuePairs[i].Key() != expected[i].Key())
+            {
+                printf("key %llu at index %u should be %llu\n", sortedKeyValuePairs[i].Key(),
+                    static_cast<unsigned int>(i), expected[i].Key());
+                return false;
+            }
+        }
+
+        // the keys match, so now only the values within each run of equal keys can differ
+        auto byKeyThenValue = [](const ParticleSortingData64 &a, const ParticleSortingData64 &b)
+        {
+            return (a.Key() < b.Key()) ||
+                (a.Key() == b.Key() && a._preSortedParticleIndex < b._preSortedParticleIndex);
+        };
+        std::vector<ParticleSortingData64> actual(sortedKeyValuePairs);
+        std::sort(expected.begin(), expected.end(), byKeyThenValue);
+        std::sort(actual.begin(), actual.end(), byKeyThenValue);
+        for (size_t i = 0; i < expected.size(); i++)
+        {
+            if (actual[i]._preSortedParticleIndex != expected[i]._preSortedParticleIndex)
+            {
+                printf("key %llu has value %d, but the CPU sort has %d\n", actual[i].Key(),
+                    actual[i]._preSortedParticleIndex, expected[i]._preSortedParticleIndex);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Every shader that looks at the keys needs either SortingKey32.comp or
+        SortingKey64.comp.  This says which.
+    Parameters:
+        keyWidth    Self-explanatory.
+    Returns:
+        The path to the shader file, relative to the project root like all the others.
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    std::string GpuKeyValueSorter::SortingKeyShaderFilePath(SortingKeyWidth keyWidth)
+    {
+        if (keyWidth == SortingKeyWidth::KEY_64_BIT)
+        {
+            return "Shaders/Compute/ParticleCollisions/SortingKey64.comp";
+        }
+        return "Shaders/Compute/ParticleCollisions/SortingKey32.comp";
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        How many bits the radix sort has to loop over (see SORTING_KEY_NUM_BITS in the
+        SortingKey*.comp files).
+    Parameters: None
+    Returns:
+        32 or 64.
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    unsigned int GpuKeyValueSorter::KeyNumBits() const
+    {
+        return (_keyWidth == SortingKeyWidth::KEY_64_BIT) ? 64 : 32;
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        The GLSL version declaration, compute shader work group sizes,
+        cross-shader uniform locations, and SSBO buffer bindings are used in very compute
+        shader.  This function puts their assembly into one place.
+
+        The sort key's width (see SortingKey32.comp) goes here too because every shader that
+        includes ParticleSortingDataBuffer.comp needs it.
+    Parameters:
+        The key to the composite shader that is under construction.
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void GpuKeyValueSorter::AssembleProgramHeader(const std::string &shaderKey) const
+    {
+        ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ShaderHeaders/Version.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ShaderHeaders/ComputeShaderWorkGroupSizes.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ShaderHeaders/SsboBufferBindings.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ShaderHeaders/CrossShaderUniformLocations.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, SortingKeyShaderFilePath(_keyWidth));
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Assembles headers, buffers, and functional .comp files for the shader that ORs and ANDs
+        all the keys together for the radix sort pass planner.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void GpuKeyValueSorter::AssembleProgramGetSortingDataBitMasks()
+    {
+        ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+
+        std::string shaderKey = "get sorting data bit masks";
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        AssembleProgramHeader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticleSortingDataBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/RadixSortPassPlanLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/RadixSortPassPlanBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ActiveParticlesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/GetSortingDataBitMasks.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        shaderStorageRef.LinkShader(shaderKey);
+        _programIdGetSortingDataBitMasks = shaderStorageRef.GetShaderProgram(shaderKey);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Assembles headers, buffers, and functional .comp files for the shader that counts how 
+        many sorting data neighbors are out of order.
+
+        Part of the incremental sort.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void GpuKeyValueSorter::AssembleProgramMeasureSortingDataDisorder()
+    {
+        ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+
+        std::string shaderKey = "measure sorting data disorder";
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        AssembleProgramHeader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/IncrementalSortLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticleSortingDataBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/RadixSortPassPlanLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/RadixSortPassPlanBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ActiveParticlesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/MeasureSortingDataDisorder.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        shaderStorageRef.LinkShader(shaderKey);
+        _programIdMeasureSortingDataDisorder = shaderStorageRef.GetShaderProgram(shaderKey);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Assembles headers, buffers, and functional .comp files for the shader that decides 
+        whether the incremental sort should try to repair the sorting data.
+
+        Part of the incremental sort.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void GpuKeyValueSorter::AssembleProgramPlanIncrementalSort()
+    {
+        ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+
+        std::string shaderKey = "plan incremental sort";
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        AssembleProgramHeader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/IncrementalSortLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/RadixSortPassPlanLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/RadixSortPassPlanBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ActiveParticlesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/PlanIncrementalSort.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        shaderStorageRef.LinkShader(shaderKey);
+        _programIdPlanIncrementalSort = shaderStorageRef.GetShaderProgram(shaderKey);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Assembles headers, buffers, and functional .comp files for the shader that sorts each 
+        tile of the sorting data in shared memory.
+
+        Part of the incremental sort.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void GpuKeyValueSorter::AssembleProgramSortSortingDataTiles()
+    {
+        ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+
+        std::string shaderKey = "sort sorting data tiles";
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        AssembleProgramHeader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/IncrementalSortLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticleSortingDataBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ActiveParticlesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/SortSortingDataTiles.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        shaderStorageRef.LinkShader(shaderKey);
+        _programIdSortSortingDataTiles = shaderStorageRef.GetShaderProgram(shaderKey);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Assembles headers, buffers, and functional .comp files for the shader that decides which 
+        radix sort passes need to run and writes the indirect dispatch commands for them.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void GpuKeyValueSorter::AssembleProgramPlanRadixSortPasses()
+    {
+        ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+
+        std::string shaderKey = "plan radix sort passes";
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        AssembleProgramHeader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/RadixSortPassPlanLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/RadixSortPassPlanBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ActiveParticlesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/PlanRadixSortPasses.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        shaderStorageRef.LinkShader(shaderKey);
+        _programIdPlanRadixSortPasses = shaderStorageRef.GetShaderProgram(shaderKey);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Assembles headers, buffers, and functional .comp files for the shader that extracts a 
+        single bit from the sorting data for use during the prefix scan.
+
+        Part of the radix sort loop.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 5/2017
+    --------------------------------------------------------------------------------------------*/
+    void GpuKeyValueSorter::AssembleProgramGetBitForPrefixScan()
+    {
+        ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+
+        std::string shaderKey = "get bit for prefix scan";
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        AssembleProgramHeader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticleSortingDataBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/PrefixScanBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/RadixSortPassPlanLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/RadixSortPassPlanBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ActiveParticlesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/GetBitForPrefixScan.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        shaderStorageRef.LinkShader(shaderKey);
+        _programIdGetBitForPrefixScan = shaderStorageRef.GetShaderProgram(shaderKey);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Assembles headers, buffers, and functional .comp files for the shader that runs the 
+        prefix scan (the whole thing, in a single dispatch). 
+
+        Part of the radix sort loop.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 5/2017
+    --------------------------------------------------------------------------------------------*/
+    void GpuKeyValueSorter::AssembleProgramPrefixScanOverAllData()
+    {
+        ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+
+        std::string shaderKey = "prefix scan over all data";
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        AssembleProgramHeader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/PrefixScanBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/PrefixScanLookBackBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/PrefixScanOverAllData.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        shaderStorageRef.LinkShader(shaderKey);
+        _programIdPrefixScanOverAllData = shaderStorageRef.GetShaderProgram(shaderKey);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Assembles headers, buffers, and functional .comp files for the shader that sorts the 
+        sorting data given the results of the prefix scan.
+
+        Part of the radix sort loop.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 5/2017
+    --------------------------------------------------------------------------------------------*/
+    void GpuKeyValueSorter::AssembleProgramSortSortingDataWithPrefixSums()
+    {
+        ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+
+        std::string shaderKey = "sort sorting data with prefix sums";
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        AssembleProgramHeader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticleSortingDataBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/PrefixScanBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/RadixSortPassPlanLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/RadixSortPassPlanBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ActiveParticlesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/SortSortingDataWithPrefixSums.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        shaderStorageRef.LinkShader(shaderKey);
+        _programIdSortSortingDataWithPrefixSums = shaderStorageRef.GetShaderProgram(shaderKey);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Assembles headers, buffers, and functional .comp files for the shader that sorts each 
+        work group's chunk of the sorting data by a multi-bit digit and then counts how many 
+        items have each digit value.
+
+        Part of the multi-bit radix sort loop.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void GpuKeyValueSorter::AssembleProgramGetDigitCountsForPrefixScan()
+    {
+        ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+
+        std::string shaderKey = "get digit counts for prefix scan";
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        AssembleProgramHeader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/RadixSortDigitSize.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticleSortingDataBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/PrefixScanBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/RadixSortPassPlanLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/RadixSortPassPlanBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ActiveParticlesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/GetDigitCountsForPrefixScan.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        shaderStorageRef.LinkShader(shaderKey);
+        _programIdGetDigitCountsForPrefixScan = shaderStorageRef.GetShaderProgram(shaderKey);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Assembles headers, buffers, and functional .comp files for the shader that sorts the 
+        sorting data given the results of the prefix scan over the digit counts.
+
+        Part of the multi-bit radix sort loop.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void GpuKeyValueSorter::AssembleProgramSortSortingDataWithDigitPrefixSums()
+    {
+        ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+
+        std::string shaderKey = "sort sorting data with digit prefix sums";
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        AssembleProgramHeader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/RadixSortDigitSize.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticleSortingDataBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/PrefixScanBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/RadixSortPassPlanLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/RadixSortPassPlanBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ActiveParticlesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/SortSortingDataWithDigitPrefixSums.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        shaderStorageRef.LinkShader(shaderKey);
+        _programIdSortSortingDataWithDigitPrefixSums = shaderStorageRef.GetShaderProgram(shaderKey);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Assembles headers, buffers, and functional .comp files for the shader that sorts all the 
+        sorting data in a single work group.
+
+        Only used when there are few enough items (see SharedMemorySortLayout.comp).
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void GpuKeyValueSorter::AssembleProgramSortSortingDataInSharedMemory()
+    {
+        ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+
+        std::string shaderKey = "sort sorting data in shared memory";
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        AssembleProgramHeader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/SharedMemorySortLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticleSortingDataBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ActiveParticlesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/SortSortingDataInSharedMemory.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        shaderStorageRef.LinkShader(shaderKey);
+        _programIdSortSortingDataInSharedMemory = shaderStorageRef.GetShaderProgram(shaderKey);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Binds the key-value pairs, the item count, and the scratch buffers to the binding
+        points that the sorting shaders expect.  Done at the start of every sort so that nobody
+        else has to leave the binding points alone in between.
+
+        Note: The radix sort ping-pongs between halves of the key-value SSBO, and the second
+        half starts at MaxNumItems(), so the SSBO has to be the size that this sorter was made
+        for.  If it is not, this complains to stderr.  Same for the key width.
+    Parameters:
+        keyValueSsbo    See Sort(...).
+        itemCountSsbo   See Sort(...).
+    Returns:
+        True if the SSBO is the right size and key width and everything was bound, otherwise
+        false.
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    bool GpuKeyValueSorter::BindBuffers(const ParticleSortingDataSsbo &keyValueSsbo,
+        const ActiveParticlesSsbo &itemCountSsbo) const
+    {
+        if (keyValueSsbo.NumItems() != _maxNumItems)
+        {
+            fprintf(stderr, "GpuKeyValueSorter: made for %u items, but the key-value SSBO holds %u\n",
+                _maxNumItems, keyValueSsbo.NumItems());
+            return false;
+        }
+        if (keyValueSsbo.KeyWidth() != _keyWidth)
+        {
+            fprintf(stderr, "GpuKeyValueSorter: the key-value SSBO's keys are not the width that this sorter was made for\n");
+            return false;
+        }
+
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLE_SORTING_DATA_BUFFER_BINDING, keyValueSsbo.BufferId());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, ACTIVE_PARTICLES_BUFFER_BINDING, itemCountSsbo.BufferId());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PREFIX_SCAN_BUFFER_BINDING, _prefixSumSsbo.BufferId());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PREFIX_SCAN_LOOK_BACK_BUFFER_BINDING, _prefixScanLookBackSsbo.BufferId());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, RADIX_SORT_PASS_PLAN_BUFFER_BINDING, _radixSortPassPlanSsbo.BufferId());
+        return true;
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        For profiling and verification.  Reads back the item count and then that many
+        key-value pairs from the first half of the key-value SSBO.  This will stall the
+        pipeline, so don't do it otherwise.
+
+        32-bit keys are copied into ParticleSortingData64 with the high half 0 so that the CPU
+        reference only has to deal with one kind of pair.
+    Parameters:
+        keyValueSsbo    See Sort(...).
+        itemCountSsbo   See Sort(...).
+    Returns:
+        A copy of the pairs.
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    std::vector<ParticleSortingData64> GpuKeyValueSorter::ReadKeyValuePairs(
+        const ParticleSortingDataSsbo &keyValueSsbo, const ActiveParticlesSsbo &itemCountSsbo) const
+    {
+        unsigned int numItems = 0;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, itemCountSsbo.BufferId());
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, itemCountSsbo.NumActiveParticlesByteOffset(), sizeof(unsigned int), &numItems);
+
+        std::vector<ParticleSortingData64> keyValuePairs(numItems);
+        unsigned int bufferSizeBytes = numItems * keyValueSsbo.ItemSizeBytes();
+        if (bufferSizeBytes > 0)
+        {
+            // Note: Mapping 0 bytes is an error.
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, keyValueSsbo.BufferId());
+            void *bufferPtr = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, bufferSizeBytes, GL_MAP_READ_BIT);
+            if (keyValueSsbo.KeyWidth() == SortingKeyWidth::KEY_64_BIT)
+            {
+                memcpy(keyValuePairs.data(), bufferPtr, bufferSizeBytes);
+            }
+            else
+            {
+                const ParticleSortingData *pairs32 = static_cast<const ParticleSortingData *>(bufferPtr);
+                for (unsigned int itemIndex = 0; itemIndex < numItems; itemIndex++)
+                {
+                    keyValuePairs[itemIndex]._sortingData = pairs32[itemIndex]._sortingData;
+                    keyValuePairs[itemIndex]._preSortedParticleIndex = pairs32[itemIndex]._preSortedParticleIndex;
+                }
+            }
+            glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        return keyValuePairs;
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Part of sorting.  Measures how far the pairs are from being sorted, repairs them if they 
+        are close, and measures again.  See IncrementalSortLayout.comp for the whole story.
+
+        The decision to repair is made on the GPU, so the repair and the re-measure are 
+        dispatched indirectly (0 work groups if there is nothing to do or too much to do).  
+        PlanRadixSortPasses(...) then looks at the final measurement and skips the radix sort 
+        if the data is sorted.
+
+        Note: Everything works in place on the first half of the ParticleSortingDataBuffer, 
+        which is where the pairs start and where the radix sort expects them.
+
+        Also Note: The first measurement covers only the items that are being sorted, so it is 
+        dispatched with the tile count in the item count SSBO.
+    Parameters: 
+        itemCountSsbo   See Sort(...).
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void GpuKeyValueSorter::IncrementalSort(const ActiveParticlesSsbo &itemCountSsbo) const
+    {
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, itemCountSsbo.BufferId());
+        glUseProgram(_programIdMeasureSortingDataDisorder);
+        glDispatchComputeIndirect(itemCountSsbo.DispatchCommandByteOffset(ACTIVE_PARTICLES_DISPATCH_INCREMENTAL_SORT_TILES));
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        glUseProgram(_programIdPlanIncrementalSort);
+        glDispatchCompute(1, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+        // sort the tiles, then sort them again straddling the first tiles' boundaries
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, _radixSortPassPlanSsbo.BufferId());
+        glUseProgram(_programIdSortSortingDataTiles);
+        glUniform1ui(UNIFORM_LOCATION_INCREMENTAL_SORT_TILE_OFFSET, 0);
+        glDispatchComputeIndirect(_radixSortPassPlanSsbo.IncrementalSortDispatchCommandByteOffset());
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        glUniform1ui(UNIFORM_LOCATION_INCREMENTAL_SORT_TILE_OFFSET, INCREMENTAL_SORT_ITEMS_PER_TILE / 2);
+        glDispatchComputeIndirect(_radixSortPassPlanSsbo.IncrementalSortDispatchCommandByteOffset());
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        // did it work?
+        glUseProgram(_programIdMeasureSortingDataDisorder);
+        glDispatchComputeIndirect(_radixSortPassPlanSsbo.IncrementalSortDispatchCommandByteOffset());
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Part of sorting.  Sorts the pairs in place in a single work group (see 
+        SortSortingDataInSharedMemory.comp).  This replaces the incremental sort, the planner, 
+        and all the radix sort passes.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void GpuKeyValueSorter::SortSortingDataInSharedMemory() const
+    {
+        glUseProgram(_programIdSortSortingDataInSharedMemory);
+        glDispatchCompute(1, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Part of sorting.  GetSortingDataBitMasks.comp ORs and ANDs all the keys together, and 
+        then PlanRadixSortPasses.comp uses that to decide which radix sort passes need to run.  
+        The plan is made on the GPU and it is used on the GPU (as the 
+        GL_DISPATCH_INDIRECT_BUFFER), so nothing needs to be read back.
+
+        The planner works out how many work groups each stage of a pass is dispatched with from 
+        the item count, so the CPU doesn't need to know it.  The stages fall into the "dispatch 
+        slots" in RadixSortPassPlanLayout.comp.
+
+        If the incremental sort is on, the planner is also told that the radix sort is only 
+        the fallback, and it plans no passes at all if IncrementalSort(...) left the data 
+        sorted.
+
+        Note: The masks used to be collected by GenerateSortingData.comp, but that tied the 
+        planner to whoever made the keys.  Now it costs one more read over the keys, but the 
+        sorter doesn't care where they came from.
+    Parameters: 
+        itemCountSsbo   See Sort(...).
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void GpuKeyValueSorter::PlanRadixSortPasses(const ActiveParticlesSsbo &itemCountSsbo) const
+    {
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, itemCountSsbo.BufferId());
+        glUseProgram(_programIdGetSortingDataBitMasks);
+        glDispatchComputeIndirect(itemCountSsbo.DispatchCommandByteOffset(ACTIVE_PARTICLES_DISPATCH_PARTICLES));
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+
+        bool useMultiBitSort = (_algorithm == Algorithm::RADIX_SORT_MULTI_BIT);
+        unsigned int bitsPerPass = useMultiBitSort ? RADIX_SORT_BITS_PER_DIGIT : 1;
+
+        glUseProgram(_programIdPlanRadixSortPasses);
+        glUniform1ui(UNIFORM_LOCATION_RADIX_SORT_BITS_PER_PASS, bitsPerPass);
+        glUniform1ui(UNIFORM_LOCATION_RADIX_SORT_ONLY_IF_UNSORTED, _useIncrementalSort ? 1 : 0);
+        glDispatchCompute(1, 1, 1);
+
+        // the sorting shaders read the pass list and the dispatches read the commands
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Part of sorting.  The number of work groups comes from the radix sort pass plan 
+        (see PlanRadixSortPasses(...)).
+
+        Note: The number of work groups for this sorting stage need special handling.  Most 
+        shaders operate on 1 item per thread and will require 
+        ("num particles" / "work group size X") + 1 work groups to give every data entry 
+        (particle, particle sorting, BVH nodes, etc.) a thread.  The prefix sum algorithm 
+        operates on 2 items per thread and needs special handling (read description block of 
+        PrefixSumSsbo for details).  
+        
+        This stage is neither.  Getting bits for the prefix sum operates on 1 item per thread 
+        and is a function of the size of the prefix scan array.  This special case has its own 
+        dispatch slot.
+
+        Also Note: Expects the radix sort pass plan to be bound to GL_DISPATCH_INDIRECT_BUFFER.
+    Parameters:
+        passNumber              0 - 31
+        sortingDataReadOffset   Tells the shader which half of the ParticleSortingDataBuffer has 
+                                the latest sort values.
+    Returns:    None
+    Creator:    John Cox, 6/2017
+    --------------------------------------------------------------------------------------------*/
+    void GpuKeyValueSorter::PrepareForPrefixScan(unsigned int passNumber, 
+        unsigned int sortingDataReadOffset) const
+    {
+        glUseProgram(_programIdGetBitForPrefixScan);
+        glUniform1ui(UNIFORM_LOCATION_PARTICLE_SORTING_DATA_BUFFER_READ_OFFSET, sortingDataReadOffset);
+        glUniform1ui(UNIFORM_LOCATION_RADIX_SORT_PASS_NUMBER, passNumber);
+        glDispatchComputeIndirect(_radixSortPassPlanSsbo.DispatchCommandByteOffset(passNumber, RADIX_SORT_DISPATCH_PREFIX_SCAN_DATA));
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Part of sorting.  Used by both the 1-bit and the multi-bit sorts.  The planner 
+        gave each its own work group count.
+
+        This used to be two dispatches (scan within each work group, then scan over the work 
+        group sums) with a memory barrier between them.  PrefixScanOverAllData.comp now does 
+        both in one dispatch (see PrefixScanLookBackBuffer.comp).
+
+        Note: Expects the radix sort pass plan to be bound to GL_DISPATCH_INDIRECT_BUFFER.
+    Parameters: 
+        passNumber      0 - 31
+    Returns:    None
+    Creator:    John Cox, 6/2017
+    --------------------------------------------------------------------------------------------*/
+    void GpuKeyValueSorter::PrefixScanOverSortingData(unsigned int passNumber) const
+    {
+        glUseProgram(_programIdPrefixScanOverAllData);
+        glDispatchComputeIndirect(_radixSortPassPlanSsbo.DispatchCommandByteOffset(passNumber, RADIX_SORT_DISPATCH_PREFIX_SCAN));
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Part of sorting.
+
+        Note: Expects the radix sort pass plan to be bound to GL_DISPATCH_INDIRECT_BUFFER.
+    Parameters: 
+        passNumber              0 - 31
+        sortingDataReadOffset   The sortng data is read from this half of the buffer...
+        sortingDataWriteOffset  And sorted according to the prefix sums into this half.
+    Returns:    None
+    Creator:    John Cox, 6/2017
+    --------------------------------------------------------------------------------------------*/
+    void GpuKeyValueSorter::SortSortingDataWithPrefixScan(unsigned int passNumber, 
+        unsigned int sortingDataReadOffset, unsigned int sortingDataWriteOffset) const
+    {
+        glUseProgram(_programIdSortSortingDataWithPrefixSums);
+        glUniform1ui(UNIFORM_LOCATION_PARTICLE_SORTING_DATA_BUFFER_READ_OFFSET, sortingDataReadOffset);
+        glUniform1ui(UNIFORM_LOCATION_PARTICLE_SORTING_DATA_BUFFER_WRITE_OFFSET, sortingDataWriteOffset);
+        glUniform1ui(UNIFORM_LOCATION_RADIX_SORT_PASS_NUMBER, passNumber);
+        glDispatchComputeIndirect(_radixSortPassPlanSsbo.DispatchCommandByteOffset(passNumber, RADIX_SORT_DISPATCH_SORTING_DATA));
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Part of the multi-bit sort.  Each work group sorts its chunk of the sorting 
+        data by the current digit and writes its digit counts to the prefix scan buffer.
+
+        Note: The digit counts take up less of the prefix scan buffer than the sorting data 
+        does, and the prefix scan only runs over the part that has digit counts in it.  Whatever 
+        is left over in the rest of the buffer from previous passes is never looked at.
+
+        Also Note: Expects the radix sort pass plan to be bound to GL_DISPATCH_INDIRECT_BUFFER.
+    Parameters:
+        passNumber              0 - (32 / RADIX_SORT_BITS_PER_DIGIT) - 1
+        sortingDataReadOffset   Tells the shader which half of the ParticleSortingDataBuffer has 
+                                the latest sort values.
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void GpuKeyValueSorter::PrepareForDigitPrefixScan(unsigned int passNumber, 
+        unsigned int sortingDataReadOffset) const
+    {
+        glUseProgram(_programIdGetDigitCountsForPrefixScan);
+        glUniform1ui(UNIFORM_LOCATION_PARTICLE_SORTING_DATA_BUFFER_READ_OFFSET, sortingDataReadOffset);
+        glUniform1ui(UNIFORM_LOCATION_RADIX_SORT_PASS_NUMBER, passNumber);
+        glDispatchComputeIndirect(_radixSortPassPlanSsbo.DispatchCommandByteOffset(passNumber, RADIX_SORT_DISPATCH_SORTING_DATA));
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Part of the multi-bit sort.
+
+        Note: Uses the same dispatch slot as PrepareForDigitPrefixScan(...), so it is 
+        guaranteed to have the same number of work groups.
+
+        Also Note: Expects the radix sort pass plan to be bound to GL_DISPATCH_INDIRECT_BUFFER.
+    Parameters: 
+        passNumber              0 - (32 / RADIX_SORT_BITS_PER_DIGIT) - 1
+        sortingDataReadOffset   The sortng data is read from this half of the buffer...
+        sortingDataWriteOffset  And sorted according to the digit prefix sums into this half.
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void GpuKeyValueSorter::SortSortingDataWithDigitPrefixScan(unsigned int passNumber,
+        unsigned int sortingDataReadOffset, unsigned int sortingDataWriteOffset) const
+    {
+        glUseProgram(_programIdSortSortingDataWithDigitPrefixSums);
+        glUniform1ui(UNIFORM_LOCATION_PARTICLE_SORTING_DATA_BUFFER_READ_OFFSET, sortingDataReadOffset);
+        glUniform1ui(UNIFORM_LOCATION_PARTICLE_SORTING_DATA_BUFFER_WRITE_OFFSET, sortingDataWriteOffset);
+        glUniform1ui(UNIFORM_LOCATION_RADIX_SORT_PASS_NUMBER, passNumber);
+        glDispatchComputeIndirect(_radixSortPassPlanSsbo.DispatchCommandByteOffset(passNumber, RADIX_SORT_DISPATCH_SORTING_DATA));
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+}
@@ -11,10 +11,17 @@
 #include "Include/Buffers/Particle.h"
 #include "Include/Geometry/MyVertex.h"
 #include "Include/Buffers/ParticleProperties.h"
+#include "Include/BvhQuality.h"
 
 #include "Shaders/ShaderHeaders/ComputeShaderWorkGroupSizes.comp"
 #include "Shaders/ShaderHeaders/CrossShaderUniformLocations.comp"
+#include "Shaders/ShaderHeaders/SsboBufferBindings.comp"
+#include "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp"
+#include "Shaders/Compute/ParticleCollisions/ParticleReorderLayout.comp"
+#include "Shaders/Compute/ParticleCollisions/BvhRefitLayout.comp"
+#include "Shaders/Compute/ParticleCollisions/BvhClusterLayout.comp"
 
+#include <algorithm>
 #include <chrono>
 #include <fstream>
 #include <iostream>
@@ -33,37 +40,77 @@ namespace ShaderControllers
         generated SSBOs and both of their corresponding compute header files have buffer size 
         uniforms that need to set their values with any shader programs that this shader 
         controller generates.
+
+        Also Note: The Morton Code encoding is given here because it is decided when the shaders 
+        are assembled (see MortonCode.h).  It can't be changed afterwards.  It also decides 
+        whether the sorting data has 32-bit or 64-bit keys (see MortonCodeKeyWidth(...)).
+
+        Also Also Note: Same for the BVH's leaf size (see BvhLeaves.comp).  0 is treated as 1.
     Parameters:
         leafData    Passed in so that it can have its uniforms set for the shaders.
         bvhSsbo     Contains info on the number of leaves.  
+        mortonCodeEncoding  Which Morton Code the particles are sorted by.
+        maxParticlesPerBvhLeaf  How many particles each of the BVH's leaves can hold.
     Returns:    None
     Creator:    John Cox, 3/2017
     --------------------------------------------------------------------------------------------*/
-    ParticleCollisions::ParticleCollisions(const ParticleSsbo::SharedConstPtr particleSsbo,
-        const ParticlePropertiesSsbo::SharedConstPtr particlePropertiesSsbo) :
+    ParticleCollisions::ParticleCollisions(const ParticleSsbo::SharedPtr particleSsbo,
+        const ParticlePropertiesSsbo::SharedConstPtr particlePropertiesSsbo, 
+        MortonCodeEncoding mortonCodeEncoding,
+        unsigned int maxParticlesPerBvhLeaf) :
         _numParticles(particleSsbo->NumParticles()),
-
-        _programIdCopyParticlesToCopyBuffer(0),
+        _mortonCodeEncoding(mortonCodeEncoding),
+        _maxParticlesPerBvhLeaf(std::max(maxParticlesPerBvhLeaf, 1u)),
+        _useLazyParticleReorder(false),
+        _useDynamicMortonCodeBounds(false),
+        _useBvhRefit(false),
+        _bvhBuilder(BvhBuilder::KARRAS_RADIX_TREE),
+        _useBvhTreeletRestructuring(false),
+        _useWideBvhTraversal(false),
+        _useQuantizedBvhTraversal(false),
+
+        _programIdComputeSceneBounds(0),
+        _programIdFinalizeSceneBounds(0),
         _programIdGenerateSortingData(0),
-        _programIdClearWorkGroupSums(0),
-        _programIdGetBitForPrefixScan(0),
-        _programIdPrefixScanOverAllData(0),
-        _programIdPrefixScanOverWorkGroupSums(0),
-        _programIdSortSortingDataWithPrefixSums(0),
+        _programIdCompactSortingData(0),
         _programIdSortParticles(0),
-        _programIdGuaranteeSortingDataUniqueness(0),
+        _programIdMeasureParticleLocality(0),
+        _programIdPlanParticleReorder(0),
+        _programIdCopyParticlesFromBackBuffer(0),
         _programIdGenerateLeafNodeBoundingBoxes(0),
         _programIdGenerateBinaryRadixTree(0),
         _programIdMergeBoundingVolumes(0),
+        _programIdBuildBvhAgglomerative(0),
+        _programIdInitBvhClusters(0),
+        _programIdFindBvhClusterNearestNeighbors(0),
+        _programIdMergeBvhClusters(0),
+        _programIdCompactBvhClusters(0),
+        _programIdCountBvhClusters(0),
+        _programIdRestructureBvhTreelets(0),
+        _programIdCollapseBvhToWideNodes(0),
+        _programIdQuantizeBvhNodes(0),
+        _programIdCountActiveParticles(0),
+        _programIdMeasureBvhArea(0),
+        _programIdPlanBvhRefit(0),
         _programIdDetectCollisions(0),
+        _programIdDetectCollisionsWideBvh(0),
+        _programIdDetectCollisionsQuantizedBvh(0),
         _programIdResolveCollisions(0),
         _programIdGenerateVerticesParticleVelocityVectors(0),
         _programIdGenerateVerticesParticleBoundingBoxes(0),
 
         // generate buffers
-        _particleSortingDataSsbo(particleSsbo->NumParticles()),
-        _prefixSumSsbo(particleSsbo->NumParticles()),
-        _bvhNodeSsbo(particleSsbo->NumParticles()),
+        _particleSortingDataSsbo(particleSsbo->NumParticles(), MortonCodeKeyWidth(mortonCodeEncoding)),
+        _sorter(particleSsbo->NumParticles(), MortonCodeKeyWidth(mortonCodeEncoding)),
+        _activeParticlesSsbo(_maxParticlesPerBvhLeaf),
+        _particleReorderSsbo(),
+        _sceneBoundsSsbo(),
+        _bvhNodeSsbo(particleSsbo->NumParticles(), _maxParticlesPerBvhLeaf),
+        _bvhNodeBuildDataSsbo(particleSsbo->NumParticles(), _maxParticlesPerBvhLeaf),
+        _bvhRefitSsbo(particleSsbo->NumParticles()),
+        _bvhClusterSsbo(particleSsbo->NumParticles(), _maxParticlesPerBvhLeaf),
+        _bvhWideNodeSsbo(particleSsbo->NumParticles(), _maxParticlesPerBvhLeaf),
+        _bvhQuantizedNodeSsbo(particleSsbo->NumParticles(), _maxParticlesPerBvhLeaf),
         
         //// Note: For N particles there are N leaves and N-1 internal nodes in the tree, and each 
         //// node's bounding box has 4 faces.  
@@ -74,27 +121,44 @@ namespace ShaderControllers
         _velocityVectorGeometrySsbo(particleSsbo->NumParticles()),
         _boundingBoxGeometrySsbo(particleSsbo->NumParticles()),
         
-        // kept around for debugging purposes
-        _originalParticleSsbo(particleSsbo)
+        // the particle sort swaps its halves, and it is also kept around for debugging purposes
+        _particleSsbo(particleSsbo),
+        _particlePropertiesSsbo(particlePropertiesSsbo),
+        _cpuThreadPool(nullptr)
     {
         // the programs used during the parallel sort
-        AssembleProgramCopyParticlesToCopyBuffer();
+        AssembleProgramComputeSceneBounds();
+        AssembleProgramFinalizeSceneBounds();
         AssembleProgramGenerateSortingData();
-        AssembleProgramClearWorkGroupSums();
-        AssembleProgramGetBitForPrefixScan();
-        AssembleProgramPrefixScanOverAllData();
-        AssembleProgramPrefixScanOverWorkGroupSums();
-        AssembleProgramSortSortingDataWithPrefixSums();
+        AssembleProgramCompactSortingData();
         AssembleProgramSortParticles();
+        AssembleProgramMeasureParticleLocality();
+        AssembleProgramPlanParticleReorder();
+        AssembleProgramCopyParticlesFromBackBuffer();
 
         // the programs used during BVH construction
-        AssembleProgramGuaranteeSortingDataUniqueness();
         AssembleProgramGenerateLeafNodeBoundingBoxes();
         AssembleProgramGenerateBinaryRadixTree();
         AssembleProgramMergeBoundingVolumes();
+        AssembleProgramBuildBvhAgglomerative();
+        AssembleProgramInitBvhClusters();
+        AssembleProgramFindBvhClusterNearestNeighbors();
+        AssembleProgramMergeBvhClusters();
+        AssembleProgramCompactBvhClusters();
+        AssembleProgramCountBvhClusters();
+        AssembleProgramRestructureBvhTreelets();
+        AssembleProgramCollapseBvhToWideNodes();
+        AssembleProgramQuantizeBvhNodes();
+
+        // the programs used to refit the BVH instead of rebuilding it
+        AssembleProgramCountActiveParticles();
+        AssembleProgramMeasureBvhArea();
+        AssembleProgramPlanBvhRefit();
 
         // the programs used for the collisions themselves
         AssembleProgramDetectCollisions();
+        AssembleProgramDetectCollisionsWideBvh();
+        AssembleProgramDetectCollisionsQuantizedBvh();
         AssembleProgramResolveCollisions();
 
         // and for the geometry generation to visualize the results 
@@ -102,43 +166,81 @@ namespace ShaderControllers
         AssembleProgramGenerateVerticesParticleBoundingBoxes();
 
         // load the buffer size uniforms where the SSBOs will be used
-        particleSsbo->ConfigureConstantUniforms(_programIdCopyParticlesToCopyBuffer);
+        particleSsbo->ConfigureConstantUniforms(_programIdComputeSceneBounds);
         particleSsbo->ConfigureConstantUniforms(_programIdGenerateSortingData);
         particleSsbo->ConfigureConstantUniforms(_programIdSortParticles);
+        particleSsbo->ConfigureConstantUniforms(_programIdPlanParticleReorder);
+        particleSsbo->ConfigureConstantUniforms(_programIdCopyParticlesFromBackBuffer);
         particleSsbo->ConfigureConstantUniforms(_programIdGenerateLeafNodeBoundingBoxes);
+        particleSsbo->ConfigureConstantUniforms(_programIdBuildBvhAgglomerative);
+        particleSsbo->ConfigureConstantUniforms(_programIdCountActiveParticles);
         particleSsbo->ConfigureConstantUniforms(_programIdDetectCollisions);
+        particleSsbo->ConfigureConstantUniforms(_programIdDetectCollisionsWideBvh);
+        particleSsbo->ConfigureConstantUniforms(_programIdDetectCollisionsQuantizedBvh);
         particleSsbo->ConfigureConstantUniforms(_programIdResolveCollisions);
         particleSsbo->ConfigureConstantUniforms(_programIdGenerateVerticesParticleVelocityVectors);
         particleSsbo->ConfigureConstantUniforms(_programIdGenerateVerticesParticleBoundingBoxes);
 
         particlePropertiesSsbo->ConfigureConstantUniforms(_programIdGenerateLeafNodeBoundingBoxes);
+        particlePropertiesSsbo->ConfigureConstantUniforms(_programIdBuildBvhAgglomerative);
+        particlePropertiesSsbo->ConfigureConstantUniforms(_programIdDetectCollisions);
+        particlePropertiesSsbo->ConfigureConstantUniforms(_programIdDetectCollisionsWideBvh);
+        particlePropertiesSsbo->ConfigureConstantUniforms(_programIdDetectCollisionsQuantizedBvh);
         particlePropertiesSsbo->ConfigureConstantUniforms(_programIdResolveCollisions);
         particlePropertiesSsbo->ConfigureConstantUniforms(_programIdGenerateVerticesParticleBoundingBoxes);
 
         _particleSortingDataSsbo.ConfigureConstantUniforms(_programIdGenerateSortingData);
-        _particleSortingDataSsbo.ConfigureConstantUniforms(_programIdGetBitForPrefixScan);
-        _particleSortingDataSsbo.ConfigureConstantUniforms(_programIdSortSortingDataWithPrefixSums);
+        _particleSortingDataSsbo.ConfigureConstantUniforms(_programIdCompactSortingData);
         _particleSortingDataSsbo.ConfigureConstantUniforms(_programIdSortParticles);
-        _particleSortingDataSsbo.ConfigureConstantUniforms(_programIdGuaranteeSortingDataUniqueness);
         _particleSortingDataSsbo.ConfigureConstantUniforms(_programIdGenerateBinaryRadixTree);
+        _particleSortingDataSsbo.ConfigureConstantUniforms(_programIdBuildBvhAgglomerative);
 
-        _prefixSumSsbo.ConfigureConstantUniforms(_programIdGetBitForPrefixScan);
-        _prefixSumSsbo.ConfigureConstantUniforms(_programIdPrefixScanOverAllData);
-        _prefixSumSsbo.ConfigureConstantUniforms(_programIdPrefixScanOverWorkGroupSums);
-        _prefixSumSsbo.ConfigureConstantUniforms(_programIdSortSortingDataWithPrefixSums);
+        // the prefix scans (active particle compaction and PLOC cluster compaction) run in the 
+        // sorter's prefix scan buffer
+        _sorter.ConfigurePrefixScanUniforms(_programIdGenerateSortingData);
+        _sorter.ConfigurePrefixScanUniforms(_programIdCompactSortingData);
+        _sorter.ConfigurePrefixScanUniforms(_programIdMergeBvhClusters);
+        _sorter.ConfigurePrefixScanUniforms(_programIdCompactBvhClusters);
+        _sorter.ConfigurePrefixScanUniforms(_programIdCountBvhClusters);
 
         _bvhNodeSsbo.ConfigureConstantUniforms(_programIdGenerateLeafNodeBoundingBoxes);
         _bvhNodeSsbo.ConfigureConstantUniforms(_programIdGenerateBinaryRadixTree);
         _bvhNodeSsbo.ConfigureConstantUniforms(_programIdMergeBoundingVolumes);
+        _bvhNodeSsbo.ConfigureConstantUniforms(_programIdBuildBvhAgglomerative);
+        _bvhNodeSsbo.ConfigureConstantUniforms(_programIdFindBvhClusterNearestNeighbors);
+        _bvhNodeSsbo.ConfigureConstantUniforms(_programIdMergeBvhClusters);
+        _bvhNodeSsbo.ConfigureConstantUniforms(_programIdRestructureBvhTreelets);
+        _bvhNodeSsbo.ConfigureConstantUniforms(_programIdCollapseBvhToWideNodes);
+        _bvhNodeSsbo.ConfigureConstantUniforms(_programIdQuantizeBvhNodes);
+        _bvhNodeSsbo.ConfigureConstantUniforms(_programIdMeasureBvhArea);
         _bvhNodeSsbo.ConfigureConstantUniforms(_programIdDetectCollisions);
+        _bvhNodeSsbo.ConfigureConstantUniforms(_programIdDetectCollisionsWideBvh);
+        _bvhNodeSsbo.ConfigureConstantUniforms(_programIdDetectCollisionsQuantizedBvh);
 
         _particlePotentialCollisionsSsbo.ConfigureConstantUniforms(_programIdDetectCollisions);
+        _particlePotentialCollisionsSsbo.ConfigureConstantUniforms(_programIdDetectCollisionsWideBvh);
+        _particlePotentialCollisionsSsbo.ConfigureConstantUniforms(_programIdDetectCollisionsQuantizedBvh);
         _particlePotentialCollisionsSsbo.ConfigureConstantUniforms(_programIdResolveCollisions);
 
         _velocityVectorGeometrySsbo.ConfigureConstantUniforms(_programIdGenerateVerticesParticleVelocityVectors);
 
         _boundingBoxGeometrySsbo.ConfigureConstantUniforms(_programIdGenerateVerticesParticleBoundingBoxes);
 
+        // most shaders are dispatched with 1 thread per particle, so the particle count is 
+        // limited by how many work groups a single dispatch can have
+        // Note: OpenGL guarantees at least 65535, which at WORK_GROUP_SIZE_X = 512 is ~33.5 
+        // million particles.  Past that the dispatches would fail and the sort would silently 
+        // leave particles behind, so at least say something.
+        unsigned int numWorkGroupsX = 0;
+        CalculateNumWorkGroups(numWorkGroupsX);
+        GLint maxNumWorkGroupsX = 0;
+        glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_COUNT, 0, &maxNumWorkGroupsX);
+        if (numWorkGroupsX > static_cast<unsigned int>(maxNumWorkGroupsX))
+        {
+            fprintf(stderr, "ParticleCollisions: %u particles need %u work groups, but this GPU only allows %d per dispatch\n",
+                _numParticles, numWorkGroupsX, maxNumWorkGroupsX);
+        }
+
 
         //unsigned int startingIndex = 0;
         //std::vector<ParticleProperties> checkParticlePropertiesBuffer(particlePropertiesSsbo->NumProperties());
@@ -170,24 +272,249 @@ namespace ShaderControllers
     --------------------------------------------------------------------------------------------*/
     ParticleCollisions::~ParticleCollisions()
     {
-        glDeleteProgram(_programIdCopyParticlesToCopyBuffer);
+        glDeleteProgram(_programIdComputeSceneBounds);
+        glDeleteProgram(_programIdFinalizeSceneBounds);
         glDeleteProgram(_programIdGenerateSortingData);
-        glDeleteProgram(_programIdClearWorkGroupSums);
-        glDeleteProgram(_programIdGetBitForPrefixScan);
-        glDeleteProgram(_programIdPrefixScanOverAllData);
-        glDeleteProgram(_programIdPrefixScanOverWorkGroupSums);
-        glDeleteProgram(_programIdSortSortingDataWithPrefixSums);
+        glDeleteProgram(_programIdCompactSortingData);
         glDeleteProgram(_programIdSortParticles);
-        glDeleteProgram(_programIdGuaranteeSortingDataUniqueness);
+        glDeleteProgram(_programIdMeasureParticleLocality);
+        glDeleteProgram(_programIdPlanParticleReorder);
+        glDeleteProgram(_programIdCopyParticlesFromBackBuffer);
         glDeleteProgram(_programIdGenerateLeafNodeBoundingBoxes);
         glDeleteProgram(_programIdGenerateBinaryRadixTree);
         glDeleteProgram(_programIdMergeBoundingVolumes);
+        glDeleteProgram(_programIdBuildBvhAgglomerative);
+        glDeleteProgram(_programIdInitBvhClusters);
+        glDeleteProgram(_programIdFindBvhClusterNearestNeighbors);
+        glDeleteProgram(_programIdMergeBvhClusters);
+        glDeleteProgram(_programIdCompactBvhClusters);
+        glDeleteProgram(_programIdCountBvhClusters);
+        glDeleteProgram(_programIdRestructureBvhTreelets);
+        glDeleteProgram(_programIdCollapseBvhToWideNodes);
+        glDeleteProgram(_programIdQuantizeBvhNodes);
+        glDeleteProgram(_programIdCountActiveParticles);
+        glDeleteProgram(_programIdMeasureBvhArea);
+        glDeleteProgram(_programIdPlanBvhRefit);
         glDeleteProgram(_programIdDetectCollisions);
+        glDeleteProgram(_programIdDetectCollisionsWideBvh);
+        glDeleteProgram(_programIdDetectCollisionsQuantizedBvh);
         glDeleteProgram(_programIdResolveCollisions);
         glDeleteProgram(_programIdGenerateVerticesParticleVelocityVectors);
         glDeleteProgram(_programIdGenerateVerticesParticleBoundingBoxes);
     }
 
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Chooses which sort runs on the next call to DetectAndResolve(...).  They all leave the 
+        sorted data in the same place, so they can be swapped at any time to compare them.
+
+        The constructor picks the shared memory sort if every particle fits in it (see 
+        SharedMemorySortLayout.comp) and the multi-bit radix sort otherwise.
+
+        Note: This is passed straight on to the sorter.  If the shared memory sort is requested 
+        but there are too many particles for it, the sorter complains to stderr and keeps the 
+        current sort.
+    Parameters: 
+        algorithm   Self-explanatory.
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::SetSortingAlgorithm(SortingAlgorithm algorithm)
+    {
+        _sorter.SetAlgorithm(algorithm);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Turns the incremental sort (see IncrementalSortLayout.comp) on or off for the next call 
+        to DetectAndResolve(...).  When it is on, the radix sort chosen by 
+        SetSortingAlgorithm(...) only runs as the fallback.  When it is off, the radix sort runs 
+        every time.  Passed straight on to the sorter.
+    Parameters: 
+        useIncrementalSort  Self-explanatory.
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::SetIncrementalSort(bool useIncrementalSort)
+    {
+        _sorter.SetIncrementalSort(useIncrementalSort);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Turns the lazy particle reorder (see ParticleReorderLayout.comp) on or off for the next 
+        call to DetectAndResolve(...).  When it is on, the particles are only moved into sorted 
+        order when they have gotten too scattered or it has been too long.  When it is off, 
+        they are moved every time.  It is off by default.
+
+        Note: A frame that does move them costs twice as much as it does with the lazy reorder 
+        off.  The CPU doesn't know whether they moved, so it can't swap the particle halves, 
+        and they are copied back to the front half instead (see 
+        SortParticlesWithSortedData(...)).  It only pays off if the particles move less than 
+        every other frame.  SortParticlesWithProfiling(...) reports how often they do.
+    Parameters: 
+        useLazyParticleReorder  Self-explanatory.
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::SetLazyParticleReorder(bool useLazyParticleReorder)
+    {
+        _useLazyParticleReorder = useLazyParticleReorder;
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Turns the dynamic Morton Code bounds (see SceneBoundsLayout.comp) on or off for the 
+        next call to DetectAndResolve(...).  When they are on, the Morton Codes are normalized 
+        against wherever the active particles are this frame.  When they are off, they are 
+        normalized against the fixed particle region.  They are off by default, so the keys 
+        are the same as they always were unless someone asks for this.
+
+        Note: GenerateSortingData.comp reads the bounds from the SceneBoundsSsbo either way, so 
+        turning them off puts the fixed particle region back into it.
+    Parameters: 
+        useDynamicMortonCodeBounds  Self-explanatory.
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::SetDynamicMortonCodeBounds(bool useDynamicMortonCodeBounds)
+    {
+        _useDynamicMortonCodeBounds = useDynamicMortonCodeBounds;
+        if (!useDynamicMortonCodeBounds)
+        {
+            _sceneBoundsSsbo.ResetToParticleRegion();
+        }
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Turns the BVH refit (see BvhRefitLayout.comp) on or off for the next call to 
+        DetectAndResolve(...).  When it is on, the particles are only re-sorted and the tree 
+        only rebuilt when the tree has gotten too loose, too many particles are missing from 
+        it, or it has been too long.  Otherwise the tree keeps its shape and only its bounding 
+        boxes are updated.  When it is off, the tree is rebuilt every time.  It is off by 
+        default.  CompareBvhRefit() in main.cpp measures whether it is worth it.
+
+        Note: Whatever tree is there when it is turned on wasn't measured, so the next frame 
+        rebuilds it.
+    Parameters: 
+        useBvhRefit     Self-explanatory.
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::SetBvhRefit(bool useBvhRefit)
+    {
+        if (useBvhRefit && !_useBvhRefit)
+        {
+            _bvhRefitSsbo.RequestRebuild();
+        }
+        _useBvhRefit = useBvhRefit;
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Chooses how the BVH is built on the next call to DetectAndResolve(...) (and 
+        MeasureTreeQuality(...)).
+        - KARRAS_RADIX_TREE: GenerateLeafNodeBoundingBoxes.comp, GenerateBinaryRadixTree.comp, 
+          and MergeBoundingVolumes.comp, one after the other.  This is the default.
+        - AGGLOMERATIVE: BuildBvhAgglomerative.comp does all of it in a single dispatch.
+        - PLOC: GenerateLeafNodeBoundingBoxes.comp, and then round after round of merging the 
+          clusters that are closest together (see BvhClusterLayout.comp).  Slower to build, 
+          but the tree is better, so DetectCollisions.comp gets through it faster.  
+          CompareBvhBuilders() in main.cpp measures whether that is worth it.
+        - BINNED_SAH_CPU: the particles are read back, and BuildBvhBinnedSahCpu(...) (see 
+          CpuBvhBuilders.h) builds the tree on the CPU with every hardware thread.  It is 
+          uploaded into the BvhNodeSsbo and the BvhNodeBuildDataSsbo.  That takes far longer 
+          than any of the others, so it is for a baseline of how good a tree can get, or for 
+          particles that hardly move, where the BVH refit can keep one tree for a long time.
+
+        They all put the root in the same place and leave the tree the same way, so they can 
+        be swapped at any time.  MeasureTreeQuality(...) checks that any of them made a valid 
+        tree (see CountInvalidBvhNodes(...)), and CompareBvhBuilders() in main.cpp reports it.
+
+        Note: The BVH refit (see BvhRefitLayout.comp) doesn't care which one built the tree.  
+        It only needs the tree's shape.
+    Parameters: 
+        builder     Self-explanatory.
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::SetBvhBuilder(BvhBuilder builder)
+    {
+        _bvhBuilder = builder;
+
+        // the threads sleep until there is something to do, but there is no reason to start 
+        // them for a builder that doesn't use them
+        if (builder == BvhBuilder::BINNED_SAH_CPU && _cpuThreadPool == nullptr)
+        {
+            _cpuThreadPool = std::make_shared<WorkStealingThreadPool>();
+        }
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Turns on or off the extra pass after the BVH is built that rearranges small pieces of 
+        the tree into ones with less overlap (see RestructureBvhTreelets.comp).  It makes the 
+        build slower and DetectCollisions.comp faster.  CompareBvhTreeletRestructuring() in 
+        main.cpp measures whether that is worth it.  It is off by default.
+
+        Note: It works the same on either builder's tree (see SetBvhBuilder(...)).  It only 
+        runs when the tree is built, not when it is refit (see BvhRefitLayout.comp), so a 
+        refit tree keeps whatever shape it was given at the last rebuild.
+    Parameters: 
+        useBvhTreeletRestructuring  Self-explanatory.
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::SetBvhTreeletRestructuring(bool useBvhTreeletRestructuring)
+    {
+        _useBvhTreeletRestructuring = useBvhTreeletRestructuring;
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Turns on or off collision detection through a 4-wide BVH instead of the binary one.  
+        The wide one is made out of the binary one after every build and refit (see 
+        CollapseBvhToWideNodes.comp), and DetectCollisions.comp goes through it 4 children at a 
+        time (see BvhWideNodeBuffer.comp).  That adds a dispatch to every frame and takes 
+        fewer reads and fewer stack pushes to detect collisions.  CompareWideBvhTraversal() in 
+        main.cpp measures whether that is worth it.  It is off by default.
+
+        Note: The binary tree is still the one that is built, restructured, refit, and 
+        measured for the refit (see BvhRefitLayout.comp).  The wide one is only for going 
+        through, so this can be changed at any time.
+    Parameters: 
+        useWideBvhTraversal     Self-explanatory.
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::SetWideBvhTraversal(bool useWideBvhTraversal)
+    {
+        _useWideBvhTraversal = useWideBvhTraversal;
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Turns on or off collision detection through quantized copies of the BVH's nodes (see 
+        BvhQuantizedNodeBuffer.comp).  Those store the children's boxes as 16-bit steps across 
+        the node's own box, rounded outward, so they are half the size of a BvhNode and no 
+        overlap is ever missed.  They are made out of the binary tree after every build and 
+        refit (see QuantizeBvhNodes.comp).  That adds a dispatch to every frame and halves the 
+        memory that collision detection reads.  CompareQuantizedBvhTraversal() in main.cpp 
+        measures whether that is worth it.  It is off by default.
+
+        Note: Like the 4-wide tree, this is only for going through, so this can be changed at 
+        any time.  If both are on, the 4-wide tree is the one that is gone through.
+    Parameters: 
+        useQuantizedBvhTraversal    Self-explanatory.
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::SetQuantizedBvhTraversal(bool useQuantizedBvhTraversal)
+    {
+        _useQuantizedBvhTraversal = useQuantizedBvhTraversal;
+    }
+
     /*--------------------------------------------------------------------------------------------
     Description:
         This method governs the dispatches of many compute shaders that will eventually result 
@@ -207,26 +534,41 @@ namespace ShaderControllers
         The stages of collision detection and resolution are as follows:
         (1) sort the particles along a Z-order curve
             (a) prepare to sort particles
-                (i)  copy particles to 2nd half of the particle buffer
+                (i)  find the bounds of the active particles (if the dynamic Morton Code 
+                    bounds are on; see SceneBoundsLayout.comp)
                 (ii) generate the Morton Codes (value along the Z-Order curve) for each particle
-            (b) loop bits 0-31
-                (i)   prepare for prefix scan
-                    1. clear work group sums to 0
-                    2. get next bit for prefix scan
-                (ii)  prefix scan over all sorting data
-                (iii) prefix scan over work group sums
-                (iv)  sort sorting data with prefix sums
-            (c) sort particles using the final sorted data
+                (iii) move the active particles' Morton Codes to the front and count them (see 
+                    ActiveParticlesBuffer.comp); everything after this only works on them
+            (b) sort the active particles' Morton Codes (see GpuKeyValueSorter, which picks 
+                the algorithm and runs the incremental sort in front of it)
+            (c) sort particles using the final sorted data (if the lazy particle reorder is 
+                on, only when they have gotten too scattered; see ParticleReorderLayout.comp)
         (2) generate a bounding volume hierarchy (BVH) from the sorted data
-            (a) prepare for binary tree
-                (i)  guarantee sorting data uniqueness (see GuaranteeSortingDataUniqueness.comp)
-                (ii) generate bounding boxes for each leaf node
-            (b) generate the binary radix tree out of the particle sorting data
+            (a) generate bounding boxes for each leaf node
+            (b) generate the binary radix tree out of the particle sorting data (duplicate 
+                values are told apart by their indices; see GenerateBinaryRadixTree.comp)
             (c) merge bounding boxes from the leaves up to the root of the tree
+            (or all of (2) at once if the agglomerative builder was chosen, or (b) and (c) 
+            together by merging clusters if the PLOC builder was; see SetBvhBuilder(...))
+            (d) optionally rearrange the tree into a better one (see 
+                SetBvhTreeletRestructuring(...))
+            (e) optionally collapse the tree into a 4-wide one (see SetWideBvhTraversal(...))
+            (f) optionally make quantized copies of the nodes (see 
+                SetQuantizedBvhTraversal(...))
         (3) detect and resolve collisions
             (a) traverse the BVH and detect overlaps with leaves (other particles)
             (b) resolve any overlaps collisions
 
+        If the BVH refit is on (see BvhRefitLayout.comp), (1) and (2) only happen when the GPU 
+        asked for a rebuild last frame.  Otherwise the tree from last time is refit:
+            (a) count the active particles
+            (b) generate bounding boxes for each leaf node
+            (c) merge bounding boxes from the leaves up to the root of the tree
+            (d) optionally collapse the tree into a 4-wide one (see SetWideBvhTraversal(...))
+            (e) optionally make quantized copies of the nodes (see 
+                SetQuantizedBvhTraversal(...))
+        Either way, the tree is then measured so that the GPU can decide about next frame.
+
         I want to profile each step, so all the most-indented steps are in their own 
         shader-dispatching functions.  The "profiling" version of each stage ((1), (2), and (3)) 
         will surround the calls to these functions with profiling stuff and the resulting times 
@@ -245,32 +587,68 @@ namespace ShaderControllers
     --------------------------------------------------------------------------------------------*/
     void ParticleCollisions::DetectAndResolve(bool withProfiling, bool generateGeometry) const
     {
-        // most shaders work on 1 item per thread
-        int numWorkGroupsX = _numParticles / WORK_GROUP_SIZE_X;
-        int remainder = _numParticles % WORK_GROUP_SIZE_X;
-        numWorkGroupsX += (remainder == 0) ? 0 : 1;
+        unsigned int numWorkGroupsX = 0;
+        CalculateNumWorkGroups(numWorkGroupsX);
 
-        // the prefix scan works on 2 items per thread
-        // Note: See description of PrefixScanSsbo for why the prefix scan algorithm needs its 
-        // own work group size calculation.
-        unsigned int numItemsInPrefixScanBuffer = _prefixSumSsbo.NumDataEntries();
-        int numWorkGroupsXForPrefixSum = numItemsInPrefixScanBuffer / PREFIX_SCAN_ITEMS_PER_WORK_GROUP;
-        remainder = numItemsInPrefixScanBuffer % PREFIX_SCAN_ITEMS_PER_WORK_GROUP;
-        numWorkGroupsXForPrefixSum += (remainder == 0) ? 0 : 1;
+        bool rebuild = !_useBvhRefit || BvhRebuildRequested();
 
         if (withProfiling)
         {
-            //SortParticlesWithProfiling(numWorkGroupsX, numWorkGroupsXForPrefixSum);
-            //GenerateBvhWithProfiling(numWorkGroupsX);
-            SortParticlesWithoutProfiling(numWorkGroupsX, numWorkGroupsXForPrefixSum);
-            GenerateBvhWithoutProfiling(numWorkGroupsX);
-            DetectAndResolveCollisionsWithProfiling(numWorkGroupsX);
+            // for profiling the rebuild against the refit
+            using namespace std::chrono;
+            WaitForComputeToFinish();
+            steady_clock::time_point start = high_resolution_clock::now();
+
+            if (rebuild)
+            {
+                //SortParticlesWithProfiling(numWorkGroupsX);
+                SortParticlesWithoutProfiling(numWorkGroupsX);
+
+                // the BVH and the collisions are sized by the number of active particles, which 
+                // only the GPU knows
+                glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, _activeParticlesSsbo.BufferId());
+                //GenerateBvhWithProfiling();
+                GenerateBvhWithoutProfiling();
+            }
+            else
+            {
+                BindBuffers();
+                glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, _activeParticlesSsbo.BufferId());
+                RefitBvh(numWorkGroupsX);
+            }
+
+            if (_useBvhRefit)
+            {
+                PlanBvhRefit(rebuild);
+            }
+            WaitForComputeToFinish();
+            steady_clock::time_point end = high_resolution_clock::now();
+            ReportBvhRefit(rebuild, duration_cast<microseconds>(end - start).count());
+
+            DetectAndResolveCollisionsWithProfiling();
+            glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
         }
         else
         {
-            SortParticlesWithoutProfiling(numWorkGroupsX, numWorkGroupsXForPrefixSum);
-            GenerateBvhWithoutProfiling(numWorkGroupsX);
-            DetectAndResolveCollisionsWithoutProfiling(numWorkGroupsX);
+            if (rebuild)
+            {
+                SortParticlesWithoutProfiling(numWorkGroupsX);
+                glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, _activeParticlesSsbo.BufferId());
+                GenerateBvhWithoutProfiling();
+            }
+            else
+            {
+                BindBuffers();
+                glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, _activeParticlesSsbo.BufferId());
+                RefitBvh(numWorkGroupsX);
+            }
+
+            if (_useBvhRefit)
+            {
+                PlanBvhRefit(rebuild);
+            }
+            DetectAndResolveCollisionsWithoutProfiling();
+            glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
         }
 
         if (generateGeometry)
@@ -280,6 +658,196 @@ namespace ShaderControllers
         }
     }
 
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        For comparing sort keys (see MortonCode.h).  Sorts the particles and builds the BVH 
+        over them the same way as DetectAndResolve(...), then measures the tree:
+        - the SAH cost (see BvhSahCost(...))
+        - how many internal nodes collision detection goes through (see 
+          CountBvhNodesVisited(...), or CountBvhWideNodesVisited(...) if it goes through the 
+          4-wide tree)
+        - how many potential collisions DetectCollisions.comp found
+        - how many nodes are not where the tree says they are (see CountInvalidBvhNodes(...)), 
+          which has to be 0 for the rest to mean anything
+        - how long it took to build the tree
+        - how long DetectCollisions.comp takes, averaged over numTraversals runs
+        
+        The collisions are not resolved, so the particles end up where they were, just maybe 
+        in a different order.  Every ParticleCollisions that is given the same particles sees 
+        the same scene.
+
+        Note: The potential collisions are the particles whose boxes overlap, and any tree finds 
+        all of them (up to MAX_NUM_POTENTIAL_COLLISIONS per particle).  They should be the same 
+        for every key and every leaf size (see BvhLeaves.comp).  They are there to show that 
+        the trees agree.  The node count and the time are what differ.
+
+        Also Note: This reads back the whole BVH and traverses it on the CPU once per leaf.  
+        Don't call it every frame.
+
+        Also Also Note: The tree that this builds isn't measured for the BVH refit (see 
+        BvhRefitLayout.comp), so the next DetectAndResolve(...) rebuilds it.
+    Parameters: 
+        numTraversals   How many times to run DetectCollisions.comp for the timing.
+    Returns:    
+        See Description.
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    ParticleCollisions::TreeQuality ParticleCollisions::MeasureTreeQuality(unsigned int numTraversals) const
+    {
+        unsigned int numWorkGroupsX = 0;
+        CalculateNumWorkGroups(numWorkGroupsX);
+
+        SortParticlesWithoutProfiling(numWorkGroupsX);
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, _activeParticlesSsbo.BufferId());
+        WaitForComputeToFinish();
+
+        using namespace std::chrono;
+        steady_clock::time_point start = high_resolution_clock::now();
+        GenerateBvhWithoutProfiling();
+        WaitForComputeToFinish();
+        steady_clock::time_point end = high_resolution_clock::now();
+        long long durationBuildBvh = duration_cast<microseconds>(end - start).count();
+        _bvhRefitSsbo.RequestRebuild();
+
+        start = high_resolution_clock::now();
+        for (unsigned int traversalCount = 0; traversalCount < numTraversals; traversalCount++)
+        {
+            DetectCollisions();
+        }
+        WaitForComputeToFinish();
+        end = high_resolution_clock::now();
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+        glUseProgram(0);
+
+        TreeQuality quality;
+        quality._durationBuildBvh = durationBuildBvh;
+        quality._durationDetectCollisions = (numTraversals == 0) ? 0 : 
+            duration_cast<microseconds>(end - start).count() / numTraversals;
+
+        unsigned int numActiveParticles = 0;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _activeParticlesSsbo.BufferId());
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, _activeParticlesSsbo.NumActiveParticlesByteOffset(), sizeof(unsigned int), &numActiveParticles);
+        quality._numActiveParticles = numActiveParticles;
+        unsigned int numLeaves = (numActiveParticles + _maxParticlesPerBvhLeaf - 1) / _maxParticlesPerBvhLeaf;
+        quality._numBvhLeaves = numLeaves;
+
+        std::vector<BvhNode> bvhNodes;
+        std::vector<BvhNodeBuildData> bvhBuildData;
+        ReadBackBvh(bvhNodes, bvhBuildData);
+
+        // only the active particles are in the tree
+        quality._numPotentialCollisions = 0;
+        if (numActiveParticles > 0)
+        {
+            std::vector<ParticlePotentialCollisions> potentialCollisions(numActiveParticles);
+            unsigned int bufferSizeBytes = potentialCollisions.size() * sizeof(ParticlePotentialCollisions);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, _particlePotentialCollisionsSsbo.BufferId());
+            void *bufferPtr = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, bufferSizeBytes, GL_MAP_READ_BIT);
+            memcpy(potentialCollisions.data(), bufferPtr, bufferSizeBytes);
+            glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+            for (const ParticlePotentialCollisions &p : potentialCollisions)
+            {
+                quality._numPotentialCollisions += p._numPotentialCollisions;
+            }
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        // a tree of 0 or 1 leaves has no internal nodes (see MergeBoundingVolumes.comp)
+        int rootIndex = static_cast<int>(_bvhNodeSsbo.NumLeafNodes());
+        quality._numInvalidBvhNodes = CountInvalidBvhNodes(bvhNodes, bvhBuildData, rootIndex, 
+            numActiveParticles, _maxParticlesPerBvhLeaf);
+        quality._sahCost = (numLeaves < 2) ? 0.0f : 
+            BvhSahCost(bvhNodes, rootIndex, numActiveParticles, _maxParticlesPerBvhLeaf);
+        // Note: The quantized nodes are the same tree, so they go through the same nodes, give or 
+        // take the few extra that their bigger boxes overlap.
+        quality._numNodesVisited = _useWideBvhTraversal ? 
+            CountBvhWideNodesVisited(bvhNodes, rootIndex, numActiveParticles, _maxParticlesPerBvhLeaf) : 
+            CountBvhNodesVisited(bvhNodes, rootIndex, numActiveParticles, _maxParticlesPerBvhLeaf);
+        return quality;
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Reads back what the BVH refit has been up to (see BvhRefitLayout.comp): whether the 
+        next frame will rebuild the tree, how many times it has been rebuilt and refit since 
+        startup, and how big it has gotten since the last rebuild.
+
+        Note: This is a glGetBufferSubData(...), so it is a pipeline stall.  It is for 
+        profiling and benchmarks only.  DetectAndResolve(...) gets the rebuild decision without 
+        one (see BvhRebuildRequested()).
+    Parameters: None
+    Returns:    
+        A copy of the state.
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    BvhRefitState ParticleCollisions::ReadBvhRefitState() const
+    {
+        BvhRefitState state;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bvhRefitSsbo.BufferId());
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, _bvhRefitSsbo.StateByteOffset(), _bvhRefitSsbo.StateSizeBytes(), &state);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        return state;
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Reads back the whole BVH: the nodes (see BvhNodeBuffer.comp) and the parents and 
+        entrance counters (see BvhNodeBuildDataBuffer.comp).  The layout is the same as what 
+        the CPU builders make (see CpuBvhBuilders.h), so they can be compared byte for byte.
+
+        Note: Only the nodes that the last build used mean anything (see 
+        CountInvalidBvhNodes(...)).  The rest are left over from whenever they were last used.
+
+        Also Note: This maps the buffers, so it is a pipeline stall.  It is for profiling and 
+        benchmarks only.
+    Parameters: 
+        nodes       Receives all of them.
+        buildData   Receives all of them.
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::ReadBackBvh(std::vector<BvhNode> &nodes, 
+        std::vector<BvhNodeBuildData> &buildData) const
+    {
+        nodes.resize(_bvhNodeSsbo.NumTotalNodes());
+        unsigned int bufferSizeBytes = nodes.size() * sizeof(BvhNode);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bvhNodeSsbo.BufferId());
+        void *bufferPtr = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, bufferSizeBytes, GL_MAP_READ_BIT);
+        memcpy(nodes.data(), bufferPtr, bufferSizeBytes);
+        glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+
+        buildData.resize(_bvhNodeSsbo.NumTotalNodes());
+        bufferSizeBytes = buildData.size() * sizeof(BvhNodeBuildData);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bvhNodeBuildDataSsbo.BufferId());
+        bufferPtr = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, bufferSizeBytes, GL_MAP_READ_BIT);
+        memcpy(buildData.data(), bufferPtr, bufferSizeBytes);
+        glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Reads back the bounds that the last sort's Morton Codes were normalized against (see 
+        SceneBoundsLayout.comp).  That is the fixed particle region unless the dynamic bounds 
+        are on (see SetDynamicMortonCodeBounds(...)), so the CPU can make the same keys either 
+        way (see MortonCode.h).
+
+        Note: This is a glGetBufferSubData(...), so it is a pipeline stall.  It is for 
+        profiling and benchmarks only.
+    Parameters: None
+    Returns:    
+        A copy of the bounds.
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    SceneBounds ParticleCollisions::ReadSceneBounds() const
+    {
+        SceneBounds bounds(glm::vec4(0.0f), glm::vec4(0.0f));
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _sceneBoundsSsbo.BufferId());
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(SceneBounds), &bounds);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        return bounds;
+    }
+
     /*--------------------------------------------------------------------------------------------
     Description:
         Used so that the RenderGeometry shader controller can draw the lines that indicate where 
@@ -314,6 +882,9 @@ namespace ShaderControllers
         The GLSL version declaration, compute shader work group sizes, 
         cross-shader uniform locations, and SSBO buffer bindings are used in very compute 
         shader.  This function puts their assembly into one place.
+
+        Note: BVH_MAX_PARTICLES_PER_LEAF goes in here too so that every shader agrees on it.  
+        It has to come after the version declaration.
     Parameters: 
         The key to the composite shader that is under construction.
     Returns:    None
@@ -323,228 +894,232 @@ namespace ShaderControllers
     {
         ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
         shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ShaderHeaders/Version.comp");
+
+        // not a file because each ParticleCollisions can have its own (see BvhLeaves.comp)
+        shaderStorageRef.AddPartialShaderContents(shaderKey, 
+            "#define BVH_MAX_PARTICLES_PER_LEAF " + std::to_string(_maxParticlesPerBvhLeaf) + "\n");
+
         shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ShaderHeaders/ComputeShaderWorkGroupSizes.comp");
         shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ShaderHeaders/SsboBufferBindings.comp");
         shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/ShaderHeaders/CrossShaderUniformLocations.comp");
-    }
-
-    /*--------------------------------------------------------------------------------------------
-    Description:
-        Assembles headers, buffers, and functional .comp files for the shader that prepares the 
-        ParticleBuffer for the final stage of particle sorting in SortParticles.comp.
-    Parameters: None
-    Returns:    None
-    Creator:    John Cox, 5/2017
-    --------------------------------------------------------------------------------------------*/
-    void ParticleCollisions::AssembleProgramCopyParticlesToCopyBuffer()
-    {
-        ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
 
-        std::string shaderKey = "copy particles to copy buffer";
-        shaderStorageRef.NewCompositeShader(shaderKey);
-        AssembleProgramHeader(shaderKey);
-        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleBuffer.comp");
-        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/CopyParticlesToCopyBuffer.comp");
-        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
-        shaderStorageRef.LinkShader(shaderKey);
-        _programIdCopyParticlesToCopyBuffer = shaderStorageRef.GetShaderProgram(shaderKey);
+        // every shader that includes ParticleSortingDataBuffer.comp needs the key width
+        shaderStorageRef.AddPartialShaderFile(shaderKey, GpuKeyValueSorter::SortingKeyShaderFilePath(MortonCodeKeyWidth(_mortonCodeEncoding)));
     }
 
     /*--------------------------------------------------------------------------------------------
     Description:
-        Assembles headers, buffers, and functional .comp files for the shader that prepares the 
-        data over which particles will be sorted.
+        Assembles headers, buffers, and functional .comp files for the shader that finds the 
+        min and max of the active particles' positions.
+
+        Part of the dynamic Morton Code bounds.
     Parameters: None
     Returns:    None
-    Creator:    John Cox, 5/2017
+    Creator:    John Cox, 7/2017
     --------------------------------------------------------------------------------------------*/
-    void ParticleCollisions::AssembleProgramGenerateSortingData()
+    void ParticleCollisions::AssembleProgramComputeSceneBounds()
     {
         ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
 
-        std::string shaderKey = "generate sorting data";
+        std::string shaderKey = "compute scene bounds";
         shaderStorageRef.NewCompositeShader(shaderKey);
         AssembleProgramHeader(shaderKey);
-        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleRegionBoundaries.comp");
-        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/PositionToMortonCode.comp");
         shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleBuffer.comp");
-        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticleSortingDataBuffer.comp");
-        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/GenerateSortingData.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/SceneBoundsLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/SceneBoundsBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ComputeSceneBounds.comp");
         shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
         shaderStorageRef.LinkShader(shaderKey);
-        _programIdGenerateSortingData = shaderStorageRef.GetShaderProgram(shaderKey);
+        _programIdComputeSceneBounds = shaderStorageRef.GetShaderProgram(shaderKey);
     }
 
     /*--------------------------------------------------------------------------------------------
     Description:
-        Assembles headers, buffers, and functional .comp files for the shader that resets the 
-        prefix sum for each work group's result to 0.
+        Assembles headers, buffers, and functional .comp files for the shader that turns the 
+        min and max into the bounds that the Morton Codes are normalized against.
 
-        Part off the radix sort loop.
+        Part of the dynamic Morton Code bounds.
     Parameters: None
     Returns:    None
-    Creator:    John Cox, 5/2017
+    Creator:    John Cox, 7/2017
     --------------------------------------------------------------------------------------------*/
-    void ParticleCollisions::AssembleProgramClearWorkGroupSums()
+    void ParticleCollisions::AssembleProgramFinalizeSceneBounds()
     {
         ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
 
-        std::string shaderKey = "clear work group sums";
+        std::string shaderKey = "finalize scene bounds";
         shaderStorageRef.NewCompositeShader(shaderKey);
         AssembleProgramHeader(shaderKey);
-        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/PrefixScanBuffer.comp");
-        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ClearWorkGroupSums.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleRegionBoundaries.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/SceneBoundsLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/SceneBoundsBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/FinalizeSceneBounds.comp");
         shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
         shaderStorageRef.LinkShader(shaderKey);
-        _programIdClearWorkGroupSums = shaderStorageRef.GetShaderProgram(shaderKey);
+        _programIdFinalizeSceneBounds = shaderStorageRef.GetShaderProgram(shaderKey);
     }
 
     /*--------------------------------------------------------------------------------------------
     Description:
-        Assembles headers, buffers, and functional .comp files for the shader that extracts a 
-        single bit from the sorting data for use during the prefix scan.
-
-        Part of the radix sort loop.
+        Assembles headers, buffers, and functional .comp files for the shader that prepares the 
+        data over which particles will be sorted.
     Parameters: None
     Returns:    None
     Creator:    John Cox, 5/2017
     --------------------------------------------------------------------------------------------*/
-    void ParticleCollisions::AssembleProgramGetBitForPrefixScan()
+    void ParticleCollisions::AssembleProgramGenerateSortingData()
     {
         ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
 
-        std::string shaderKey = "get bit for prefix scan";
+        std::string shaderKey = "generate sorting data";
         shaderStorageRef.NewCompositeShader(shaderKey);
         AssembleProgramHeader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleRegionBoundaries.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, MortonCodeShaderFilePath(_mortonCodeEncoding));
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleBuffer.comp");
         shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticleSortingDataBuffer.comp");
         shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/PrefixScanBuffer.comp");
-        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/GetBitForPrefixScan.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/SceneBoundsLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/SceneBoundsBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/GenerateSortingData.comp");
         shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
         shaderStorageRef.LinkShader(shaderKey);
-        _programIdGetBitForPrefixScan = shaderStorageRef.GetShaderProgram(shaderKey);
+        _programIdGenerateSortingData = shaderStorageRef.GetShaderProgram(shaderKey);
     }
 
     /*--------------------------------------------------------------------------------------------
     Description:
-        Assembles headers, buffers, and functional .comp files for the shader that runs the 
-        first part of the prefix scan. 
-
-        Part of the radix sort loop.
+        Assembles headers, buffers, and functional .comp files for the shader that moves the 
+        active particles' sorting data to the front and counts them.
     Parameters: None
     Returns:    None
-    Creator:    John Cox, 5/2017
+    Creator:    John Cox, 7/2017
     --------------------------------------------------------------------------------------------*/
-    void ParticleCollisions::AssembleProgramPrefixScanOverAllData()
+    void ParticleCollisions::AssembleProgramCompactSortingData()
     {
         ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
 
-        std::string shaderKey = "prefix scan over all data";
+        std::string shaderKey = "compact sorting data";
         shaderStorageRef.NewCompositeShader(shaderKey);
         AssembleProgramHeader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticleSortingDataBuffer.comp");
         shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/PrefixScanBuffer.comp");
-        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/PrefixScanOverAllData.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/IncrementalSortLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ActiveParticlesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/CompactSortingData.comp");
         shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
         shaderStorageRef.LinkShader(shaderKey);
-        _programIdPrefixScanOverAllData = shaderStorageRef.GetShaderProgram(shaderKey);
+        _programIdCompactSortingData = shaderStorageRef.GetShaderProgram(shaderKey);
     }
 
     /*--------------------------------------------------------------------------------------------
     Description:
-        Assembles headers, buffers, and functional .comp files for the shader that runs the
-        second part of the prefix scan.
-
-        Part of the radix sort loop.
+        Assembles headers, buffers, and functional .comp files for the shader that gathers 
+        particles from the front half of the ParticleSsbo into their sorted position in the back 
+        half.
     Parameters: None
     Returns:    None
     Creator:    John Cox, 5/2017
     --------------------------------------------------------------------------------------------*/
-    void ParticleCollisions::AssembleProgramPrefixScanOverWorkGroupSums()
+    void ParticleCollisions::AssembleProgramSortParticles()
     {
         ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
 
-        std::string shaderKey = "prefix scan over work group sums";
+        std::string shaderKey = "sort particles";
         shaderStorageRef.NewCompositeShader(shaderKey);
         AssembleProgramHeader(shaderKey);
-        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/PrefixScanBuffer.comp");
-        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/PrefixScanOverWorkGroupSums.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticleBackBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticleSortingDataBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/SortParticles.comp");
         shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
         shaderStorageRef.LinkShader(shaderKey);
-        _programIdPrefixScanOverWorkGroupSums = shaderStorageRef.GetShaderProgram(shaderKey);
+        _programIdSortParticles = shaderStorageRef.GetShaderProgram(shaderKey);
     }
 
     /*--------------------------------------------------------------------------------------------
     Description:
-        Assembles headers, buffers, and functional .comp files for the shader that sorts the 
-        sorting data given the results of the prefix scan.
+        Assembles headers, buffers, and functional .comp files for the shader that measures how 
+        far apart neighboring leaves' particles are in the ParticleBuffer.
 
-        Part of the radix sort loop.
+        Part of the lazy particle reorder.
     Parameters: None
     Returns:    None
-    Creator:    John Cox, 5/2017
+    Creator:    John Cox, 7/2017
     --------------------------------------------------------------------------------------------*/
-    void ParticleCollisions::AssembleProgramSortSortingDataWithPrefixSums()
+    void ParticleCollisions::AssembleProgramMeasureParticleLocality()
     {
         ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
 
-        std::string shaderKey = "sort sorting data with prefix sums";
+        std::string shaderKey = "measure particle locality";
         shaderStorageRef.NewCompositeShader(shaderKey);
         AssembleProgramHeader(shaderKey);
         shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticleSortingDataBuffer.comp");
-        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/PrefixScanBuffer.comp");
-        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/SortSortingDataWithPrefixSums.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/LeafToParticleIndex.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ParticleReorderLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticleReorderBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ActiveParticlesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/MeasureParticleLocality.comp");
         shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
         shaderStorageRef.LinkShader(shaderKey);
-        _programIdSortSortingDataWithPrefixSums = shaderStorageRef.GetShaderProgram(shaderKey);
+        _programIdMeasureParticleLocality = shaderStorageRef.GetShaderProgram(shaderKey);
     }
 
     /*--------------------------------------------------------------------------------------------
     Description:
-        Assembles headers, buffers, and functional .comp files for the shader that copies 
-        particles from the second half of the ParticleBuffer to their sorted position in the 
-        first half.  This program is the complement to CopyParticlesToCopyBuffer.comp.
+        Assembles headers, buffers, and functional .comp files for the shader that decides 
+        whether the particles should be moved into sorted order this frame.
+
+        Part of the lazy particle reorder.
     Parameters: None
     Returns:    None
-    Creator:    John Cox, 5/2017
+    Creator:    John Cox, 7/2017
     --------------------------------------------------------------------------------------------*/
-    void ParticleCollisions::AssembleProgramSortParticles()
+    void ParticleCollisions::AssembleProgramPlanParticleReorder()
     {
         ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
 
-        std::string shaderKey = "sort particles";
+        std::string shaderKey = "plan particle reorder";
         shaderStorageRef.NewCompositeShader(shaderKey);
         AssembleProgramHeader(shaderKey);
         shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleBuffer.comp");
-        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticleSortingDataBuffer.comp");
-        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/SortParticles.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ParticleReorderLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticleReorderBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ActiveParticlesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/PlanParticleReorder.comp");
         shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
         shaderStorageRef.LinkShader(shaderKey);
-        _programIdSortParticles = shaderStorageRef.GetShaderProgram(shaderKey);
+        _programIdPlanParticleReorder = shaderStorageRef.GetShaderProgram(shaderKey);
     }
 
     /*--------------------------------------------------------------------------------------------
     Description:
-        Assembles headers, buffers, and functional .comp files for the shader that modifies the 
-        data over which particles were sorted so that every entry is unique.  This will prevent 
-        depth spikes in the binary radix tree.
+        Assembles headers, buffers, and functional .comp files for the shader that copies the 
+        sorted particles from the back half of the ParticleSsbo to the front half.
 
-        Note: As mentioned in GuaranteeSortingDataUniqueness.comp, this shader CANNOT be 
-        summoned before the sorting is done.
+        Part of the lazy particle reorder.
     Parameters: None
     Returns:    None
-    Creator:    John Cox, 5/2017
+    Creator:    John Cox, 7/2017
     --------------------------------------------------------------------------------------------*/
-    void ParticleCollisions::AssembleProgramGuaranteeSortingDataUniqueness() 
+    void ParticleCollisions::AssembleProgramCopyParticlesFromBackBuffer()
     {
         ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
 
-        std::string shaderKey = "guarantee sorting data uniqueness";
+        std::string shaderKey = "copy particles from back buffer";
         shaderStorageRef.NewCompositeShader(shaderKey);
         AssembleProgramHeader(shaderKey);
-        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticleSortingDataBuffer.comp");
-        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/GuaranteeSortingDataUniqueness.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticleBackBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/CopyParticlesFromBackBuffer.comp");
         shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
         shaderStorageRef.LinkShader(shaderKey);
-        _programIdGuaranteeSortingDataUniqueness = shaderStorageRef.GetShaderProgram(shaderKey);
+        _programIdCopyParticlesFromBackBuffer = shaderStorageRef.GetShaderProgram(shaderKey);
     }
 
     /*--------------------------------------------------------------------------------------------
@@ -570,7 +1145,16 @@ namespace ShaderControllers
         AssembleProgramHeader(shaderKey);
         shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleBuffer.comp");
         shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticlePropertiesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhNodeLayout.comp");
         shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhNodeBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ActiveParticlesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticleSortingDataBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/LeafToParticleIndex.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhLeaves.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhRefitLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ParticleBoundingBox.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhRefitBuffer.comp");
         shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/GenerateLeafNodeBoundingBoxes.comp");
         shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
         shaderStorageRef.LinkShader(shaderKey);
@@ -597,7 +1181,12 @@ namespace ShaderControllers
         shaderStorageRef.NewCompositeShader(shaderKey);
         AssembleProgramHeader(shaderKey);
         shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticleSortingDataBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhNodeLayout.comp");
         shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhNodeBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhNodeBuildDataBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ActiveParticlesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhLeaves.comp");
         shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/GenerateBinaryRadixTree.comp");
         shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
         shaderStorageRef.LinkShader(shaderKey);
@@ -622,7 +1211,12 @@ namespace ShaderControllers
         std::string shaderKey = "merge bounding volumes";
         shaderStorageRef.NewCompositeShader(shaderKey);
         AssembleProgramHeader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhNodeLayout.comp");
         shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhNodeBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhNodeBuildDataBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ActiveParticlesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhLeaves.comp");
         shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/MergeBoundingVolumes.comp");
         shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
         shaderStorageRef.LinkShader(shaderKey);
@@ -631,52 +1225,464 @@ namespace ShaderControllers
 
     /*--------------------------------------------------------------------------------------------
     Description:
-        Assembles headers, buffers, and functional .comp files for the shader that takes leaf 
-        node bounding boxes and figures out which other, if any, leaf node bounding boxes it 
-        overlaps with.  Fills out the ParticlePotentialCollisionsBuffer.
-
-        The whole purpose of creating a BVH was to use this shader for particle-particle 
-        collision detection.
+        Assembles headers, buffers, and functional .comp files for the shader that builds the 
+        whole BVH in one go (see SetBvhBuilder(...)).  It does the jobs of 
+        GenerateLeafNodeBoundingBoxes.comp, GenerateBinaryRadixTree.comp, and 
+        MergeBoundingVolumes.comp, so it needs all of their buffers.
     Parameters: None
     Returns:    None
-    Creator:    John Cox, 6/2017
+    Creator:    John Cox, 7/2017
     --------------------------------------------------------------------------------------------*/
-    void ParticleCollisions::AssembleProgramDetectCollisions()
+    void ParticleCollisions::AssembleProgramBuildBvhAgglomerative()
     {
         ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
 
-        std::string shaderKey = "detect collisions";
+        std::string shaderKey = "build bvh agglomerative";
         shaderStorageRef.NewCompositeShader(shaderKey);
         AssembleProgramHeader(shaderKey);
-        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhNodeBuffer.comp");
         shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleBuffer.comp");
-        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/MaxNumPotentialCollisions.comp");
-        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticlePotentialCollisionsBuffer.comp");
-        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/DetectCollisions.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticlePropertiesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticleSortingDataBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhNodeLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhNodeBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhNodeBuildDataBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ActiveParticlesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/LeafToParticleIndex.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhLeaves.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhRefitLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ParticleBoundingBox.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BuildBvhAgglomerative.comp");
         shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
         shaderStorageRef.LinkShader(shaderKey);
-        _programIdDetectCollisions = shaderStorageRef.GetShaderProgram(shaderKey);
+        _programIdBuildBvhAgglomerative = shaderStorageRef.GetShaderProgram(shaderKey);
     }
 
     /*--------------------------------------------------------------------------------------------
     Description:
-        Assembles headers, buffers, and functional .comp files for the shader that performs 
-        collisions between particles and that gives them new velocity vectors.  
+        Assembles headers, buffers, and functional .comp files for the shader that starts the 
+        PLOC builder off with every leaf as its own cluster (see BvhClusterLayout.comp).
     Parameters: None
     Returns:    None
-    Creator:    John Cox, 6/2017
+    Creator:    John Cox, 7/2017
     --------------------------------------------------------------------------------------------*/
-    void ParticleCollisions::AssembleProgramResolveCollisions()
+    void ParticleCollisions::AssembleProgramInitBvhClusters()
     {
         ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
 
-        std::string shaderKey = "resolve collisions";
+        std::string shaderKey = "init bvh clusters";
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        AssembleProgramHeader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ActiveParticlesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhLeaves.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhClusterLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhClusterBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/InitBvhClusters.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        shaderStorageRef.LinkShader(shaderKey);
+        _programIdInitBvhClusters = shaderStorageRef.GetShaderProgram(shaderKey);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Assembles headers, buffers, and functional .comp files for the shader that has each of 
+        the PLOC builder's clusters find the one that it would make the smallest box with.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::AssembleProgramFindBvhClusterNearestNeighbors()
+    {
+        ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+
+        std::string shaderKey = "find bvh cluster nearest neighbors";
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        AssembleProgramHeader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhNodeLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhNodeBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhClusterLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhClusterBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/FindBvhClusterNearestNeighbors.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        shaderStorageRef.LinkShader(shaderKey);
+        _programIdFindBvhClusterNearestNeighbors = shaderStorageRef.GetShaderProgram(shaderKey);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Assembles headers, buffers, and functional .comp files for the shader that merges the 
+        PLOC builder's clusters that found each other into new internal nodes.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::AssembleProgramMergeBvhClusters()
+    {
+        ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+
+        std::string shaderKey = "merge bvh clusters";
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        AssembleProgramHeader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhNodeLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhNodeBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhNodeBuildDataBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/PrefixScanBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhClusterLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhClusterBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/MergeBvhClusters.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        shaderStorageRef.LinkShader(shaderKey);
+        _programIdMergeBvhClusters = shaderStorageRef.GetShaderProgram(shaderKey);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Assembles headers, buffers, and functional .comp files for the shader that closes the 
+        gaps in the PLOC builder's list of clusters after they have been merged.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::AssembleProgramCompactBvhClusters()
+    {
+        ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+
+        std::string shaderKey = "compact bvh clusters";
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        AssembleProgramHeader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/PrefixScanBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhClusterLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhClusterBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/CompactBvhClusters.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        shaderStorageRef.LinkShader(shaderKey);
+        _programIdCompactBvhClusters = shaderStorageRef.GetShaderProgram(shaderKey);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Assembles headers, buffers, and functional .comp files for the shader that sets up the 
+        PLOC builder's next round.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::AssembleProgramCountBvhClusters()
+    {
+        ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+
+        std::string shaderKey = "count bvh clusters";
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        AssembleProgramHeader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/PrefixScanBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhClusterLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhClusterBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/CountBvhClusters.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        shaderStorageRef.LinkShader(shaderKey);
+        _programIdCountBvhClusters = shaderStorageRef.GetShaderProgram(shaderKey);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Assembles headers, buffers, and functional .comp files for the shader that rearranges a 
+        finished BVH into a better one (see SetBvhTreeletRestructuring(...)).  It only works 
+        on the tree itself, so it doesn't need the particles.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::AssembleProgramRestructureBvhTreelets()
+    {
+        ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+
+        std::string shaderKey = "restructure bvh treelets";
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        AssembleProgramHeader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhNodeLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhNodeBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhNodeBuildDataBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ActiveParticlesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhLeaves.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/RestructureBvhTreelets.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        shaderStorageRef.LinkShader(shaderKey);
+        _programIdRestructureBvhTreelets = shaderStorageRef.GetShaderProgram(shaderKey);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Assembles headers, buffers, and functional .comp files for the shader that makes the 
+        4-wide BVH out of the binary one.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::AssembleProgramCollapseBvhToWideNodes()
+    {
+        ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+
+        std::string shaderKey = "collapse bvh to wide nodes";
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        AssembleProgramHeader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhNodeLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhNodeBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhWideNodeBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ActiveParticlesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhLeaves.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/CollapseBvhToWideNodes.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        shaderStorageRef.LinkShader(shaderKey);
+        _programIdCollapseBvhToWideNodes = shaderStorageRef.GetShaderProgram(shaderKey);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Assembles headers, buffers, and functional .comp files for the shader that makes the 
+        quantized copies of the BVH's nodes.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::AssembleProgramQuantizeBvhNodes()
+    {
+        ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+
+        std::string shaderKey = "quantize bvh nodes";
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        AssembleProgramHeader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhNodeLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhNodeBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhQuantizedNodeBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ActiveParticlesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhLeaves.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/QuantizeBvhNodes.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        shaderStorageRef.LinkShader(shaderKey);
+        _programIdQuantizeBvhNodes = shaderStorageRef.GetShaderProgram(shaderKey);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Assembles headers, buffers, and functional .comp files for the shader that counts the 
+        active particles wherever they are in the ParticleBuffer.
+
+        Part of the BVH refit.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::AssembleProgramCountActiveParticles()
+    {
+        ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+
+        std::string shaderKey = "count active particles";
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        AssembleProgramHeader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhRefitLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhRefitBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/CountActiveParticles.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        shaderStorageRef.LinkShader(shaderKey);
+        _programIdCountActiveParticles = shaderStorageRef.GetShaderProgram(shaderKey);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Assembles headers, buffers, and functional .comp files for the shader that adds up the 
+        size of the internal nodes' bounding boxes.
+
+        Part of the BVH refit.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::AssembleProgramMeasureBvhArea()
+    {
+        ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+
+        std::string shaderKey = "measure bvh area";
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        AssembleProgramHeader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhNodeLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhNodeBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ActiveParticlesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhLeaves.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhRefitLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhRefitBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/MeasureBvhArea.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        shaderStorageRef.LinkShader(shaderKey);
+        _programIdMeasureBvhArea = shaderStorageRef.GetShaderProgram(shaderKey);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Assembles headers, buffers, and functional .comp files for the shader that decides 
+        whether the BVH should be rebuilt next frame.
+
+        Part of the BVH refit.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::AssembleProgramPlanBvhRefit()
+    {
+        ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+
+        std::string shaderKey = "plan bvh refit";
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        AssembleProgramHeader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ActiveParticlesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhRefitLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhRefitBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/PlanBvhRefit.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        shaderStorageRef.LinkShader(shaderKey);
+        _programIdPlanBvhRefit = shaderStorageRef.GetShaderProgram(shaderKey);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Assembles headers, buffers, and functional .comp files for the shader that takes each 
+        particle's bounding box and figures out which other particles', if any, it overlaps 
+        with.  Fills out the ParticlePotentialCollisionsBuffer.
+
+        The whole purpose of creating a BVH was to use this shader for particle-particle 
+        collision detection.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 6/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::AssembleProgramDetectCollisions()
+    {
+        ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+
+        std::string shaderKey = "detect collisions";
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        AssembleProgramHeader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhNodeLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhNodeBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticlePropertiesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/MaxNumPotentialCollisions.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticlePotentialCollisionsBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ActiveParticlesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticleSortingDataBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/LeafToParticleIndex.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhLeaves.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhRefitLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ParticleBoundingBox.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/DetectCollisions.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        shaderStorageRef.LinkShader(shaderKey);
+        _programIdDetectCollisions = shaderStorageRef.GetShaderProgram(shaderKey);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Like AssembleProgramDetectCollisions(), but the shader goes through the 4-wide BVH 
+        instead of the binary one.  It is the same DetectCollisions.comp.  
+        BvhWideNodeBuffer.comp #defines BVH_WIDE_NODES, and that switches the traversal.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::AssembleProgramDetectCollisionsWideBvh()
+    {
+        ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+
+        std::string shaderKey = "detect collisions wide bvh";
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        AssembleProgramHeader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhNodeLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhNodeBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhWideNodeBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticlePropertiesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/MaxNumPotentialCollisions.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticlePotentialCollisionsBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ActiveParticlesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticleSortingDataBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/LeafToParticleIndex.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhLeaves.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhRefitLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ParticleBoundingBox.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/DetectCollisions.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        shaderStorageRef.LinkShader(shaderKey);
+        _programIdDetectCollisionsWideBvh = shaderStorageRef.GetShaderProgram(shaderKey);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Like AssembleProgramDetectCollisions(), but the shader goes through the quantized nodes 
+        instead of the binary ones.  It is the same DetectCollisions.comp.  
+        BvhQuantizedNodeBuffer.comp #defines BVH_QUANTIZED_NODES, and that switches the 
+        traversal.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::AssembleProgramDetectCollisionsQuantizedBvh()
+    {
+        ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+
+        std::string shaderKey = "detect collisions quantized bvh";
+        shaderStorageRef.NewCompositeShader(shaderKey);
+        AssembleProgramHeader(shaderKey);
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhNodeLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhNodeBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/BvhQuantizedNodeBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticlePropertiesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/MaxNumPotentialCollisions.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticlePotentialCollisionsBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ActiveParticlesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticleSortingDataBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/LeafToParticleIndex.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhLeaves.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/BvhRefitLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ParticleBoundingBox.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/DetectCollisions.comp");
+        shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
+        shaderStorageRef.LinkShader(shaderKey);
+        _programIdDetectCollisionsQuantizedBvh = shaderStorageRef.GetShaderProgram(shaderKey);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Assembles headers, buffers, and functional .comp files for the shader that performs 
+        collisions between particles and that gives them new velocity vectors.  
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 6/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::AssembleProgramResolveCollisions()
+    {
+        ShaderStorage &shaderStorageRef = ShaderStorage::GetInstance();
+
+        std::string shaderKey = "resolve collisions";
         shaderStorageRef.NewCompositeShader(shaderKey);
         AssembleProgramHeader(shaderKey);
         shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/MaxNumPotentialCollisions.comp");
         shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticlePotentialCollisionsBuffer.comp");
         shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticlePropertiesBuffer.comp");
         shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ActiveParticlesLayout.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ActiveParticlesBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/Buffers/ParticleSortingDataBuffer.comp");
+        shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/LeafToParticleIndex.comp");
         shaderStorageRef.AddPartialShaderFile(shaderKey, "Shaders/Compute/ParticleCollisions/ResolveCollisions.comp");
         shaderStorageRef.CompileCompositeShader(shaderKey, GL_COMPUTE_SHADER);
         shaderStorageRef.LinkShader(shaderKey);
@@ -735,47 +1741,43 @@ namespace ShaderControllers
         _programIdGenerateVerticesParticleBoundingBoxes = shaderStorageRef.GetShaderProgram(shaderKey);
     }
 
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Most shaders work on 1 item per thread.  This is the work group count for doing that 
+        over every particle.
+
+        Note: The prefix scan works on 2 items per thread (see 
+        PREFIX_SCAN_ITEMS_PER_WORK_GROUP), but it belongs to the sorter, and the sorter works 
+        out its own work group count (see GpuKeyValueSorter::PrefixScanOverAllItems()).
+    Parameters: 
+        numWorkGroupsX  Receives the work group count for 1 item per thread.
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::CalculateNumWorkGroups(unsigned int &numWorkGroupsX) const
+    {
+        numWorkGroupsX = _numParticles / WORK_GROUP_SIZE_X;
+        unsigned int remainder = _numParticles % WORK_GROUP_SIZE_X;
+        numWorkGroupsX += (remainder == 0) ? 0 : 1;
+    }
+
     /*--------------------------------------------------------------------------------------------
     Description:
         This method governs the shader dispatches that will result in sorting the ParticleBuffer 
         and ParticleSortingDataBuffer.
     Parameters: 
         numWorkGroupsX  Expected to be the total particle count divided by work group size.
-        numWorkGroupsXPrefixScan    See comment where this value was calculated.
     Returns:    None
     Creator:    John Cox, 6/2017
     --------------------------------------------------------------------------------------------*/
-    void ParticleCollisions::SortParticlesWithoutProfiling(unsigned int numWorkGroupsX, unsigned int numWorkGroupsXPrefixScan) const
+    void ParticleCollisions::SortParticlesWithoutProfiling(unsigned int numWorkGroupsX) const
     {
         PrepareToSortParticles(numWorkGroupsX);
+        CompactSortingData(numWorkGroupsX);
+        _sorter.Sort(_particleSortingDataSsbo, _activeParticlesSsbo);
 
-        // parallel radix sorting algorithm over each bit of the Morton Codes 
-        // Note: MUST sort over all 32 bits in GLSL's uint.  See GenerateSortingData.comp for 
-        // more detail, but the gist is that the sorting data for inactive particles is 
-        // 0xC0000000 for generating the BVH tree.  That is 2x 1s in the 30th and 31st bit, and 
-        // the least significant 30bits are 0s.  Sorting these inactive particles to the back 
-        // therefore requires sorting over all 32 bits (actually, I think that I could get away 
-        // with sorting 31 bits..??should I??)
-        unsigned int totalBitCount = 32;
-
-        bool writeToSecondBuffer = true;
-        unsigned int sortingDataReadBufferOffset = 0;
-        unsigned int sortingDataWriteBufferOffset = 0;
-        for (unsigned int bitNumber = 0; bitNumber < totalBitCount; bitNumber++)
-        {
-            sortingDataReadBufferOffset = static_cast<unsigned int>(!writeToSecondBuffer) * _numParticles;
-            sortingDataWriteBufferOffset = static_cast<unsigned int>(writeToSecondBuffer) * _numParticles;
-
-            PrepareForPrefixScan(bitNumber, sortingDataReadBufferOffset);
-            PrefixScanOverParticleSortingData(numWorkGroupsXPrefixScan);
-            SortSortingDataWithPrefixScan(numWorkGroupsX, bitNumber, sortingDataReadBufferOffset, sortingDataWriteBufferOffset);
-
-            // swap read/write buffers and do it again
-            writeToSecondBuffer = !writeToSecondBuffer;
-        }
-
-        // the sorting data's final location is in the "write" half of the sorting data buffer
-        SortParticlesWithSortedData(numWorkGroupsX, sortingDataWriteBufferOffset);
+        // the sorter always leaves the sorted data in the first half of the sorting data buffer
+        SortParticlesWithSortedData(numWorkGroupsX, 0);
 
         // all done
         glUseProgram(0);
@@ -787,31 +1789,26 @@ namespace ShaderControllers
         (1) std::chrono calls 
         (2) forced wait for shader to finish so that the std::chrono calls get an accurate 
             reading for how long the shader takes 
-        (3) verification that the sort resulted in smallest->largest values in 
-            ParticleSortingDataBuffer (can't check the ParticleBuffer itself for sorting because 
-            particles don't carry the sorting data with them)
+        (3) the sorter's own profiling, which checks the sorting data against the CPU reference 
+            sort and breaks its time down by pass (see GpuKeyValueSorter::SortWithProfiling(...))
         (4) writing the output to a file (if desired)
     Parameters: 
         numWorkGroupsX  Expected to be the total particle count divided by work group size.
-        numWorkGroupsXPrefixScan    See comment where this value was calculated.
     Returns:    None
     Creator:    John Cox, 6/2017
     --------------------------------------------------------------------------------------------*/
-    void ParticleCollisions::SortParticlesWithProfiling(unsigned int numWorkGroupsX, unsigned int numWorkGroupsXPrefixScan) const
+    void ParticleCollisions::SortParticlesWithProfiling(unsigned int numWorkGroupsX) const
     {
         cout << "sorting " << _numParticles << " particles" << endl;
-        unsigned int totalBitCount = 32;
 
         // for profiling
         using namespace std::chrono;
         steady_clock::time_point start;
         steady_clock::time_point end;
         long long durationPrepareToSort = 0;
+        long long durationCompactSortingData = 0;
+        long long durationSortSortingData = 0;
         long long durationParticleSort = 0;
-        long long durationSortVerification = 0;
-        std::vector<long long> durationsPrepareForPrefixScan(totalBitCount);
-        std::vector<long long> durationsPrefixScan(totalBitCount);
-        std::vector<long long> durationsSortSortingData(totalBitCount);
 
         start = high_resolution_clock::now();
         PrepareToSortParticles(numWorkGroupsX);
@@ -819,119 +1816,69 @@ namespace ShaderControllers
         end = high_resolution_clock::now();
         durationPrepareToSort = duration_cast<microseconds>(end - start).count();
 
-        bool writeToSecondBuffer = true;
-        unsigned int sortingDataReadBufferOffset = 0;
-        unsigned int sortingDataWriteBufferOffset = 0;
-        for (unsigned int bitNumber = 0; bitNumber < totalBitCount; bitNumber++)
-        {
-            sortingDataReadBufferOffset = static_cast<unsigned int>(!writeToSecondBuffer) * _numParticles;
-            sortingDataWriteBufferOffset = static_cast<unsigned int>(writeToSecondBuffer) * _numParticles;
+        start = high_resolution_clock::now();
+        CompactSortingData(numWorkGroupsX);
+        WaitForComputeToFinish();
+        end = high_resolution_clock::now();
+        durationCompactSortingData = duration_cast<microseconds>(end - start).count();
 
-            start = high_resolution_clock::now();
-            PrepareForPrefixScan(bitNumber, sortingDataReadBufferOffset);
-            WaitForComputeToFinish();
-            end = high_resolution_clock::now();
-            durationsPrepareForPrefixScan[bitNumber] = duration_cast<microseconds>(end - start).count();
+        // how many particles are active?
+        // Note: This readback stalls the pipeline, which is fine when profiling but is why the 
+        // non-profiling version never asks.
+        unsigned int numActiveParticles = 0;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _activeParticlesSsbo.BufferId());
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, _activeParticlesSsbo.NumActiveParticlesByteOffset(), sizeof(unsigned int), &numActiveParticles);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 
-            start = high_resolution_clock::now();
-            PrefixScanOverParticleSortingData(numWorkGroupsXPrefixScan);
-            WaitForComputeToFinish();
-            end = high_resolution_clock::now();
-            durationsPrefixScan[bitNumber] = duration_cast<microseconds>(end - start).count();
+        // the sorter times itself, stage by stage
+        durationSortSortingData = _sorter.SortWithProfiling(_particleSortingDataSsbo, _activeParticlesSsbo);
 
-            start = high_resolution_clock::now();
-            SortSortingDataWithPrefixScan(numWorkGroupsX, bitNumber, sortingDataReadBufferOffset, sortingDataWriteBufferOffset);
-            WaitForComputeToFinish();
-            end = high_resolution_clock::now();
-            durationsSortSortingData[bitNumber] = duration_cast<microseconds>(end - start).count();
-
-            // swap read/write buffers and do it again
-            writeToSecondBuffer = !writeToSecondBuffer;
-        }
-
-        // wherever the sorting data ended up, that is where the shader should read from
         start = high_resolution_clock::now();
-        SortParticlesWithSortedData(numWorkGroupsX, sortingDataWriteBufferOffset);
+        SortParticlesWithSortedData(numWorkGroupsX, 0);
         WaitForComputeToFinish();
         end = high_resolution_clock::now();
         durationParticleSort = duration_cast<microseconds>(end - start).count();
 
-        // verify sorted data
-        // Note: Only need to copy the first half of the buffer.  This is where the last loop of 
-        // the radix sorting algorithm put the sorting data.
-        start = high_resolution_clock::now();
-        unsigned int startingIndex = sortingDataWriteBufferOffset;
-        std::vector<ParticleSortingData> checkSortingData(_particleSortingDataSsbo.NumItems());
-        unsigned int bufferSizeBytes = checkSortingData.size() * sizeof(ParticleSortingData);
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _particleSortingDataSsbo.BufferId());
-        void *bufferPtr = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, startingIndex, bufferSizeBytes, GL_MAP_READ_BIT);
-        memcpy(checkSortingData.data(), bufferPtr, bufferSizeBytes);
-        glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
-        for (unsigned int i = 1; i < checkSortingData.size(); i++)
-        {
-            // start at 1 so that prevIndex isn't out of bounds
-            unsigned int thisIndex = i;
-            unsigned int prevIndex = i - 1;
-            unsigned int val = checkSortingData[thisIndex]._sortingData;
-            unsigned int prevVal = checkSortingData[prevIndex]._sortingData;
-            if (val < prevVal)
-            {
-                printf("value %u at index %u is >= previous value %u and index %u\n", val, i, prevVal, i - 1);
-            }
-        }
+        // how often has the lazy particle reorder actually moved the particles?
+        unsigned int particleReorderCounters[PARTICLE_REORDER_NUM_COUNTERS] = { 0 };
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _particleReorderSsbo.BufferId());
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, _particleReorderSsbo.CountersByteOffset(), sizeof(particleReorderCounters), particleReorderCounters);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        unsigned int numParticleReorders = particleReorderCounters[2];
+        unsigned int numParticleReorderChecks = particleReorderCounters[3];
 
-        end = high_resolution_clock::now();
-        durationSortVerification = duration_cast<microseconds>(end - start).count();
+        long long totalSortingTime = durationPrepareToSort + durationCompactSortingData + durationSortSortingData + durationParticleSort;
 
         // report results
         // Note: Write the results to a tab-delimited text file so that I can dump them into an 
-        // Excel spreadsheet.
-        std::ofstream outFile("ParallelSortDurations.txt");
+        // Excel spreadsheet.  The sorter writes its own breakdown to ParallelSortDurations.txt.
+        std::ofstream outFile("ParticleSortDurations.txt");
         if (outFile.is_open())
         {
-            long long totalSortingTime = durationPrepareToSort + durationParticleSort;
-            for (unsigned int bitCounter = 0; bitCounter < totalBitCount; bitCounter++)
+            cout << "active particles: " << numActiveParticles << " of " << _numParticles << endl;
+            outFile << "active particles: " << numActiveParticles << " of " << _numParticles << endl;
+
+            if (_useLazyParticleReorder)
             {
-                totalSortingTime += durationsPrepareForPrefixScan[bitCounter];
-                totalSortingTime += durationsPrefixScan[bitCounter];
-                totalSortingTime += durationsSortSortingData[bitCounter];
+                // Note: The counts are since startup, not just this sort.
+                cout << "particle reorders: " << numParticleReorders << " of " << numParticleReorderChecks << " checks" << endl;
+                outFile << "particle reorders: " << numParticleReorders << " of " << numParticleReorderChecks << " checks" << endl;
             }
 
-            cout << "total sorting time: " << totalSortingTime << "\tmicroseconds" << endl;
-            outFile << "total sorting time: " << totalSortingTime << "\tmicroseconds" << endl;
-
-            cout << "sort verification: " << durationSortVerification << "\tmicroseconds" << endl;
-            outFile << "sort verification: " << durationSortVerification << "\tmicroseconds" << endl;
+            cout << "total particle sorting time: " << totalSortingTime << "\tmicroseconds" << endl;
+            outFile << "total particle sorting time: " << totalSortingTime << "\tmicroseconds" << endl;
 
             cout << "preparation: " << durationPrepareToSort << "\tmicroseconds" << endl;
             outFile << "preparation: " << durationPrepareToSort << "\tmicroseconds" << endl;
 
-            cout << "move particles to sorted positions: " << durationParticleSort << "\tmicroseconds" << endl;
-            outFile << "move particles to sorted positions: " << durationParticleSort << "\tmicroseconds" << endl;
-
-            cout << endl << "prepare for prefix scan:" << endl;
-            outFile << endl << "prepare for prefix scan:" << endl;
-            for (size_t i = 0; i < durationsPrepareForPrefixScan.size(); i++)
-            {
-                cout << "\t" << durationsPrepareForPrefixScan[i] << "\tmicroseconds" << endl;
-                outFile << "\t" << durationsPrepareForPrefixScan[i] << "\tmicroseconds" << endl;
-            }
+            cout << "compact sorting data: " << durationCompactSortingData << "\tmicroseconds" << endl;
+            outFile << "compact sorting data: " << durationCompactSortingData << "\tmicroseconds" << endl;
 
-            cout << endl << "prefix scan:" << endl;
-            outFile << endl << "prefix scan:" << endl;
-            for (size_t i = 0; i < durationsPrefixScan.size(); i++)
-            {
-                cout << "\t" << durationsPrefixScan[i] << "\tmicroseconds" << endl;
-                outFile << "\t" << durationsPrefixScan[i] << "\tmicroseconds" << endl;
-            }
+            cout << "sort sorting data: " << durationSortSortingData << "\tmicroseconds" << endl;
+            outFile << "sort sorting data: " << durationSortSortingData << "\tmicroseconds" << endl;
 
-            cout << endl << "sort sorting data:" << endl;
-            outFile << endl << "sort sorting data:" << endl;
-            for (size_t i = 0; i < durationsSortSortingData.size(); i++)
-            {
-                cout << "\t" << durationsSortSortingData[i] << "\tmicroseconds" << endl;
-                outFile << "\t" << durationsSortSortingData[i] << "\tmicroseconds" << endl;
-            }
+            cout << "move particles to sorted positions: " << durationParticleSort << "\tmicroseconds" << endl;
+            outFile << "move particles to sorted positions: " << durationParticleSort << "\tmicroseconds" << endl;
         }
         outFile.close();
 
@@ -942,17 +1889,51 @@ namespace ShaderControllers
     /*--------------------------------------------------------------------------------------------
     Description:
         This method governs the shader dispatches that will result in a balanced binary tree of 
-        bounding boxes from the leaves (particles) up to the root of the tree.
-    Parameters: 
-        numWorkGroupsX  Expected to be the total particle count divided by work group size.
+        bounding boxes from the leaves (particles) up to the root of the tree.  Which 
+        dispatches those are depends on the builder (see SetBvhBuilder(...)), and then the 
+        tree may be rearranged into a better one (see SetBvhTreeletRestructuring(...)).
+
+        Note: Expects the ActiveParticlesSsbo to be bound to GL_DISPATCH_INDIRECT_BUFFER.
+    Parameters: None
     Returns:    None
     Creator:    John Cox, 6/2017
     --------------------------------------------------------------------------------------------*/
-    void ParticleCollisions::GenerateBvhWithoutProfiling(unsigned int numWorkGroupsX) const
+    void ParticleCollisions::GenerateBvhWithoutProfiling() const
     {
-        PrepareForBinaryTree(numWorkGroupsX);
-        GenerateBinaryRadixTree(numWorkGroupsX);
-        MergeNodesIntoBvh(numWorkGroupsX);
+        if (_bvhBuilder == BvhBuilder::AGGLOMERATIVE)
+        {
+            BuildBvhAgglomerative();
+        }
+        else if (_bvhBuilder == BvhBuilder::PLOC)
+        {
+            PrepareForBinaryTree();
+            BuildBvhPloc();
+        }
+        else if (_bvhBuilder == BvhBuilder::BINNED_SAH_CPU)
+        {
+            BuildBvhBinnedSah();
+        }
+        else
+        {
+            PrepareForBinaryTree();
+            GenerateBinaryRadixTree();
+            MergeNodesIntoBvh();
+        }
+
+        if (_useBvhTreeletRestructuring)
+        {
+            RestructureBvhTreelets();
+        }
+
+        if (_useWideBvhTraversal)
+        {
+            CollapseBvhToWideNodes();
+        }
+
+        if (_useQuantizedBvhTraversal)
+        {
+            QuantizeBvhNodes();
+        }
     }
 
     /*--------------------------------------------------------------------------------------------
@@ -961,16 +1942,21 @@ namespace ShaderControllers
         (1) std::chrono calls 
         (2) forced wait for shader to finish so that the std::chrono calls get an accurate 
             reading for how long the shader takes 
-        (3) verification of a valid tree (all nodes' parent-child relationships are reciprocated)
+        (3) verification of a valid tree (see CountInvalidBvhNodes(...))
         (4) writing the output to a file (if desired)
-    Parameters: 
-        numWorkGroupsX  Expected to be the total particle count divided by work group size.
+
+        Note: Expects the ActiveParticlesSsbo to be bound to GL_DISPATCH_INDIRECT_BUFFER.
+
+        Also Note: DetectAndResolve(...) doesn't call this right now.  Its waits would throw 
+        off the timing of everything after it (see ReportBvhRefit() in main.cpp).  The check 
+        that every builder's tree goes through is the one in MeasureTreeQuality(...).
+    Parameters: None
     Returns:    None
     Creator:    John Cox, 6/2017
     --------------------------------------------------------------------------------------------*/
-    void ParticleCollisions::GenerateBvhWithProfiling(unsigned int numWorkGroupsX) const
+    void ParticleCollisions::GenerateBvhWithProfiling() const
     {
-        cout << "generating BVH for " << _numParticles << " particles" << endl;
+        cout << "generating BVH for up to " << _numParticles << " particles" << endl;
 
         // for profiling
         using namespace std::chrono;
@@ -979,77 +1965,115 @@ namespace ShaderControllers
         long long durationPrepData = 0;
         long long durationGenerateTree = 0;
         long long durationMergeBoundingBoxes = 0;
+        long long durationRestructureTreelets = 0;
+        long long durationCollapseToWideNodes = 0;
+        long long durationQuantizeNodes = 0;
         long long durationCheckForValidTree = 0;
 
-        // prep data
-        start = high_resolution_clock::now();
-        PrepareForBinaryTree(numWorkGroupsX);
-        WaitForComputeToFinish();
-        end = high_resolution_clock::now();
-        durationPrepData = duration_cast<microseconds>(end - start).count();
+        if (_bvhBuilder == BvhBuilder::AGGLOMERATIVE)
+        {
+            // the tree and its bounding volumes come out of the same dispatch, so it all counts 
+            // as generating the tree
+            start = high_resolution_clock::now();
+            BuildBvhAgglomerative();
+            WaitForComputeToFinish();
+            end = high_resolution_clock::now();
+            durationGenerateTree = duration_cast<microseconds>(end - start).count();
+        }
+        else if (_bvhBuilder == BvhBuilder::PLOC)
+        {
+            // the leaves' boxes
+            start = high_resolution_clock::now();
+            PrepareForBinaryTree();
+            WaitForComputeToFinish();
+            end = high_resolution_clock::now();
+            durationPrepData = duration_cast<microseconds>(end - start).count();
 
-        // generate the tree
-        start = high_resolution_clock::now();
-        GenerateBinaryRadixTree(numWorkGroupsX);
-        WaitForComputeToFinish();
-        end = high_resolution_clock::now();
-        durationGenerateTree = duration_cast<microseconds>(end - start).count();
+            // the tree and the rest of its bounding volumes come out of the same rounds, so it 
+            // all counts as generating the tree
+            start = high_resolution_clock::now();
+            BuildBvhPloc();
+            WaitForComputeToFinish();
+            end = high_resolution_clock::now();
+            durationGenerateTree = duration_cast<microseconds>(end - start).count();
+        }
+        else if (_bvhBuilder == BvhBuilder::BINNED_SAH_CPU)
+        {
+            // the read back, the build, and the upload are all part of it
+            start = high_resolution_clock::now();
+            BuildBvhBinnedSah();
+            WaitForComputeToFinish();
+            end = high_resolution_clock::now();
+            durationGenerateTree = duration_cast<microseconds>(end - start).count();
+        }
+        else
+        {
+            // prep data
+            start = high_resolution_clock::now();
+            PrepareForBinaryTree();
+            WaitForComputeToFinish();
+            end = high_resolution_clock::now();
+            durationPrepData = duration_cast<microseconds>(end - start).count();
 
-        // populate the tree with bounding volumes to finish the BVH
-        start = high_resolution_clock::now();
-        MergeNodesIntoBvh(numWorkGroupsX);
-        WaitForComputeToFinish();
-        end = high_resolution_clock::now();
-        durationMergeBoundingBoxes = duration_cast<microseconds>(end - start).count();
+            // generate the tree
+            start = high_resolution_clock::now();
+            GenerateBinaryRadixTree();
+            WaitForComputeToFinish();
+            end = high_resolution_clock::now();
+            durationGenerateTree = duration_cast<microseconds>(end - start).count();
 
-        // verify that the binary tree is valid by checking that all parent-child relationships 
-        // are reciprocated 
-        // Note: By virtue of being a binary tree, every node except the root has a parent, and 
-        // that parent also specifies that node as a child exactly once.
-        start = high_resolution_clock::now();
-        unsigned int startingIndex = 0;
-        std::vector<BvhNode> checkBinaryTree(_bvhNodeSsbo.NumTotalNodes());
-        unsigned int bufferSizeBytes = checkBinaryTree.size() * sizeof(BvhNode);
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bvhNodeSsbo.BufferId());
-        void *bufferPtr = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, startingIndex, bufferSizeBytes, GL_MAP_READ_BIT);
-        memcpy(checkBinaryTree.data(), bufferPtr, bufferSizeBytes);
-        glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
-        
-        // check the root node (no parent, only children)
-        int rootnodeindex = _bvhNodeSsbo.NumLeafNodes();
-        const BvhNode &rootnode = checkBinaryTree[rootnodeindex];
-        if ((rootnodeindex != checkBinaryTree[rootnode._leftChildIndex]._parentIndex) &&
-            (rootnodeindex != checkBinaryTree[rootnode._rightChildIndex]._parentIndex))
+            // populate the tree with bounding volumes to finish the BVH
+            start = high_resolution_clock::now();
+            MergeNodesIntoBvh();
+            WaitForComputeToFinish();
+            end = high_resolution_clock::now();
+            durationMergeBoundingBoxes = duration_cast<microseconds>(end - start).count();
+        }
+
+        // rearrange it into a better tree
+        if (_useBvhTreeletRestructuring)
         {
-            // root-child relationship not reciprocated
-            printf("");
+            start = high_resolution_clock::now();
+            RestructureBvhTreelets();
+            WaitForComputeToFinish();
+            end = high_resolution_clock::now();
+            durationRestructureTreelets = duration_cast<microseconds>(end - start).count();
+        }
+
+        // and the 4-wide one to go through
+        if (_useWideBvhTraversal)
+        {
+            start = high_resolution_clock::now();
+            CollapseBvhToWideNodes();
+            WaitForComputeToFinish();
+            end = high_resolution_clock::now();
+            durationCollapseToWideNodes = duration_cast<microseconds>(end - start).count();
         }
 
-        // check all the other nodes (have parents, leaves don't have children)
-        for (size_t thisNodeIndex = 0; thisNodeIndex < checkBinaryTree.size(); thisNodeIndex++)
+        // and the quantized copies to go through
+        if (_useQuantizedBvhTraversal)
         {
-            const BvhNode &thisNode = checkBinaryTree[thisNodeIndex];
-
-            if (thisNode._parentIndex == -1)
-            {
-                // skip if it is the root; everyone else should have a parent
-                if (thisNodeIndex != _bvhNodeSsbo.NumLeafNodes())
-                {
-                    // bad: non-root node has a -1 parent
-                    printf("");
-                }
-            }
-            else
-            {
-                if ((thisNodeIndex != checkBinaryTree[thisNode._parentIndex]._leftChildIndex) &&
-                    (thisNodeIndex != checkBinaryTree[thisNode._parentIndex]._rightChildIndex))
-                {
-                    // parent-child relationship not reciprocated
-                    printf("");
-                }
-            }
+            start = high_resolution_clock::now();
+            QuantizeBvhNodes();
+            WaitForComputeToFinish();
+            end = high_resolution_clock::now();
+            durationQuantizeNodes = duration_cast<microseconds>(end - start).count();
         }
 
+        // verify that the binary tree is valid (see CountInvalidBvhNodes(...))
+        start = high_resolution_clock::now();
+        unsigned int numActiveParticles = 0;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _activeParticlesSsbo.BufferId());
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, _activeParticlesSsbo.NumActiveParticlesByteOffset(), sizeof(unsigned int), &numActiveParticles);
+
+        std::vector<BvhNode> checkBinaryTree;
+        std::vector<BvhNodeBuildData> checkBuildData;
+        ReadBackBvh(checkBinaryTree, checkBuildData);
+
+        unsigned int numInvalidNodes = CountInvalidBvhNodes(checkBinaryTree, checkBuildData, 
+            static_cast<int>(_bvhNodeSsbo.NumLeafNodes()), numActiveParticles, _maxParticlesPerBvhLeaf);
+        cout << "invalid BVH nodes: " << numInvalidNodes << endl;
+
         end = high_resolution_clock::now();
         durationCheckForValidTree = duration_cast<microseconds>(end - start).count();
 
@@ -1059,7 +2083,7 @@ namespace ShaderControllers
         std::ofstream outFile("GenerateBvhDurations.txt");
         if (outFile.is_open())
         {
-            long long totalSortingTime = durationPrepData + durationGenerateTree + durationMergeBoundingBoxes;
+            long long totalSortingTime = durationPrepData + durationGenerateTree + durationMergeBoundingBoxes + durationRestructureTreelets + durationCollapseToWideNodes + durationQuantizeNodes;
 
             cout << "total BVH generation time: " << totalSortingTime << "\tmicroseconds" << endl;
             outFile << "total BVH generation time: " << totalSortingTime << "\tmicroseconds" << endl;
@@ -1073,26 +2097,99 @@ namespace ShaderControllers
             cout << "merge bounding boxes: " << durationMergeBoundingBoxes << "\tmicroseconds" << endl;
             outFile << "merge bounding boxes: " << durationMergeBoundingBoxes << "\tmicroseconds" << endl;
 
+            cout << "restructure treelets: " << durationRestructureTreelets << "\tmicroseconds" << endl;
+            outFile << "restructure treelets: " << durationRestructureTreelets << "\tmicroseconds" << endl;
+
+            cout << "collapse to wide nodes: " << durationCollapseToWideNodes << "\tmicroseconds" << endl;
+            outFile << "collapse to wide nodes: " << durationCollapseToWideNodes << "\tmicroseconds" << endl;
+
+            cout << "quantize nodes: " << durationQuantizeNodes << "\tmicroseconds" << endl;
+            outFile << "quantize nodes: " << durationQuantizeNodes << "\tmicroseconds" << endl;
+
             cout << "check for valid tree: " << durationCheckForValidTree << "\tmicroseconds" << endl;
             outFile << "check for valid tree: " << durationCheckForValidTree << "\tmicroseconds" << endl;
         }
         outFile.close();
     }
 
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Picks up what PlanBvhRefit.comp decided last frame (see BvhRefitLayout.comp).
+
+        Note: This is not a glGetBufferSubData(...).  The decision was copied into a 
+        persistently mapped buffer at the end of last frame's BVH work, and the per-frame sync 
+        has already waited for that (see BvhRefitSsbo::RebuildRequested()), so this doesn't 
+        stall the work that has been queued for this frame.
+    Parameters: None
+    Returns:    
+        True if the particles should be re-sorted and the tree rebuilt this frame, false if the 
+        tree from last frame should be refit.
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    bool ParticleCollisions::BvhRebuildRequested() const
+    {
+        return _bvhRefitSsbo.RebuildRequested();
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        For profiling.  Reports whether this frame rebuilt or refit the tree, how long that 
+        took, how often the tree has been rebuilt, and how big the tree has gotten since the 
+        last rebuild (see BvhRefitLayout.comp).
+
+        Note: One frame only times one or the other.  The time that the refits save comes from 
+        running the same particles with the refit on and off (see CompareBvhRefit() in 
+        main.cpp).
+    Parameters: 
+        rebuilt         True if this frame sorted and rebuilt the tree.
+        durationBvh     How long that (or the refit) took, including measuring the tree.
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::ReportBvhRefit(bool rebuilt, long long durationBvh) const
+    {
+        // Note: Write the results to a tab-delimited text file so that I can dump them into an 
+        // Excel spreadsheet.
+        std::ofstream outFile("BvhRefitDurations.txt");
+        if (!outFile.is_open())
+        {
+            return;
+        }
+
+        const char *whatHappened = rebuilt ? "sort and rebuild BVH: " : "refit BVH: ";
+        cout << whatHappened << durationBvh << "\tmicroseconds" << endl;
+        outFile << whatHappened << durationBvh << "\tmicroseconds" << endl;
+
+        if (_useBvhRefit)
+        {
+            // Note: The counts are since startup, not just this frame.
+            BvhRefitState state = ReadBvhRefitState();
+            unsigned int numFrames = state._numBvhRebuilds + state._numBvhRefits;
+            cout << "BVH rebuilds: " << state._numBvhRebuilds << " of " << numFrames << " frames" << endl;
+            outFile << "BVH rebuilds: " << state._numBvhRebuilds << " of " << numFrames << " frames" << endl;
+
+            float areaGrowth = (state._bvhAreaAfterRebuild > 0.0f) ? 
+                (state._bvhArea / state._bvhAreaAfterRebuild) : 1.0f;
+            cout << "BVH area since last rebuild: " << areaGrowth << "x (rebuild at " << BVH_REFIT_MAX_AREA_GROWTH << "x)" << endl;
+            outFile << "BVH area since last rebuild: " << areaGrowth << "x (rebuild at " << BVH_REFIT_MAX_AREA_GROWTH << "x)" << endl;
+        }
+        outFile.close();
+    }
+
     /*--------------------------------------------------------------------------------------------
     Description:
         This method governs the shader dispatches that will result in colliding particles 
         receiving new velocity vectors.
-    Parameters: 
-        numWorkGroupsX  Expected to be the total particle count divided by work group size.
+
+        Note: Expects the ActiveParticlesSsbo to be bound to GL_DISPATCH_INDIRECT_BUFFER.
+    Parameters: None
     Returns:    None
     Creator:    John Cox, 6/2017
     --------------------------------------------------------------------------------------------*/
-    void ParticleCollisions::DetectAndResolveCollisionsWithoutProfiling(
-        unsigned int numWorkGroupsX) const
+    void ParticleCollisions::DetectAndResolveCollisionsWithoutProfiling() const
     {
-        DetectCollisions(numWorkGroupsX);
-        ResolveCollisions(numWorkGroupsX);
+        DetectCollisions();
+        ResolveCollisions();
     }
 
     /*--------------------------------------------------------------------------------------------
@@ -1105,13 +2202,13 @@ namespace ShaderControllers
 
         Note: There is no structure to verify as there was for particle sorting and BVH 
         generation.
-    Parameters: 
-        numWorkGroupsX  Expected to be the total particle count divided by work group size.
+
+        Also Note: Expects the ActiveParticlesSsbo to be bound to GL_DISPATCH_INDIRECT_BUFFER.
+    Parameters: None
     Returns:    None
     Creator:    John Cox, 6/2017
     --------------------------------------------------------------------------------------------*/
-    void ParticleCollisions::DetectAndResolveCollisionsWithProfiling(
-        unsigned int numWorkGroupsX) const
+    void ParticleCollisions::DetectAndResolveCollisionsWithProfiling() const
     {
         cout << "detecting collisions for up to " << _numParticles << " particles" << endl;
 
@@ -1123,13 +2220,13 @@ namespace ShaderControllers
         long long durationResolveCollisions = 0;
 
         start = high_resolution_clock::now();
-        DetectCollisions(numWorkGroupsX);
+        DetectCollisions();
         WaitForComputeToFinish();
         end = high_resolution_clock::now();
         durationDetectCollisions = duration_cast<microseconds>(end - start).count();
 
         start = high_resolution_clock::now();
-        ResolveCollisions(numWorkGroupsX);
+        ResolveCollisions();
         WaitForComputeToFinish();
         end = high_resolution_clock::now();
         durationResolveCollisions = duration_cast<microseconds>(end - start).count();
@@ -1142,11 +2239,10 @@ namespace ShaderControllers
         //memcpy(checkPotentialCollisions.data(), bufferPtr, bufferSizeBytes);
         //glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
 
-        unsigned int startingIndex = 0;
-        std::vector<Particle> checkPostCollisionParticles(_originalParticleSsbo->NumParticles());
+        std::vector<Particle> checkPostCollisionParticles(_particleSsbo->NumParticles());
         unsigned int bufferSizeBytes = checkPostCollisionParticles.size() * sizeof(Particle);
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _originalParticleSsbo->BufferId());
-        void *bufferPtr = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, startingIndex, bufferSizeBytes, GL_MAP_READ_BIT);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _particleSsbo->BufferId());
+        void *bufferPtr = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, _particleSsbo->FrontHalfByteOffset(), bufferSizeBytes, GL_MAP_READ_BIT);
         memcpy(checkPostCollisionParticles.data(), bufferPtr, bufferSizeBytes);
         glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
 
@@ -1180,7 +2276,46 @@ namespace ShaderControllers
 
     /*--------------------------------------------------------------------------------------------
     Description:
-        Part of particle sorting.
+        Binds every SSBO that this controller owns to its binding point.
+
+        Note: The SSBOs bind themselves when they are made, so the last ParticleCollisions to 
+        be made would otherwise own the binding points.  This is done at the start of every 
+        frame, whether the tree is rebuilt or refit, so more than one of them can take turns 
+        (see CompareSortingKeyTreeQuality() in main.cpp).
+
+        Also Note: The prefix scan buffers are the sorter's (see 
+        GpuKeyValueSorter::BindPrefixScanBuffers()).  They are bound here too because the 
+        active particle compaction scans before the first sort.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::BindBuffers() const
+    {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLE_SORTING_DATA_BUFFER_BINDING, _particleSortingDataSsbo.BufferId());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, ACTIVE_PARTICLES_BUFFER_BINDING, _activeParticlesSsbo.BufferId());
+        _sorter.BindPrefixScanBuffers();
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLE_REORDER_BUFFER_BINDING, _particleReorderSsbo.BufferId());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SCENE_BOUNDS_BUFFER_BINDING, _sceneBoundsSsbo.BufferId());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BVH_NODE_BUFFER_BINDING, _bvhNodeSsbo.BufferId());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BVH_NODE_BUILD_DATA_BUFFER_BINDING, _bvhNodeBuildDataSsbo.BufferId());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BVH_REFIT_BUFFER_BINDING, _bvhRefitSsbo.BufferId());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BVH_CLUSTER_BUFFER_BINDING, _bvhClusterSsbo.BufferId());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BVH_WIDE_NODE_BUFFER_BINDING, _bvhWideNodeSsbo.BufferId());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BVH_QUANTIZED_NODE_BUFFER_BINDING, _bvhQuantizedNodeSsbo.BufferId());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLE_POTENTIAL_COLLISIONS_BUFFER_BINDING, _particlePotentialCollisionsSsbo.BufferId());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLE_VELOCITY_VECTOR_GEOMETRY_BUFFER_BINDING, _velocityVectorGeometrySsbo.BufferId());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLE_BOUNDING_BOX_GEOMETRY_BUFFER_BINDING, _boundingBoxGeometrySsbo.BufferId());
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Part of particle sorting.  If the dynamic Morton Code bounds are on, this finds where 
+        the active particles are first (see SceneBoundsLayout.comp) so that the Morton Codes 
+        can be normalized against that.
+
+        Note: This is the first thing that happens when the tree is rebuilt, so this binds 
+        this controller's SSBOs (see BindBuffers()).
     Parameters: 
         numWorkGroupsX      Expected to be number of particles divided by work group size.
     Returns:    None
@@ -1188,188 +2323,530 @@ namespace ShaderControllers
     --------------------------------------------------------------------------------------------*/
     void ParticleCollisions::PrepareToSortParticles(unsigned int numWorkGroupsX) const
     {
-        glUseProgram(_programIdCopyParticlesToCopyBuffer);
-        glDispatchCompute(numWorkGroupsX, 1, 1);
+        BindBuffers();
+
+        if (_useDynamicMortonCodeBounds)
+        {
+            glUseProgram(_programIdComputeSceneBounds);
+            glDispatchCompute(numWorkGroupsX, 1, 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+            glUseProgram(_programIdFinalizeSceneBounds);
+            glDispatchCompute(1, 1, 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+
         glUseProgram(_programIdGenerateSortingData);
         glDispatchCompute(numWorkGroupsX, 1, 1);
-
-        // the two shaders worked on independent data, so only need one memory barrier at the end
         glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
     }
 
     /*--------------------------------------------------------------------------------------------
     Description:
-        Part of particle sorting.  Number of work groups calculated internally.
+        Part of particle sorting.  Moves the active particles' sorting data to the front of the 
+        ParticleSortingDataBuffer and writes how many there are (see 
+        CompactSortingData.comp).  The prefix scan is the sorter's (see 
+        GpuKeyValueSorter::PrefixScanOverAllItems()); it just scans the active flags that 
+        GenerateSortingData.comp wrote into the sorter's prefix scan buffer.  The sort scans in 
+        the same buffer afterwards, but by then the compaction is done with it.
+
+        Everything after this is sized by the number of active particles.  The count and the 
+        dispatch commands that go with it stay on the GPU.
+
+        Note: The prefix scan covers the whole capacity because the CPU doesn't know how many 
+        particles are active.  Inactive particles' flags are 0, so they cost a read and nothing 
+        else.
+    Parameters: 
+        numWorkGroupsX  Expected to be number of particles divided by work group size.
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::CompactSortingData(unsigned int numWorkGroupsX) const
+    {
+        _sorter.PrefixScanOverAllItems();
 
-        Note: The number of work groups for this sorting stage need special handling.  Most 
-        shaders operate on 1 item per thread and will require 
-        ("num particles" / "work group size X") + 1 work groups to give every data entry 
-        (particle, particle sorting, BVH nodes, etc.) a thread.  The prefix sum algorithm 
-        operates on 2 items per thread and needs special handling (read description block of 
-        PrefixSumSsbo for details).  
-        
-        This stage is neither.  Clearing out the work group sums operates on 2 items per thread 
-        and requires 1, and exactly 1, work groups.  Getting bits for the prefix sum operates on 
-        1 item per thread and is a function of the size of the prefix scan array.  Deal with 
-        these special cases manually.
-    Parameters:
-        bitNumber               0 - 31
+        glUseProgram(_programIdCompactSortingData);
+        glDispatchCompute(numWorkGroupsX, 1, 1);
+
+        // the dispatch commands will be read by glDispatchComputeIndirect(...)
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Part of particle sorting.  SortParticles.comp gathers the particles into the back half of 
+        the ParticleSsbo, and then the halves swap so that everything after this sees the sorted 
+        particles.
+
+        If the lazy particle reorder is on (see ParticleReorderLayout.comp), the GPU first 
+        decides whether the particles need to move at all, and the gather is dispatched 
+        indirectly with 0 work groups if they don't.  The CPU doesn't know which it was, so it 
+        can't swap the halves.  The particles are copied back to the front half instead, and 
+        that copy is dispatched with the same command.  That makes a frame that moves them two 
+        passes over the particles instead of one, which is why the lazy reorder is off by 
+        default (see SetLazyParticleReorder(...)).
+
+        Note: Either way, SortParticles.comp points the sorting data at the particles' new 
+        indices, so the BVH and collision shaders find the right particles (see 
+        LeafToParticleIndex.comp).
+    Parameters: 
+        numWorkGroupsX          Expected to be number of particles divided by work group size.
         sortingDataReadOffset   Tells the shader which half of the ParticleSortingDataBuffer has 
                                 the latest sort values.
     Returns:    None
     Creator:    John Cox, 6/2017
     --------------------------------------------------------------------------------------------*/
-    void ParticleCollisions::PrepareForPrefixScan(unsigned int bitNumber, 
+    void ParticleCollisions::SortParticlesWithSortedData(unsigned int numWorkGroupsX, 
         unsigned int sortingDataReadOffset) const
     {
-        // Note: The "work group sums" array is the size of a single work group * 2.  This shader
-        // should only be dispatched with a single work group.
-        glUseProgram(_programIdClearWorkGroupSums);
+        if (!_useLazyParticleReorder)
+        {
+            glUseProgram(_programIdSortParticles);
+            glUniform1ui(UNIFORM_LOCATION_PARTICLE_SORTING_DATA_BUFFER_READ_OFFSET, sortingDataReadOffset);
+            glDispatchCompute(numWorkGroupsX, 1, 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+            _particleSsbo->SwapHalves();
+            return;
+        }
+
+        // only the active particles are leaves, so only they are measured
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, _activeParticlesSsbo.BufferId());
+        glUseProgram(_programIdMeasureParticleLocality);
+        glDispatchComputeIndirect(_activeParticlesSsbo.DispatchCommandByteOffset(ACTIVE_PARTICLES_DISPATCH_PARTICLES));
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        glUseProgram(_programIdPlanParticleReorder);
         glDispatchCompute(1, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
 
-        int numWorkGroupsX = _prefixSumSsbo.NumDataEntries() / WORK_GROUP_SIZE_X;
-        int remainder = _prefixSumSsbo.NumDataEntries() % WORK_GROUP_SIZE_X;
-        numWorkGroupsX += (remainder == 0) ? 0 : 1;
-        glUseProgram(_programIdGetBitForPrefixScan);
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, _particleReorderSsbo.BufferId());
+        glUseProgram(_programIdSortParticles);
         glUniform1ui(UNIFORM_LOCATION_PARTICLE_SORTING_DATA_BUFFER_READ_OFFSET, sortingDataReadOffset);
-        glUniform1ui(UNIFORM_LOCATION_BIT_NUMBER, bitNumber);
-        glDispatchCompute(numWorkGroupsX, 1, 1);
+        glDispatchComputeIndirect(_particleReorderSsbo.DispatchCommandByteOffset());
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
 
-        // the two shaders worked on independent data, so only need one memory barrier at the end
+        glUseProgram(_programIdCopyParticlesFromBackBuffer);
+        glDispatchComputeIndirect(_particleReorderSsbo.DispatchCommandByteOffset());
         glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
     }
 
     /*--------------------------------------------------------------------------------------------
     Description:
-        Part of particle sorting.
-    Parameters: 
-        numWorkGroupsX          Expected to be the size of the prefix scan buffer divided by 
-                                work group size.
-        sortingDataReadOffset   Tells the shader which half of the ParticleSortingDataBuffer has 
-                                the latest sort values.
+        Gives each leaf node in the BvhNodeBuffer a bounding box based on the particle that it 
+        is associated with.
+
+        Note: This used to make every item in the ParticleSortingDataBuffer unique first so 
+        that the tree wouldn't have depth spikes due to duplicate entries.  The tree takes care 
+        of that itself now (see GenerateBinaryRadixTree.comp).
+
+        Also Note: Expects the ActiveParticlesSsbo to be bound to GL_DISPATCH_INDIRECT_BUFFER.
+    Parameters: None
     Returns:    None
     Creator:    John Cox, 6/2017
     --------------------------------------------------------------------------------------------*/
-    void ParticleCollisions::PrefixScanOverParticleSortingData(unsigned int numWorkGroupsX) const
+    void ParticleCollisions::PrepareForBinaryTree() const
     {
-        glUseProgram(_programIdPrefixScanOverAllData);
-        glDispatchCompute(numWorkGroupsX, 1, 1);
+        glUseProgram(_programIdGenerateLeafNodeBoundingBoxes);
+        glDispatchComputeIndirect(_activeParticlesSsbo.DispatchCommandByteOffset(ACTIVE_PARTICLES_DISPATCH_BVH_LEAVES));
         glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
 
-        // this stage is designed to work with 1 work group, and exactly 1 work group
-        // Note: See PrefixScanBuffer.comp description for details on this second stage.
-        glUseProgram(_programIdPrefixScanOverWorkGroupSums);
-        glDispatchCompute(1, 1, 1);
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        All that sorting to get to here.
+        Note: Expects the ActiveParticlesSsbo to be bound to GL_DISPATCH_INDIRECT_BUFFER.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 6/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::GenerateBinaryRadixTree() const
+    {
+        glUseProgram(_programIdGenerateBinaryRadixTree);
+        glDispatchComputeIndirect(_activeParticlesSsbo.DispatchCommandByteOffset(ACTIVE_PARTICLES_DISPATCH_BVH_LEAVES));
         glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
     }
 
     /*--------------------------------------------------------------------------------------------
     Description:
-        Part of particle sorting.
-    Parameters: 
-        numWorkGroupsX          Expected to be number of particles divided by work group size.
-        bitNumber               0 - 32
-        sortingDataReadOffset   The sortng data is read from this half of the buffer...
-        sortingDataWriteOffset  And sorted according to the prefix sums into this half.
+        And finally the binary radix tree blooms with beautiful bounding boxes into a Bounding 
+        Volume Hierarchy.  I'm tired and am thinking of nice "tree in spring" analogy.  The 
+        analogy starts to fall apart when I think of creating the tree anew ~60x/sec.  
+        Note: Expects the ActiveParticlesSsbo to be bound to GL_DISPATCH_INDIRECT_BUFFER.
+    Parameters: None
     Returns:    None
     Creator:    John Cox, 6/2017
     --------------------------------------------------------------------------------------------*/
-    void ParticleCollisions::SortSortingDataWithPrefixScan(
-        unsigned int numWorkGroupsX, unsigned int bitNumber, 
-        unsigned int sortingDataReadOffset, unsigned int sortingDataWriteOffset) const
+    void ParticleCollisions::MergeNodesIntoBvh() const
     {
-        glUseProgram(_programIdSortSortingDataWithPrefixSums);
-        glUniform1ui(UNIFORM_LOCATION_PARTICLE_SORTING_DATA_BUFFER_READ_OFFSET, sortingDataReadOffset);
-        glUniform1ui(UNIFORM_LOCATION_PARTICLE_SORTING_DATA_BUFFER_WRITE_OFFSET, sortingDataWriteOffset);
-        glUniform1ui(UNIFORM_LOCATION_BIT_NUMBER, bitNumber);
-        glDispatchCompute(numWorkGroupsX, 1, 1);
+        glUseProgram(_programIdMergeBoundingVolumes);
+        glDispatchComputeIndirect(_activeParticlesSsbo.DispatchCommandByteOffset(ACTIVE_PARTICLES_DISPATCH_BVH_LEAVES));
         glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
     }
 
     /*--------------------------------------------------------------------------------------------
     Description:
-        Part of particle sorting.
-    Parameters: 
-        numWorkGroupsX          Expected to be number of particles divided by work group size.
-        sortingDataReadOffset   Tells the shader which half of the ParticleSortingDataBuffer has 
-                                the latest sort values.
+        Builds the whole BVH with a single dispatch of BuildBvhAgglomerative.comp: the leaves' 
+        bounding boxes, the tree, and the merged bounding boxes.  Takes the place of 
+        PrepareForBinaryTree(), GenerateBinaryRadixTree(), and MergeNodesIntoBvh().
+        Note: Expects the ActiveParticlesSsbo to be bound to GL_DISPATCH_INDIRECT_BUFFER.
+    Parameters: None
     Returns:    None
-    Creator:    John Cox, 6/2017
+    Creator:    John Cox, 7/2017
     --------------------------------------------------------------------------------------------*/
-    void ParticleCollisions::SortParticlesWithSortedData(unsigned int numWorkGroupsX, 
-        unsigned int sortingDataReadOffset) const
+    void ParticleCollisions::BuildBvhAgglomerative() const
     {
-        glUseProgram(_programIdSortParticles);
-        glUniform1ui(UNIFORM_LOCATION_PARTICLE_SORTING_DATA_BUFFER_READ_OFFSET, sortingDataReadOffset);
-        glDispatchCompute(numWorkGroupsX, 1, 1);
+        glUseProgram(_programIdBuildBvhAgglomerative);
+        glDispatchComputeIndirect(_activeParticlesSsbo.DispatchCommandByteOffset(ACTIVE_PARTICLES_DISPATCH_BVH_LEAVES));
         glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
     }
 
     /*--------------------------------------------------------------------------------------------
     Description:
-        Modifies the ParticleSortingDataBuffer so that the resulting tree won't have depth 
-        spikes due to duplicate entries, then gives each leaf node in the BvhNodeBuffer a 
-        bounding box based on the particle that it is associated with.
+        Builds the BVH out of the leaves' boxes by merging clusters (see 
+        BvhClusterLayout.comp).  Takes the place of GenerateBinaryRadixTree() and 
+        MergeNodesIntoBvh().  Each round is:
+        (1) find each cluster's nearest neighbor
+        (2) merge the ones that found each other
+        (3) prefix scan over which ones are left (the sorter's, the same as for the sorting data)
+        (4) compact them
+        (5) count them and write next round's dispatch commands
+
+        Every round is dispatched indirectly from the BvhClusterSsbo, so rounds after the last 
+        merge have no work groups.  Only the GPU knows when that is, so the number of 
+        clusters is read back every BVH_CLUSTER_ROUNDS_PER_CHECK rounds.  That is a pipeline 
+        stall each time, but there are only a handful of them per build.
+
+        Note: Expects the leaves' boxes to be done (see PrepareForBinaryTree()).
+
+        Also Note: Expects the ActiveParticlesSsbo to be bound to GL_DISPATCH_INDIRECT_BUFFER.  
+        The BvhClusterSsbo is bound in its place while the rounds are running, and it is put 
+        back afterwards.
+
+        Also Note: The cluster counts are scanned with the sorter's prefix scan (see 
+        GpuKeyValueSorter::PrefixScanIndirect(...)).  The sort is done by now, so its scratch 
+        space is free, and its buffers are still on the prefix scan binding points.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::BuildBvhPloc() const
+    {
+        _bvhClusterSsbo.ClearClusters();
+        glUseProgram(_programIdInitBvhClusters);
+        glDispatchComputeIndirect(_activeParticlesSsbo.DispatchCommandByteOffset(ACTIVE_PARTICLES_DISPATCH_BVH_LEAVES));
+
+        // the dispatch commands will be read by glDispatchComputeIndirect(...)
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, _bvhClusterSsbo.BufferId());
+        unsigned int readSet = 0;
+        unsigned int numClusters = 0;
+        do
+        {
+            for (unsigned int roundCount = 0; roundCount < BVH_CLUSTER_ROUNDS_PER_CHECK; roundCount++)
+            {
+                glUseProgram(_programIdFindBvhClusterNearestNeighbors);
+                glUniform1ui(UNIFORM_LOCATION_BVH_CLUSTER_READ_SET, readSet);
+                glDispatchComputeIndirect(_bvhClusterSsbo.DispatchCommandByteOffset(BVH_CLUSTER_DISPATCH_CLUSTERS));
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+                glUseProgram(_programIdMergeBvhClusters);
+                glUniform1ui(UNIFORM_LOCATION_BVH_CLUSTER_READ_SET, readSet);
+                glDispatchComputeIndirect(_bvhClusterSsbo.DispatchCommandByteOffset(BVH_CLUSTER_DISPATCH_PREFIX_SCAN_ITEMS));
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+                _sorter.PrefixScanIndirect(_bvhClusterSsbo.DispatchCommandByteOffset(BVH_CLUSTER_DISPATCH_PREFIX_SCAN));
+
+                glUseProgram(_programIdCompactBvhClusters);
+                glUniform1ui(UNIFORM_LOCATION_BVH_CLUSTER_READ_SET, readSet);
+                glDispatchComputeIndirect(_bvhClusterSsbo.DispatchCommandByteOffset(BVH_CLUSTER_DISPATCH_CLUSTERS));
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+                glUseProgram(_programIdCountBvhClusters);
+                glDispatchCompute(1, 1, 1);
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+                readSet = 1 - readSet;
+            }
+
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bvhClusterSsbo.BufferId());
+            glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, _bvhClusterSsbo.NumClustersByteOffset(), sizeof(unsigned int), &numClusters);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        } while (numClusters > 1);
+
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, _activeParticlesSsbo.BufferId());
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Reads back what the CPU builders need (see CpuBvhBuilders.h): the number of active 
+        particles, the sorting data for them, the particles, and the particle properties.  
+        Only one of the sorting data arrays is filled, depending on the key width (see 
+        MortonCodeKeyWidth(...)), and the other is left empty.
+
+        Note: The sort leaves the sorted data at the start of its buffer, and the particles 
+        that it points at are in the front half of theirs.
+
+        Also Note: Every read back waits for the GPU to finish with the buffer.  This is a 
+        pipeline stall, so it is only for the CPU builders and for checking them against the 
+        GPU's tree (see ProfileCpuBvhBuilderScaling() in main.cpp).
     Parameters: 
-        numWorkGroupsX      Expected to be number of particles divided by work group size.
+        numActiveParticles  Receives the number.
+        sortedData          Receives the sorting data if the keys are 32 bits.
+        sortedData64        Receives the sorting data if the keys are 64 bits.
+        particles           Receives all of them.
+        particleProperties  Receives all of them.
     Returns:    None
-    Creator:    John Cox, 6/2017
+    Creator:    John Cox, 7/2017
     --------------------------------------------------------------------------------------------*/
-    void ParticleCollisions::PrepareForBinaryTree(unsigned int numWorkGroupsX) const
+    void ParticleCollisions::ReadBackCpuBvhBuildInput(unsigned int &numActiveParticles, 
+        std::vector<ParticleSortingData> &sortedData, 
+        std::vector<ParticleSortingData64> &sortedData64, std::vector<Particle> &particles, 
+        std::vector<ParticleProperties> &particleProperties) const
     {
-        glUseProgram(_programIdGuaranteeSortingDataUniqueness);
-        glDispatchCompute(numWorkGroupsX, 1, 1);
-        glUseProgram(_programIdGenerateLeafNodeBoundingBoxes);
-        glDispatchCompute(numWorkGroupsX, 1, 1);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _activeParticlesSsbo.BufferId());
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, _activeParticlesSsbo.NumActiveParticlesByteOffset(), sizeof(unsigned int), &numActiveParticles);
+
+        sortedData.clear();
+        sortedData64.clear();
+        unsigned int bufferSizeBytes = 0;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _particleSortingDataSsbo.BufferId());
+        if (MortonCodeKeyWidth(_mortonCodeEncoding) == SortingKeyWidth::KEY_64_BIT)
+        {
+            sortedData64.resize(numActiveParticles);
+            bufferSizeBytes = sortedData64.size() * sizeof(ParticleSortingData64);
+            glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, bufferSizeBytes, sortedData64.data());
+        }
+        else
+        {
+            sortedData.resize(numActiveParticles);
+            bufferSizeBytes = sortedData.size() * sizeof(ParticleSortingData);
+            glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, bufferSizeBytes, sortedData.data());
+        }
+
+        particles.resize(_particleSsbo->NumParticles());
+        bufferSizeBytes = particles.size() * sizeof(Particle);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _particleSsbo->BufferId());
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, _particleSsbo->FrontHalfByteOffset(), bufferSizeBytes, particles.data());
+
+        particleProperties.resize(_particlePropertiesSsbo->NumProperties());
+        bufferSizeBytes = particleProperties.size() * sizeof(ParticleProperties);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _particlePropertiesSsbo->BufferId());
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, bufferSizeBytes, particleProperties.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Builds the BVH on the CPU with the binned SAH builder (see CpuBvhBuilders.h) and 
+        uploads it.  Takes the place of PrepareForBinaryTree(), GenerateBinaryRadixTree(), and 
+        MergeNodesIntoBvh().  The CPU builder makes the leaves' boxes too, and they are the 
+        same as GenerateLeafNodeBoundingBoxes.comp's.
+
+        Only the nodes that are in the tree are uploaded: the leaves [0, leaves in use) and 
+        the internal nodes [number of leaves, number of leaves + leaves in use - 1).  Their 
+        build data goes up too, so the BVH refit (see BvhRefitLayout.comp) can walk up the 
+        parents, and the counters are all 0 like the GPU builders leave them.
+
+        Note: The sort has to be done first, and this waits for it (see 
+        ReadBackCpuBvhBuildInput(...)).
+
+        Also Note: The thread pool is made by SetBvhBuilder(...).
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::BuildBvhBinnedSah() const
+    {
+        unsigned int numActiveParticles = 0;
+        std::vector<ParticleSortingData> sortedData;
+        std::vector<ParticleSortingData64> sortedData64;
+        std::vector<Particle> particles;
+        std::vector<ParticleProperties> particleProperties;
+        ReadBackCpuBvhBuildInput(numActiveParticles, sortedData, sortedData64, particles, particleProperties);
+
+        std::vector<BvhNode> nodes;
+        std::vector<BvhNodeBuildData> buildData;
+        if (MortonCodeKeyWidth(_mortonCodeEncoding) == SortingKeyWidth::KEY_64_BIT)
+        {
+            BuildBvhBinnedSahCpu(sortedData64, numActiveParticles, particles, particleProperties, 
+                _maxParticlesPerBvhLeaf, *_cpuThreadPool, nodes, buildData);
+        }
+        else
+        {
+            BuildBvhBinnedSahCpu(sortedData, numActiveParticles, particles, particleProperties, 
+                _maxParticlesPerBvhLeaf, *_cpuThreadPool, nodes, buildData);
+        }
 
-        // the two shaders worked on independent data, so only need one memory barrier at the end
+        unsigned int numLeavesInUse = (numActiveParticles + _maxParticlesPerBvhLeaf - 1) / _maxParticlesPerBvhLeaf;
+        unsigned int numLeaves = _bvhNodeSsbo.NumLeafNodes();
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bvhNodeSsbo.BufferId());
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, numLeavesInUse * sizeof(BvhNode), nodes.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bvhNodeBuildDataSsbo.BufferId());
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, numLeavesInUse * sizeof(BvhNodeBuildData), buildData.data());
+        if (numLeavesInUse >= 2)
+        {
+            unsigned int numInternalNodes = numLeavesInUse - 1;
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bvhNodeSsbo.BufferId());
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, numLeaves * sizeof(BvhNode), numInternalNodes * sizeof(BvhNode), nodes.data() + numLeaves);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, _bvhNodeBuildDataSsbo.BufferId());
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, numLeaves * sizeof(BvhNodeBuildData), numInternalNodes * sizeof(BvhNodeBuildData), buildData.data() + numLeaves);
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        // the uploads are ordered with anything that is dispatched after them, but the shaders 
+        // that go next need to see it
         glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
     }
 
     /*--------------------------------------------------------------------------------------------
     Description:
-        All that sorting to get to here.
+        Rearranges the BVH that was just built into one with a lower SAH cost, and gives the 
+        nodes that moved their new bounding boxes in the same dispatch (see 
+        RestructureBvhTreelets.comp).
+        Note: Expects the ActiveParticlesSsbo to be bound to GL_DISPATCH_INDIRECT_BUFFER.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::RestructureBvhTreelets() const
+    {
+        glUseProgram(_programIdRestructureBvhTreelets);
+        glDispatchComputeIndirect(_activeParticlesSsbo.DispatchCommandByteOffset(ACTIVE_PARTICLES_DISPATCH_BVH_LEAVES));
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Makes the 4-wide BVH out of the binary one that was just built or refit (see 
+        CollapseBvhToWideNodes.comp).
+        Note: Expects the ActiveParticlesSsbo to be bound to GL_DISPATCH_INDIRECT_BUFFER.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::CollapseBvhToWideNodes() const
+    {
+        glUseProgram(_programIdCollapseBvhToWideNodes);
+        glDispatchComputeIndirect(_activeParticlesSsbo.DispatchCommandByteOffset(ACTIVE_PARTICLES_DISPATCH_BVH_LEAVES));
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Makes the quantized copies of the nodes of the binary BVH that was just built or refit 
+        (see QuantizeBvhNodes.comp).
+        Note: Expects the ActiveParticlesSsbo to be bound to GL_DISPATCH_INDIRECT_BUFFER.
+    Parameters: None
+    Returns:    None
+    Creator:    John Cox, 7/2017
+    --------------------------------------------------------------------------------------------*/
+    void ParticleCollisions::QuantizeBvhNodes() const
+    {
+        glUseProgram(_programIdQuantizeBvhNodes);
+        glDispatchComputeIndirect(_activeParticlesSsbo.DispatchCommandByteOffset(ACTIVE_PARTICLES_DISPATCH_BVH_LEAVES));
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    /*--------------------------------------------------------------------------------------------
+    Description:
+        Instead of sorting and building a new tree, keeps the tree from last time and gives it 
+        new bounding boxes (see BvhRefitLayout.comp).  The leaves get new boxes from wherever 
+        their particles are now, and then they are merged up to the root the same way as when 
+        the tree is built.
+
+        The active particles are counted too so that PlanBvhRefit.comp can tell whether any 
+        of them are missing from the tree.
+
+        Note: Nothing touches the sorting data or the ActiveParticlesSsbo, so the leaves still 
+        find their particles (see LeafToParticleIndex.comp), and the number of leaves and the 
+        dispatch commands are still the ones from the last rebuild.
+
+        Also Note: Expects the ActiveParticlesSsbo to be bound to GL_DISPATCH_INDIRECT_BUFFER.
     Parameters: 
         numWorkGroupsX      Expected to be number of particles divided by work group size.
     Returns:    None
-    Creator:    John Cox, 6/2017
+    Creator:    John Cox, 7/2017
     --------------------------------------------------------------------------------------------*/
-    void ParticleCollisions::GenerateBinaryRadixTree(unsigned int numWorkGroupsX) const
+    void ParticleCollisions::RefitBvh(unsigned int numWorkGroupsX) const
     {
-        glUseProgram(_programIdGenerateBinaryRadixTree);
+        glUseProgram(_programIdCountActiveParticles);
         glDispatchCompute(numWorkGroupsX, 1, 1);
+        glUseProgram(_programIdGenerateLeafNodeBoundingBoxes);
+        glDispatchComputeIndirect(_activeParticlesSsbo.DispatchCommandByteOffset(ACTIVE_PARTICLES_DISPATCH_BVH_LEAVES));
+
+        // the two shaders only share the refit counters, and those are atomic
         glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        MergeNodesIntoBvh();
+
+        // the 4-wide tree and the quantized nodes have copies of the boxes, so they have to be 
+        // made again
+        if (_useWideBvhTraversal)
+        {
+            CollapseBvhToWideNodes();
+        }
+
+        if (_useQuantizedBvhTraversal)
+        {
+            QuantizeBvhNodes();
+        }
     }
 
     /*--------------------------------------------------------------------------------------------
     Description:
-        And finally the binary radix tree blooms with beautiful bounding boxes into a Bounding 
-        Volume Hierarchy.  I'm tired and am thinking of nice "tree in spring" analogy.  The 
-        analogy starts to fall apart when I think of creating the tree anew ~60x/sec.  
+        Measures the tree that was just built or refit and has the GPU decide whether the next 
+        frame should rebuild it (see BvhRefitLayout.comp).  The CPU picks the decision up at 
+        the start of the next frame (see BvhRebuildRequested()).
+
+        Note: Expects the ActiveParticlesSsbo to be bound to GL_DISPATCH_INDIRECT_BUFFER.
     Parameters: 
-        numWorkGroupsX      Expected to be number of particles divided by work group size.
+        justRebuilt     True if the tree was just built.  Its size is what the refits are 
+                        compared against until the next rebuild.
     Returns:    None
-    Creator:    John Cox, 6/2017
+    Creator:    John Cox, 7/2017
     --------------------------------------------------------------------------------------------*/
-    void ParticleCollisions::MergeNodesIntoBvh(unsigned int numWorkGroupsX) const
+    void ParticleCollisions::PlanBvhRefit(bool justRebuilt) const
     {
-        glUseProgram(_programIdMergeBoundingVolumes);
-        glDispatchCompute(numWorkGroupsX, 1, 1);
+        glUseProgram(_programIdMeasureBvhArea);
+        glDispatchComputeIndirect(_activeParticlesSsbo.DispatchCommandByteOffset(ACTIVE_PARTICLES_DISPATCH_BVH_LEAVES));
         glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        glUseProgram(_programIdPlanBvhRefit);
+        glUniform1ui(UNIFORM_LOCATION_BVH_REFIT_JUST_REBUILT, justRebuilt ? 1 : 0);
+        glDispatchCompute(1, 1, 1);
+
+        // the decision will be copied with glCopyBufferSubData(...) for the CPU to pick up 
+        // next frame
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+        _bvhRefitSsbo.QueueRebuildDecisionReadback();
     }
 
     /*--------------------------------------------------------------------------------------------
     Description:
         Populates the ParticlePotentialCollisionsBuffer.
-    Parameters: 
-        numWorkGroupsX      Expected to be number of particles divided by work group size.
+        Note: Expects the ActiveParticlesSsbo to be bound to GL_DISPATCH_INDIRECT_BUFFER.
+    Parameters: None
     Returns:    None
     Creator:    John Cox, 6/2017
     --------------------------------------------------------------------------------------------*/
-    void ParticleCollisions::DetectCollisions(unsigned int numWorkGroupsX) const
+    void ParticleCollisions::DetectCollisions() const
     {
-        glUseProgram(_programIdDetectCollisions);
-        glDispatchCompute(numWorkGroupsX, 1, 1);
+        // same shader every way, just a different tree to go through
+        if (_useWideBvhTraversal)
+        {
+            glUseProgram(_programIdDetectCollisionsWideBvh);
+        }
+        else if (_useQuantizedBvhTraversal)
+        {
+            glUseProgram(_programIdDetectCollisionsQuantizedBvh);
+        }
+        else
+        {
+            glUseProgram(_programIdDetectCollisions);
+        }
+        glDispatchComputeIndirect(_activeParticlesSsbo.DispatchCommandByteOffset(ACTIVE_PARTICLES_DISPATCH_PARTICLES));
         glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
     }
 
@@ -1377,15 +2854,15 @@ namespace ShaderControllers
     Description:
         Reads the ParticlePotentialCollisionsBuffer and gives particles new velocity vectors if 
         they collide.
-    Parameters: 
-        numWorkGroupsX      Expected to be number of particles divided by work group size.
+        Note: Expects the ActiveParticlesSsbo to be bound to GL_DISPATCH_INDIRECT_BUFFER.
+    Parameters: None
     Returns:    None
     Creator:    John Cox, 6/2017
     --------------------------------------------------------------------------------------------*/
-    void ParticleCollisions::ResolveCollisions(unsigned int numWorkGroupsX) const
+    void ParticleCollisions::ResolveCollisions() const
     {
         glUseProgram(_programIdResolveCollisions);
-        glDispatchCompute(numWorkGroupsX, 1, 1);
+        glDispatchComputeIndirect(_activeParticlesSsbo.DispatchCommandByteOffset(ACTIVE_PARTICLES_DISPATCH_PARTICLES));
         glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
     }
 
@@ -59,7 +59,9 @@ namespace ShaderControllers
         glBindVertexArray(particleSsboToRender->VaoId());
 
         // in the case of particles, "num items" == "num vertices", so either getter is fine
-        glDrawArrays(particleSsboToRender->DrawStyle(), 0, particleSsboToRender->NumVertices());
+        // Note: The particles are in whichever half of the buffer is the front right now (see 
+        // ParticleSsbo.h).
+        glDrawArrays(particleSsboToRender->DrawStyle(), particleSsboToRender->FrontHalfFirstVertex(), particleSsboToRender->NumVertices());
         glBindVertexArray(0);
         glUseProgram(0);
     }
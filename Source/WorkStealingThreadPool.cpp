@@ -0,0 +1,223 @@
+#include "Include/WorkStealingThreadPool.h"
+
+#include <algorithm>
+
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Gives every thread its queue and starts the workers.  They go right to sleep until there
+    is something to do.
+Parameters:
+    numThreads  How many threads work on a ParallelFor(...), counting the one that calls it.
+                0 uses one per hardware thread.
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+WorkStealingThreadPool::WorkStealingThreadPool(unsigned int numThreads) :
+    _numQueuedTasks(0),
+    _shuttingDown(false)
+{
+    if (numThreads == 0)
+    {
+        // Note: This is allowed to be 0 if the hardware can't tell.
+        numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    for (unsigned int queueIndex = 0; queueIndex < numThreads; queueIndex++)
+    {
+        _queues.push_back(std::unique_ptr<TaskQueue>(new TaskQueue()));
+    }
+
+    // the calling thread has queue 0
+    for (unsigned int queueIndex = 1; queueIndex < numThreads; queueIndex++)
+    {
+        _workers.push_back(std::thread(&WorkStealingThreadPool::WorkerLoop, this, queueIndex));
+    }
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Wakes up the workers to tell them to quit, then waits for them to do so.
+
+    Note: ParallelFor(...) doesn't return until everything that it queued is done, so there is
+    never any work left over by the time that this runs.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+WorkStealingThreadPool::~WorkStealingThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _shuttingDown = true;
+    }
+    _wakeUp.notify_all();
+
+    for (std::thread &worker : _workers)
+    {
+        worker.join();
+    }
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    A simple getter for the value that was given (or figured out) on creation.
+Parameters: None
+Returns:
+    How many threads work on a ParallelFor(...), counting the one that calls it.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int WorkStealingThreadPool::NumThreads() const
+{
+    return static_cast<unsigned int>(_queues.size());
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Calls body(begin, end) on chunks of [0, numItems) until all of them have been done, spread
+    out over all the threads.  The calling thread works on them too, and this doesn't return
+    until every chunk is done.
+
+    The chunks are dealt out to the queues in blocks so that each thread starts out on items
+    that are next to each other.  The steals take from the front of the other queues, which is
+    the end of the block that the other thread would have gotten to last.
+
+    Note: Chunks run in no particular order and at the same time as each other, so the body
+    must be fine with that.  The CPU BVH builders are the GPU algorithms, which already are.
+Parameters:
+    numItems        Self-explanatory.
+    itemsPerChunk   How many items a task gets.  Big enough that the queues aren't a
+                    bottleneck and small enough that there is plenty to steal.
+    body            Called with the [begin, end) of a chunk.
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+void WorkStealingThreadPool::ParallelFor(unsigned int numItems, unsigned int itemsPerChunk,
+    const std::function<void(unsigned int, unsigned int)> &body)
+{
+    if (numItems == 0)
+    {
+        return;
+    }
+
+    itemsPerChunk = std::max(itemsPerChunk, 1u);
+    unsigned int numChunks = (numItems + itemsPerChunk - 1) / itemsPerChunk;
+    if (numChunks == 1 || _workers.empty())
+    {
+        // nobody to share with
+        body(0, numItems);
+        return;
+    }
+
+    // the last thing that a task does is count itself off, so this is safe to leave on the
+    // stack as long as this doesn't return until it gets to 0
+    std::atomic<unsigned int> numChunksLeft(numChunks);
+    unsigned int numQueues = NumThreads();
+    for (unsigned int chunk = 0; chunk < numChunks; chunk++)
+    {
+        unsigned int begin = chunk * itemsPerChunk;
+        unsigned int end = std::min(begin + itemsPerChunk, numItems);
+        TaskQueue &queue = *_queues[(static_cast<unsigned long long>(chunk) * numQueues) / numChunks];
+
+        std::lock_guard<std::mutex> lock(queue._mutex);
+        queue._tasks.push_back([&body, &numChunksLeft, begin, end]()
+        {
+            body(begin, end);
+            numChunksLeft.fetch_sub(1, std::memory_order_acq_rel);
+        });
+    }
+
+    // Note: The count goes up under the lock that the workers check it under so that none of
+    // them can check it, miss it, and go to sleep in between.
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _numQueuedTasks += static_cast<int>(numChunks);
+    }
+    _wakeUp.notify_all();
+
+    // help out until everything is done, including the chunks that other threads are still on
+    std::function<void()> task;
+    while (numChunksLeft.load(std::memory_order_acquire) != 0)
+    {
+        if (PopTask(0, task))
+        {
+            task();
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Takes the newest task off of the thread's own queue, or if that is empty, steals the oldest
+    one from someone else's.
+
+    Note: The workers can take a task before ParallelFor(...) has counted it, so the count can
+    dip below 0 for a moment.  That is why it is signed.
+Parameters:
+    queueIndex  The thread's own queue.
+    task        Receives the task, if there is one.
+Returns:
+    True if there was a task, otherwise false.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+bool WorkStealingThreadPool::PopTask(unsigned int queueIndex, std::function<void()> &task)
+{
+    unsigned int numQueues = NumThreads();
+    for (unsigned int offset = 0; offset < numQueues; offset++)
+    {
+        TaskQueue &queue = *_queues[(queueIndex + offset) % numQueues];
+        std::lock_guard<std::mutex> lock(queue._mutex);
+        if (queue._tasks.empty())
+        {
+            continue;
+        }
+
+        if (offset == 0)
+        {
+            task = std::move(queue._tasks.back());
+            queue._tasks.pop_back();
+        }
+        else
+        {
+            task = std::move(queue._tasks.front());
+            queue._tasks.pop_front();
+        }
+        _numQueuedTasks.fetch_sub(1);
+        return true;
+    }
+
+    return false;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    What the workers do until the pool is destroyed: work while there is work, sleep while
+    there isn't.
+Parameters:
+    queueIndex  The worker's own queue.
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+void WorkStealingThreadPool::WorkerLoop(unsigned int queueIndex)
+{
+    std::function<void()> task;
+    while (true)
+    {
+        if (PopTask(queueIndex, task))
+        {
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_sleepMutex);
+        _wakeUp.wait(lock, [this]() { return _shuttingDown || (_numQueuedTasks.load() > 0); });
+        if (_shuttingDown)
+        {
+            return;
+        }
+    }
+}
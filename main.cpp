@@ -36,6 +36,9 @@
 #include <stdio.h>
 #include <memory>
 #include <algorithm>    // for generating demo data
+#include <vector>
+#include <fstream>      // for the sort scaling benchmark
+#include <iostream>
 
 // for basic OpenGL stuff
 #include "Include/OpenGlErrorHandling.h"
@@ -55,8 +58,24 @@
 #include "Include/ShaderControllers/RenderParticles.h"
 #include "Include/ShaderControllers/RenderGeometry.h"
 
+// for the sort scaling benchmark
+#include <random>
+#include "Include/Buffers/ParticleSortingData.h"
+#include "Include/Buffers/SSBOs/ParticleSortingDataSsbo.h"
+#include "Include/Buffers/SSBOs/ActiveParticlesSsbo.h"
+#include "Include/ShaderControllers/GpuKeyValueSorter.h"
+
+// for comparing the Morton Code encoders
+#include "Include/MortonCode.h"
+
+// for the CPU BVH builder benchmark
+#include <chrono>
+#include "Include/CpuBvhBuilders.h"
+
 // for the frame rate counter (and other profiling)
 #include "Include/ShaderControllers/ProfilingWaitToFinish.h"
+#include "Shaders/ShaderHeaders/ComputeShaderWorkGroupSizes.comp"
+#include "Shaders/Compute/ParticleCollisions/SharedMemorySortLayout.comp"
 #include "Include/RenderFrameRate/FreeTypeEncapsulated.h"
 #include "Include/RenderFrameRate/Stopwatch.h"
 
@@ -73,6 +92,10 @@ std::shared_ptr<ShaderControllers::RenderGeometry> geometryRenderer = nullptr;
 
 const unsigned int MAX_PARTICLE_COUNT = 5000;
 
+// how many particles each of the BVH's leaves can hold (see BvhLeaves.comp)
+// Note: CompareBvhLeafSizes() is there for picking this.
+const unsigned int MAX_PARTICLES_PER_BVH_LEAF = 4;
+
 
 /*------------------------------------------------------------------------------------------------
 Description:
@@ -218,7 +241,9 @@ void Init()
     //parallelSort = std::make_unique<ShaderControllers::ParallelSort>(particleBuffer);
 
     // for sorting, detecting collisions between, and resolving said collisions between particles
-    particleCollisions = std::make_shared<ShaderControllers::ParticleCollisions>(particleBuffer, particlePropertiesBuffer);
+    // Note: The simulation is 2D, so the particles are sorted by the 2D Morton Code (see 
+    // MortonCode.h).
+    particleCollisions = std::make_shared<ShaderControllers::ParticleCollisions>(particleBuffer, particlePropertiesBuffer, MortonCodeEncoding::MORTON_CODE_2D_16_BITS, MAX_PARTICLES_PER_BVH_LEAF);
 
     // for drawing particles
     particleRenderer = std::make_unique<ShaderControllers::RenderParticles>();
@@ -230,6 +255,1298 @@ void Init()
     gTimer.Start();
 }
 
+/*------------------------------------------------------------------------------------------------
+Description:
+    Counts how many of the given Morton Codes are duplicates of another one.  Also finds the 
+    biggest group of particles that all have the same code.
+Parameters: 
+    mortonCodes         A copy, because it gets sorted.  32bit codes are widened.
+    numDuplicates       Receives the number of codes that are the same as the one before them 
+                        once sorted (so a group of 3 identical codes counts as 2).
+    largestClumpSize    Receives the size of the biggest group of identical codes.
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+void CountDuplicateMortonCodes(std::vector<unsigned long long> mortonCodes, 
+    unsigned int &numDuplicates, unsigned int &largestClumpSize)
+{
+    std::sort(mortonCodes.begin(), mortonCodes.end());
+    numDuplicates = 0;
+    largestClumpSize = mortonCodes.empty() ? 0 : 1;
+    unsigned int clumpSize = 1;
+    for (size_t codeIndex = 1; codeIndex < mortonCodes.size(); codeIndex++)
+    {
+        if (mortonCodes[codeIndex] == mortonCodes[codeIndex - 1])
+        {
+            numDuplicates++;
+            clumpSize++;
+            largestClumpSize = std::max(largestClumpSize, clumpSize);
+        }
+        else
+        {
+            clumpSize = 1;
+        }
+    }
+}
+
+// the particle counts and the frames to stop at for the benchmarks that take snapshots of the 
+// demo scene (see MakeBenchmarkScene(...))
+const std::vector<unsigned int> BENCHMARK_PARTICLE_COUNTS = 
+{
+    MAX_PARTICLE_COUNT,
+    64 * 1024,
+    256 * 1024
+};
+const std::vector<unsigned int> BENCHMARK_FRAMES_TO_SAMPLE = { 100, 250, 500 };
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Lets go of the particle buffer and the controllers that use it, then makes them again with 
+    room for the given number of particles so that a benchmark can run the demo scene (see 
+    GenerateParticleEmitters()) at that count.  The scene runs on the default 2D Morton Code 
+    and MAX_PARTICLES_PER_BVH_LEAF.
+
+    Note: The demo emits 4 particles per emitter per frame for MAX_PARTICLE_COUNT particles.  
+    The emit rate scales with the particle count so that the bigger scenes fill up in about the 
+    same number of frames and are denser where the bars meet.
+Parameters: 
+    particleCount   Self-explanatory.
+Returns:    
+    How many particles each emitter should emit per frame (see RunBenchmarkFrames(...)).
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+unsigned int MakeBenchmarkScene(unsigned int particleCount)
+{
+    // let go of the last scene's buffers before making the next ones
+    particleCollisions = nullptr;
+    particleUpdater = nullptr;
+    particleResetter = nullptr;
+    particleBuffer = nullptr;
+
+    particleBuffer = std::make_shared<ParticleSsbo>(particleCount);
+    particleResetter = std::make_shared<ShaderControllers::ParticleReset>(particleBuffer);
+    GenerateParticleEmitters();
+    particleUpdater = std::make_shared<ShaderControllers::ParticleUpdate>(particleBuffer);
+    particleCollisions = std::make_shared<ShaderControllers::ParticleCollisions>(particleBuffer, particlePropertiesBuffer, MortonCodeEncoding::MORTON_CODE_2D_16_BITS, MAX_PARTICLES_PER_BVH_LEAF);
+
+    return std::max(4u, (particleCount * 4) / MAX_PARTICLE_COUNT);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Runs the benchmark scene (see MakeBenchmarkScene(...)) for the given number of frames 
+    without rendering and waits for the GPU to finish them.
+Parameters: 
+    numFrames                   Self-explanatory.
+    particlesPerEmitterPerFrame From MakeBenchmarkScene(...).
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+void RunBenchmarkFrames(unsigned int numFrames, unsigned int particlesPerEmitterPerFrame)
+{
+    for (unsigned int frameCount = 0; frameCount < numFrames; frameCount++)
+    {
+        particleResetter->ResetParticles(particlesPerEmitterPerFrame);
+        particleUpdater->Update(0.01f);
+        particleCollisions->DetectAndResolve(false, false);
+    }
+    ShaderControllers::WaitForComputeToFinish();
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Reads back every particle in the front half of the particle buffer, which is the half that 
+    the scene is using (see ParticleSsbo.h).
+
+    Note: Expects the GPU to be done with the particles (see RunBenchmarkFrames(...)).
+Parameters: None
+Returns:    
+    A copy of the particles, active or not.
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+std::vector<Particle> SnapshotParticles()
+{
+    std::vector<Particle> snapshot(particleBuffer->NumParticles());
+    unsigned int bufferSizeBytes = snapshot.size() * sizeof(Particle);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, particleBuffer->BufferId());
+    void *bufferPtr = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, particleBuffer->FrontHalfByteOffset(), bufferSizeBytes, GL_MAP_READ_BIT);
+    memcpy(snapshot.data(), bufferPtr, bufferSizeBytes);
+    glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    return snapshot;
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Writes a snapshot from SnapshotParticles() back over the front half of the particle buffer 
+    so that a measurement starts from the same particles as the one before it, or so that the 
+    scene carries on as if nothing happened.
+Parameters: 
+    snapshot    Self-explanatory.
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+void RestoreParticles(const std::vector<Particle> &snapshot)
+{
+    unsigned int bufferSizeBytes = snapshot.size() * sizeof(Particle);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, particleBuffer->BufferId());
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, particleBuffer->FrontHalfByteOffset(), bufferSizeBytes, snapshot.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Runs the demo scene (two bars emitting at each other, see GenerateParticleEmitters()) at 
+    a few particle counts and, every so often, reads the particles back and turns each active 
+    particle's position into every kind of Morton Code on the CPU (see MortonCode.h).  
+    The share of active particles whose code is a duplicate of another particle's, and the 
+    biggest group of identical codes, goes to stdout and to the tab-delimited 
+    "MortonCodeCollisionRates.txt" so that they can be dumped into an Excel spreadsheet.
+
+    All encoders see exactly the same positions, so the difference is only the encoding.  
+    Duplicate codes have to be told apart by their indices when the tree is built (see 
+    GenerateBinaryRadixTree.comp), and every one of them is a pair of particles that the tree 
+    can't tell apart by position.
+
+    Also checks that every code decodes back to a position in the same cell (except the 64-bit 
+    2D code, whose cells are smaller than a float can tell apart).
+
+    This is half of the comparison between 32-bit and 64-bit sort keys (see 
+    SortingKey64.comp).  The other half, what the extra bits cost the sort, is in 
+    ProfileSortScaling().
+
+    Note: The emit rate scales with the particle count so that the bigger scenes are denser 
+    where the bars meet, which is where the duplicates come from.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+void CompareMortonCodeCollisionRates()
+{
+    std::vector<unsigned int> particleCounts = 
+    {
+        MAX_PARTICLE_COUNT,
+        64 * 1024,
+        1024 * 1024
+    };
+    std::vector<MortonCodeEncoding> encodings = 
+    {
+        MortonCodeEncoding::MORTON_CODE_3D_10_BITS,
+        MortonCodeEncoding::MORTON_CODE_2D_16_BITS,
+        MortonCodeEncoding::MORTON_CODE_3D_21_BITS_64,
+        MortonCodeEncoding::MORTON_CODE_2D_32_BITS_64,
+        MortonCodeEncoding::HILBERT_CODE_2D_16_BITS
+    };
+    std::vector<std::string> encodingNames = { "3D", "2D", "3D 64-bit", "2D 64-bit", "2D Hilbert" };
+
+    std::ofstream outFile("MortonCodeCollisionRates.txt");
+    outFile << "particles\tframe\tactive particles";
+    for (size_t encodingIndex = 0; encodingIndex < encodings.size(); encodingIndex++)
+    {
+        const std::string &name = encodingNames[encodingIndex];
+        outFile << "\t" << name << " duplicates\t" << name << " duplicate rate\t" << name << " largest clump";
+    }
+    outFile << "\tround trip failures" << std::endl;
+
+    for (size_t countIndex = 0; countIndex < particleCounts.size(); countIndex++)
+    {
+        unsigned int particleCount = particleCounts[countIndex];
+
+        unsigned int particlesPerEmitterPerFrame = MakeBenchmarkScene(particleCount);
+
+        unsigned int frameCount = 0;
+        for (size_t sampleIndex = 0; sampleIndex < BENCHMARK_FRAMES_TO_SAMPLE.size(); sampleIndex++)
+        {
+            RunBenchmarkFrames(BENCHMARK_FRAMES_TO_SAMPLE[sampleIndex] - frameCount, particlesPerEmitterPerFrame);
+            frameCount = BENCHMARK_FRAMES_TO_SAMPLE[sampleIndex];
+
+            std::vector<Particle> particles = SnapshotParticles();
+
+            std::vector<std::vector<unsigned long long>> mortonCodes(encodings.size());
+            unsigned int numRoundTripFailures = 0;
+            for (size_t particleIndex = 0; particleIndex < particles.size(); particleIndex++)
+            {
+                const Particle &p = particles[particleIndex];
+                if (p._isActive == 0)
+                {
+                    continue;
+                }
+
+                for (size_t encodingIndex = 0; encodingIndex < encodings.size(); encodingIndex++)
+                {
+                    MortonCodeEncoding encoding = encodings[encodingIndex];
+                    unsigned long long code = PositionToMortonCode(p._pos, encoding);
+                    mortonCodes[encodingIndex].push_back(code);
+
+                    // the decoders give the center of the cell, which must encode the same
+                    if (encoding != MortonCodeEncoding::MORTON_CODE_2D_32_BITS_64 && 
+                        PositionToMortonCode(MortonCodeToPosition(code, encoding), encoding) != code)
+                    {
+                        numRoundTripFailures++;
+                    }
+                }
+            }
+
+            unsigned int numActive = mortonCodes[0].size();
+            std::cout << particleCount << " particles, frame " << frameCount << ": " << numActive << " active";
+            outFile << particleCount << "\t" << frameCount << "\t" << numActive;
+            for (size_t encodingIndex = 0; encodingIndex < encodings.size(); encodingIndex++)
+            {
+                unsigned int numDuplicates = 0;
+                unsigned int largestClump = 0;
+                CountDuplicateMortonCodes(mortonCodes[encodingIndex], numDuplicates, largestClump);
+                float rate = (numActive == 0) ? 0.0f : static_cast<float>(numDuplicates) / numActive;
+
+                std::cout << ", " << encodingNames[encodingIndex] << " duplicates " << numDuplicates 
+                    << " (" << (rate * 100.0f) << "%, largest clump " << largestClump << ")";
+                outFile << "\t" << numDuplicates << "\t" << rate << "\t" << largestClump;
+            }
+            std::cout << ", round trip failures " << numRoundTripFailures << std::endl;
+            outFile << "\t" << numRoundTripFailures << std::endl;
+        }
+    }
+    outFile.close();
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Runs the demo scene (see GenerateParticleEmitters()) at a few particle counts and, every so 
+    often, hands a snapshot of the particles to one ParticleCollisions per sort key (see 
+    MortonCode.h).  Each builds its BVH over exactly the same particles and measures it (see 
+    ParticleCollisions::MeasureTreeQuality(...)).  The SAH cost, the number of internal nodes 
+    that collision detection goes through, the number of potential collisions, and the 
+    collision detection time go to stdout and to the tab-delimited "SortingKeyTreeQuality.txt" 
+    so that they can be dumped into an Excel spreadsheet.
+
+    This is for the Z-order curve against the Hilbert curve.  The Z-order curve's jumps 
+    between quadrants should show up as a higher SAH cost and more nodes visited.  The 
+    potential collisions should be the same for every key.  If they aren't, then one of the 
+    trees is broken.
+
+    Note: The scene itself runs on the default 2D Morton Code.  The snapshot is put back after 
+    the measurements so that the scene carries on as if nothing happened.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+void CompareSortingKeyTreeQuality()
+{
+    std::vector<MortonCodeEncoding> encodings = 
+    {
+        MortonCodeEncoding::MORTON_CODE_3D_10_BITS,
+        MortonCodeEncoding::MORTON_CODE_2D_16_BITS,
+        MortonCodeEncoding::HILBERT_CODE_2D_16_BITS,
+        MortonCodeEncoding::MORTON_CODE_2D_32_BITS_64
+    };
+    std::vector<std::string> encodingNames = { "3D", "2D", "2D Hilbert", "2D 64-bit" };
+    const unsigned int NUM_TIMED_TRAVERSALS = 10;
+
+    std::ofstream outFile("SortingKeyTreeQuality.txt");
+    outFile << "particles\tframe\tactive particles";
+    for (size_t encodingIndex = 0; encodingIndex < encodings.size(); encodingIndex++)
+    {
+        const std::string &name = encodingNames[encodingIndex];
+        outFile << "\t" << name << " SAH cost\t" << name << " nodes visited\t" << name << " potential collisions\t" << name << " detect collisions (microseconds)";
+    }
+    outFile << std::endl;
+
+    for (size_t countIndex = 0; countIndex < BENCHMARK_PARTICLE_COUNTS.size(); countIndex++)
+    {
+        unsigned int particleCount = BENCHMARK_PARTICLE_COUNTS[countIndex];
+
+        unsigned int particlesPerEmitterPerFrame = MakeBenchmarkScene(particleCount);
+
+        // one per key, made once per count because the shaders take a while to assemble
+        std::vector<std::shared_ptr<ShaderControllers::ParticleCollisions>> measurers;
+        for (size_t encodingIndex = 0; encodingIndex < encodings.size(); encodingIndex++)
+        {
+            measurers.push_back(std::make_shared<ShaderControllers::ParticleCollisions>(particleBuffer, particlePropertiesBuffer, encodings[encodingIndex], MAX_PARTICLES_PER_BVH_LEAF));
+        }
+
+
+        unsigned int frameCount = 0;
+        for (size_t sampleIndex = 0; sampleIndex < BENCHMARK_FRAMES_TO_SAMPLE.size(); sampleIndex++)
+        {
+            RunBenchmarkFrames(BENCHMARK_FRAMES_TO_SAMPLE[sampleIndex] - frameCount, particlesPerEmitterPerFrame);
+            frameCount = BENCHMARK_FRAMES_TO_SAMPLE[sampleIndex];
+
+            std::vector<Particle> snapshot = SnapshotParticles();
+
+            std::cout << particleCount << " particles, frame " << frameCount << ":" << std::endl;
+            outFile << particleCount << "\t" << frameCount;
+            for (size_t encodingIndex = 0; encodingIndex < encodings.size(); encodingIndex++)
+            {
+                RestoreParticles(snapshot);
+
+                ShaderControllers::ParticleCollisions::TreeQuality quality = 
+                    measurers[encodingIndex]->MeasureTreeQuality(NUM_TIMED_TRAVERSALS);
+                if (encodingIndex == 0)
+                {
+                    outFile << "\t" << quality._numActiveParticles;
+                }
+
+                std::cout << "    " << encodingNames[encodingIndex] << ": " << quality._numActiveParticles 
+                    << " active, SAH cost " << quality._sahCost 
+                    << ", nodes visited " << quality._numNodesVisited 
+                    << ", potential collisions " << quality._numPotentialCollisions 
+                    << ", detect collisions " << quality._durationDetectCollisions << " microseconds" << std::endl;
+                outFile << "\t" << quality._sahCost << "\t" << quality._numNodesVisited << "\t" 
+                    << quality._numPotentialCollisions << "\t" << quality._durationDetectCollisions;
+            }
+            outFile << std::endl;
+
+            // put the scene back the way it was
+            RestoreParticles(snapshot);
+        }
+    }
+    outFile.close();
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Runs the demo scene (see GenerateParticleEmitters()) at a few particle counts, first with 
+    the BVH rebuilt every frame and then, from the same starting particles, with the BVH refit 
+    (see BvhRefitLayout.comp).  Each frame's DetectAndResolve(...) is timed.  The total time 
+    for each, how many times the refit rebuilt the tree anyway, and the time saved go to 
+    stdout and to the tab-delimited "BvhRefitComparison.txt" so that they can be dumped into 
+    an Excel spreadsheet.
+
+    Note: The scene runs for a while first so that there are plenty of active particles.  The 
+    emitters keep going the whole time, so the refit will rebuild often (see 
+    BVH_REFIT_MAX_UNTRACKED_PARTICLES).
+Parameters: None
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+void CompareBvhRefit()
+{
+    const unsigned int NUM_WARM_UP_FRAMES = 250;
+    const unsigned int NUM_TIMED_FRAMES = 500;
+
+    std::ofstream outFile("BvhRefitComparison.txt");
+    outFile << "particles\tframes\trebuild every frame (microseconds)\trefit (microseconds)\trebuilds\ttime saved (microseconds)" << std::endl;
+
+    for (size_t countIndex = 0; countIndex < BENCHMARK_PARTICLE_COUNTS.size(); countIndex++)
+    {
+        unsigned int particleCount = BENCHMARK_PARTICLE_COUNTS[countIndex];
+
+        unsigned int particlesPerEmitterPerFrame = MakeBenchmarkScene(particleCount);
+
+        particleCollisions->SetBvhRefit(false);
+        RunBenchmarkFrames(NUM_WARM_UP_FRAMES, particlesPerEmitterPerFrame);
+
+        std::vector<Particle> snapshot = SnapshotParticles();
+
+        // first without the refit, then with it
+        long long durations[2] = { 0, 0 };
+        unsigned int numRebuilds = 0;
+        for (int useRefit = 0; useRefit < 2; useRefit++)
+        {
+            RestoreParticles(snapshot);
+            particleCollisions->SetBvhRefit(useRefit == 1);
+            unsigned int numRebuildsBefore = particleCollisions->ReadBvhRefitState()._numBvhRebuilds;
+
+            for (unsigned int frameCount = 0; frameCount < NUM_TIMED_FRAMES; frameCount++)
+            {
+                particleResetter->ResetParticles(particlesPerEmitterPerFrame);
+                particleUpdater->Update(0.01f);
+                ShaderControllers::WaitForComputeToFinish();
+
+                using namespace std::chrono;
+                steady_clock::time_point start = high_resolution_clock::now();
+                particleCollisions->DetectAndResolve(false, false);
+                ShaderControllers::WaitForComputeToFinish();
+                steady_clock::time_point end = high_resolution_clock::now();
+                durations[useRefit] += duration_cast<microseconds>(end - start).count();
+            }
+
+            if (useRefit == 1)
+            {
+                numRebuilds = particleCollisions->ReadBvhRefitState()._numBvhRebuilds - numRebuildsBefore;
+            }
+        }
+
+        long long timeSaved = durations[0] - durations[1];
+        std::cout << particleCount << " particles, " << NUM_TIMED_FRAMES << " frames: rebuild every frame " 
+            << durations[0] << " microseconds, refit " << durations[1] << " microseconds (" 
+            << numRebuilds << " rebuilds), saved " << timeSaved << " microseconds" << std::endl;
+        outFile << particleCount << "\t" << NUM_TIMED_FRAMES << "\t" << durations[0] << "\t" 
+            << durations[1] << "\t" << numRebuilds << "\t" << timeSaved << std::endl;
+    }
+    outFile.close();
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Runs the demo scene (see GenerateParticleEmitters()) at a few particle counts and, every so 
+    often, hands a snapshot of the particles to one ParticleCollisions per BVH leaf size (see 
+    BvhLeaves.comp).  Each builds its BVH over exactly the same particles and measures it (see 
+    ParticleCollisions::MeasureTreeQuality(...)).  The number of leaves, the SAH cost, the 
+    number of internal nodes that collision detection goes through, the number of potential 
+    collisions, and the build and collision detection times go to stdout and to the 
+    tab-delimited "BvhLeafSizes.txt" so that they can be dumped into an Excel spreadsheet.
+
+    Bigger leaves make a smaller, shallower tree that is quicker to build and to go through, 
+    but each leaf that is found has more particles to check.  The detection time says where 
+    that balances out.  The potential collisions should be the same for every leaf size.  If 
+    they aren't, then one of the trees is broken.
+
+    Note: The scene itself runs on MAX_PARTICLES_PER_BVH_LEAF.  The snapshot is put back after 
+    the measurements so that the scene carries on as if nothing happened.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+void CompareBvhLeafSizes()
+{
+    std::vector<unsigned int> leafSizes = { 1, 2, 4, 8, 16 };
+    const unsigned int NUM_TIMED_TRAVERSALS = 10;
+
+    std::ofstream outFile("BvhLeafSizes.txt");
+    outFile << "particles\tframe\tactive particles";
+    for (size_t sizeIndex = 0; sizeIndex < leafSizes.size(); sizeIndex++)
+    {
+        std::string name = "K=" + std::to_string(leafSizes[sizeIndex]);
+        outFile << "\t" << name << " leaves\t" << name << " SAH cost\t" << name << " nodes visited\t" 
+            << name << " potential collisions\t" << name << " invalid nodes\t" << name << " build (microseconds)\t" 
+            << name << " detect collisions (microseconds)";
+    }
+    outFile << std::endl;
+
+    for (size_t countIndex = 0; countIndex < BENCHMARK_PARTICLE_COUNTS.size(); countIndex++)
+    {
+        unsigned int particleCount = BENCHMARK_PARTICLE_COUNTS[countIndex];
+
+        unsigned int particlesPerEmitterPerFrame = MakeBenchmarkScene(particleCount);
+
+        // one per leaf size, made once per count because the shaders take a while to assemble
+        std::vector<std::shared_ptr<ShaderControllers::ParticleCollisions>> measurers;
+        for (size_t sizeIndex = 0; sizeIndex < leafSizes.size(); sizeIndex++)
+        {
+            measurers.push_back(std::make_shared<ShaderControllers::ParticleCollisions>(particleBuffer, particlePropertiesBuffer, MortonCodeEncoding::MORTON_CODE_2D_16_BITS, leafSizes[sizeIndex]));
+        }
+
+
+        unsigned int frameCount = 0;
+        for (size_t sampleIndex = 0; sampleIndex < BENCHMARK_FRAMES_TO_SAMPLE.size(); sampleIndex++)
+        {
+            RunBenchmarkFrames(BENCHMARK_FRAMES_TO_SAMPLE[sampleIndex] - frameCount, particlesPerEmitterPerFrame);
+            frameCount = BENCHMARK_FRAMES_TO_SAMPLE[sampleIndex];
+
+            std::vector<Particle> snapshot = SnapshotParticles();
+
+            std::cout << particleCount << " particles, frame " << frameCount << ":" << std::endl;
+            outFile << particleCount << "\t" << frameCount;
+            for (size_t sizeIndex = 0; sizeIndex < leafSizes.size(); sizeIndex++)
+            {
+                RestoreParticles(snapshot);
+
+                ShaderControllers::ParticleCollisions::TreeQuality quality = 
+                    measurers[sizeIndex]->MeasureTreeQuality(NUM_TIMED_TRAVERSALS);
+                if (sizeIndex == 0)
+                {
+                    outFile << "\t" << quality._numActiveParticles;
+                }
+
+                std::cout << "    " << leafSizes[sizeIndex] << " per leaf: " << quality._numBvhLeaves 
+                    << " leaves, SAH cost " << quality._sahCost 
+                    << ", nodes visited " << quality._numNodesVisited 
+                    << ", potential collisions " << quality._numPotentialCollisions 
+                    << ", invalid nodes " << quality._numInvalidBvhNodes 
+                    << ", build " << quality._durationBuildBvh << " microseconds" 
+                    << ", detect collisions " << quality._durationDetectCollisions << " microseconds" << std::endl;
+                outFile << "\t" << quality._numBvhLeaves << "\t" << quality._sahCost << "\t" 
+                    << quality._numNodesVisited << "\t" << quality._numPotentialCollisions << "\t" 
+                    << quality._durationBuildBvh << "\t" << quality._durationDetectCollisions;
+            }
+            outFile << std::endl;
+
+            // put the scene back the way it was
+            RestoreParticles(snapshot);
+        }
+    }
+    outFile.close();
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Runs the demo scene (see GenerateParticleEmitters()) at a few particle counts and, every so 
+    often, has a separate ParticleCollisions build its BVH over a snapshot of the particles 
+    with each builder (see ParticleCollisions::SetBvhBuilder(...)) and measure it (see 
+    ParticleCollisions::MeasureTreeQuality(...)).  The SAH cost, the number of internal nodes 
+    that collision detection goes through, the number of potential collisions, and the build 
+    and collision detection times go to stdout and to the tab-delimited "BvhBuilders.txt" so 
+    that they can be dumped into an Excel spreadsheet.
+
+    The PLOC builder takes longer to build a better tree.  It is worth it when collision 
+    detection gets faster by more than the build gets slower.  The potential collisions 
+    should be the same for every builder.  If they aren't, then one of the trees is broken.  
+    The number of invalid nodes (see CountInvalidBvhNodes(...)) says which one, and it has to 
+    be 0 for every builder.
+
+    The binned SAH builder (see CpuBvhBuilders.h) is the baseline.  It runs on the CPU, so its 
+    build time is no contest, but its tree is about as good as a tree gets.  It goes first, 
+    and every builder's SAH cost is also given as a ratio to its SAH cost.  That is how much 
+    quality the GPU builders give up for their speed.
+
+    Note: The snapshot is put back before every measurement and after all of them so that the 
+    scene carries on as if nothing happened.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+void CompareBvhBuilders()
+{
+    std::vector<ShaderControllers::ParticleCollisions::BvhBuilder> builders = 
+    {
+        ShaderControllers::ParticleCollisions::BvhBuilder::BINNED_SAH_CPU,
+        ShaderControllers::ParticleCollisions::BvhBuilder::KARRAS_RADIX_TREE,
+        ShaderControllers::ParticleCollisions::BvhBuilder::AGGLOMERATIVE,
+        ShaderControllers::ParticleCollisions::BvhBuilder::PLOC
+    };
+    std::vector<std::string> builderNames = { "binned SAH (CPU)", "Karras", "agglomerative", "PLOC" };
+    const unsigned int NUM_TIMED_TRAVERSALS = 10;
+
+    std::ofstream outFile("BvhBuilders.txt");
+    outFile << "particles\tframe\tactive particles";
+    for (size_t builderIndex = 0; builderIndex < builders.size(); builderIndex++)
+    {
+        const std::string &name = builderNames[builderIndex];
+        outFile << "\t" << name << " SAH cost\t" << name << " SAH cost / baseline\t" << name << " nodes visited\t" 
+            << name << " potential collisions\t" << name << " invalid nodes\t" << name << " build (microseconds)\t" 
+            << name << " detect collisions (microseconds)\t" << name << " build + detect (microseconds)";
+    }
+    outFile << std::endl;
+
+    for (size_t countIndex = 0; countIndex < BENCHMARK_PARTICLE_COUNTS.size(); countIndex++)
+    {
+        unsigned int particleCount = BENCHMARK_PARTICLE_COUNTS[countIndex];
+
+        unsigned int particlesPerEmitterPerFrame = MakeBenchmarkScene(particleCount);
+
+        // the builder can be switched at any time, so one will do
+        std::shared_ptr<ShaderControllers::ParticleCollisions> measurer = std::make_shared<ShaderControllers::ParticleCollisions>(particleBuffer, particlePropertiesBuffer, MortonCodeEncoding::MORTON_CODE_2D_16_BITS, MAX_PARTICLES_PER_BVH_LEAF);
+
+
+        unsigned int frameCount = 0;
+        for (size_t sampleIndex = 0; sampleIndex < BENCHMARK_FRAMES_TO_SAMPLE.size(); sampleIndex++)
+        {
+            RunBenchmarkFrames(BENCHMARK_FRAMES_TO_SAMPLE[sampleIndex] - frameCount, particlesPerEmitterPerFrame);
+            frameCount = BENCHMARK_FRAMES_TO_SAMPLE[sampleIndex];
+
+            std::vector<Particle> snapshot = SnapshotParticles();
+
+            std::cout << particleCount << " particles, frame " << frameCount << ":" << std::endl;
+            outFile << particleCount << "\t" << frameCount;
+            float baselineSahCost = 0.0f;
+            for (size_t builderIndex = 0; builderIndex < builders.size(); builderIndex++)
+            {
+                RestoreParticles(snapshot);
+
+                measurer->SetBvhBuilder(builders[builderIndex]);
+                ShaderControllers::ParticleCollisions::TreeQuality quality = 
+                    measurer->MeasureTreeQuality(NUM_TIMED_TRAVERSALS);
+                if (builderIndex == 0)
+                {
+                    outFile << "\t" << quality._numActiveParticles;
+                    baselineSahCost = quality._sahCost;
+                }
+
+                // a tree of 0 or 1 leaves has no cost
+                float relativeSahCost = (baselineSahCost == 0.0f) ? 1.0f : quality._sahCost / baselineSahCost;
+                long long durationTotal = quality._durationBuildBvh + quality._durationDetectCollisions;
+                std::cout << "    " << builderNames[builderIndex] << ": SAH cost " << quality._sahCost 
+                    << " (" << relativeSahCost << "x baseline)" 
+                    << ", nodes visited " << quality._numNodesVisited 
+                    << ", potential collisions " << quality._numPotentialCollisions 
+                    << ", invalid nodes " << quality._numInvalidBvhNodes 
+                    << ", build " << quality._durationBuildBvh << " microseconds" 
+                    << ", detect collisions " << quality._durationDetectCollisions << " microseconds" 
+                    << ", together " << durationTotal << " microseconds" << std::endl;
+                outFile << "\t" << quality._sahCost << "\t" << relativeSahCost << "\t" 
+                    << quality._numNodesVisited << "\t" 
+                    << quality._numPotentialCollisions << "\t" << quality._numInvalidBvhNodes << "\t" 
+                    << quality._durationBuildBvh << "\t" 
+                    << quality._durationDetectCollisions << "\t" << durationTotal;
+            }
+            outFile << std::endl;
+
+            // put the scene back the way it was
+            RestoreParticles(snapshot);
+        }
+    }
+    outFile.close();
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Runs the demo scene (see GenerateParticleEmitters()) at a few particle counts and, every so 
+    often, has a separate ParticleCollisions build its BVH over a snapshot of the particles with 
+    and without the treelet restructuring (see RestructureBvhTreelets.comp), for each builder, 
+    and measure it (see ParticleCollisions::MeasureTreeQuality(...)).
+
+    The restructuring costs whatever it adds to the build time, and it pays for itself if 
+    collision detection gets faster by more than that.  Both go to stdout and to the 
+    tab-delimited "BvhTreeletRestructuring.txt" so that they can be dumped into an Excel 
+    spreadsheet, along with the SAH cost and the number of internal nodes that collision 
+    detection goes through.  The potential collisions should be the same with and without it.  
+    If they aren't, then the restructuring broke the tree.
+
+    Note: The snapshot is put back before every measurement and after all of them so that the 
+    scene carries on as if nothing happened.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+void CompareBvhTreeletRestructuring()
+{
+    std::vector<ShaderControllers::ParticleCollisions::BvhBuilder> builders = 
+    {
+        ShaderControllers::ParticleCollisions::BvhBuilder::KARRAS_RADIX_TREE,
+        ShaderControllers::ParticleCollisions::BvhBuilder::AGGLOMERATIVE,
+        ShaderControllers::ParticleCollisions::BvhBuilder::PLOC
+    };
+    std::vector<std::string> builderNames = { "Karras", "agglomerative", "PLOC" };
+    const unsigned int NUM_TIMED_TRAVERSALS = 10;
+
+    std::ofstream outFile("BvhTreeletRestructuring.txt");
+    outFile << "particles\tframe\tactive particles";
+    for (size_t builderIndex = 0; builderIndex < builders.size(); builderIndex++)
+    {
+        const std::string &name = builderNames[builderIndex];
+        outFile << "\t" << name << " SAH cost\t" << name << " restructured SAH cost\t" 
+            << name << " nodes visited\t" << name << " restructured nodes visited\t" 
+            << name << " potential collisions\t" << name << " restructured potential collisions\t" 
+            << name << " build (microseconds)\t" << name << " restructured build (microseconds)\t" 
+            << name << " detect collisions (microseconds)\t" << name << " restructured detect collisions (microseconds)\t" 
+            << name << " restructure cost (microseconds)\t" << name << " detection saved (microseconds)";
+    }
+    outFile << std::endl;
+
+    for (size_t countIndex = 0; countIndex < BENCHMARK_PARTICLE_COUNTS.size(); countIndex++)
+    {
+        unsigned int particleCount = BENCHMARK_PARTICLE_COUNTS[countIndex];
+
+        unsigned int particlesPerEmitterPerFrame = MakeBenchmarkScene(particleCount);
+
+        // the builder and the restructuring can be switched at any time, so one will do
+        std::shared_ptr<ShaderControllers::ParticleCollisions> measurer = std::make_shared<ShaderControllers::ParticleCollisions>(particleBuffer, particlePropertiesBuffer, MortonCodeEncoding::MORTON_CODE_2D_16_BITS, MAX_PARTICLES_PER_BVH_LEAF);
+
+
+        unsigned int frameCount = 0;
+        for (size_t sampleIndex = 0; sampleIndex < BENCHMARK_FRAMES_TO_SAMPLE.size(); sampleIndex++)
+        {
+            RunBenchmarkFrames(BENCHMARK_FRAMES_TO_SAMPLE[sampleIndex] - frameCount, particlesPerEmitterPerFrame);
+            frameCount = BENCHMARK_FRAMES_TO_SAMPLE[sampleIndex];
+
+            std::vector<Particle> snapshot = SnapshotParticles();
+
+            std::cout << particleCount << " particles, frame " << frameCount << ":" << std::endl;
+            outFile << particleCount << "\t" << frameCount;
+            for (size_t builderIndex = 0; builderIndex < builders.size(); builderIndex++)
+            {
+                // [0] without, [1] with
+                ShaderControllers::ParticleCollisions::TreeQuality qualities[2];
+                measurer->SetBvhBuilder(builders[builderIndex]);
+                for (int restructured = 0; restructured < 2; restructured++)
+                {
+                    RestoreParticles(snapshot);
+
+                    measurer->SetBvhTreeletRestructuring(restructured != 0);
+                    qualities[restructured] = measurer->MeasureTreeQuality(NUM_TIMED_TRAVERSALS);
+                }
+                if (builderIndex == 0)
+                {
+                    outFile << "\t" << qualities[0]._numActiveParticles;
+                }
+
+                // Note: Signed, because either one could come out negative.
+                long long restructureCost = qualities[1]._durationBuildBvh - qualities[0]._durationBuildBvh;
+                long long detectionSaved = qualities[0]._durationDetectCollisions - qualities[1]._durationDetectCollisions;
+                double speedup = (qualities[1]._durationDetectCollisions == 0) ? 0.0 : 
+                    static_cast<double>(qualities[0]._durationDetectCollisions) / qualities[1]._durationDetectCollisions;
+
+                std::cout << "    " << builderNames[builderIndex] << ": SAH cost " << qualities[0]._sahCost 
+                    << " -> " << qualities[1]._sahCost 
+                    << ", nodes visited " << qualities[0]._numNodesVisited << " -> " << qualities[1]._numNodesVisited 
+                    << ", potential collisions " << qualities[0]._numPotentialCollisions << " -> " << qualities[1]._numPotentialCollisions 
+                    << ", detect collisions " << qualities[0]._durationDetectCollisions << " -> " << qualities[1]._durationDetectCollisions 
+                    << " microseconds (" << speedup << "x), restructure cost " << restructureCost 
+                    << " microseconds, detection saved " << detectionSaved << " microseconds" << std::endl;
+                outFile << "\t" << qualities[0]._sahCost << "\t" << qualities[1]._sahCost << "\t" 
+                    << qualities[0]._numNodesVisited << "\t" << qualities[1]._numNodesVisited << "\t" 
+                    << qualities[0]._numPotentialCollisions << "\t" << qualities[1]._numPotentialCollisions << "\t" 
+                    << qualities[0]._durationBuildBvh << "\t" << qualities[1]._durationBuildBvh << "\t" 
+                    << qualities[0]._durationDetectCollisions << "\t" << qualities[1]._durationDetectCollisions << "\t" 
+                    << restructureCost << "\t" << detectionSaved;
+            }
+            outFile << std::endl;
+
+            // put the scene back the way it was
+            RestoreParticles(snapshot);
+        }
+    }
+    outFile.close();
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Runs the demo scene (see GenerateParticleEmitters()) at a few particle counts and, every so 
+    often, has a separate ParticleCollisions build its BVH over a snapshot of the particles and 
+    detect collisions through the binary tree and then through the 4-wide one (see 
+    BvhWideNodeBuffer.comp), for each builder, and measure it (see 
+    ParticleCollisions::MeasureTreeQuality(...)).
+
+    The wide tree costs the collapse that is added to the build time, and it pays for itself 
+    if collision detection gets faster by more than that.  Both go to stdout and to the 
+    tab-delimited "WideBvhTraversal.txt" so that they can be dumped into an Excel 
+    spreadsheet, along with the number of nodes that collision detection goes through.  The 
+    SAH cost is the binary tree's either way, so it isn't there.  The potential collisions 
+    should be the same through either tree.  If they aren't, then the collapse broke 
+    something.
+
+    Note: The snapshot is put back before every measurement and after all of them so that the 
+    scene carries on as if nothing happened.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+void CompareWideBvhTraversal()
+{
+    std::vector<ShaderControllers::ParticleCollisions::BvhBuilder> builders = 
+    {
+        ShaderControllers::ParticleCollisions::BvhBuilder::KARRAS_RADIX_TREE,
+        ShaderControllers::ParticleCollisions::BvhBuilder::AGGLOMERATIVE,
+        ShaderControllers::ParticleCollisions::BvhBuilder::PLOC
+    };
+    std::vector<std::string> builderNames = { "Karras", "agglomerative", "PLOC" };
+    const unsigned int NUM_TIMED_TRAVERSALS = 10;
+
+    std::ofstream outFile("WideBvhTraversal.txt");
+    outFile << "particles\tframe\tactive particles";
+    for (size_t builderIndex = 0; builderIndex < builders.size(); builderIndex++)
+    {
+        const std::string &name = builderNames[builderIndex];
+        outFile << "\t" << name << " nodes visited\t" << name << " wide nodes visited\t" 
+            << name << " potential collisions\t" << name << " wide potential collisions\t" 
+            << name << " build (microseconds)\t" << name << " wide build (microseconds)\t" 
+            << name << " detect collisions (microseconds)\t" << name << " wide detect collisions (microseconds)\t" 
+            << name << " collapse cost (microseconds)\t" << name << " detection saved (microseconds)";
+    }
+    outFile << std::endl;
+
+    for (size_t countIndex = 0; countIndex < BENCHMARK_PARTICLE_COUNTS.size(); countIndex++)
+    {
+        unsigned int particleCount = BENCHMARK_PARTICLE_COUNTS[countIndex];
+
+        unsigned int particlesPerEmitterPerFrame = MakeBenchmarkScene(particleCount);
+
+        // the builder and the traversal can be switched at any time, so one will do
+        std::shared_ptr<ShaderControllers::ParticleCollisions> measurer = std::make_shared<ShaderControllers::ParticleCollisions>(particleBuffer, particlePropertiesBuffer, MortonCodeEncoding::MORTON_CODE_2D_16_BITS, MAX_PARTICLES_PER_BVH_LEAF);
+
+
+        unsigned int frameCount = 0;
+        for (size_t sampleIndex = 0; sampleIndex < BENCHMARK_FRAMES_TO_SAMPLE.size(); sampleIndex++)
+        {
+            RunBenchmarkFrames(BENCHMARK_FRAMES_TO_SAMPLE[sampleIndex] - frameCount, particlesPerEmitterPerFrame);
+            frameCount = BENCHMARK_FRAMES_TO_SAMPLE[sampleIndex];
+
+            std::vector<Particle> snapshot = SnapshotParticles();
+
+            std::cout << particleCount << " particles, frame " << frameCount << ":" << std::endl;
+            outFile << particleCount << "\t" << frameCount;
+            for (size_t builderIndex = 0; builderIndex < builders.size(); builderIndex++)
+            {
+                // [0] binary, [1] wide
+                ShaderControllers::ParticleCollisions::TreeQuality qualities[2];
+                measurer->SetBvhBuilder(builders[builderIndex]);
+                for (int wide = 0; wide < 2; wide++)
+                {
+                    RestoreParticles(snapshot);
+
+                    measurer->SetWideBvhTraversal(wide != 0);
+                    qualities[wide] = measurer->MeasureTreeQuality(NUM_TIMED_TRAVERSALS);
+                }
+                if (builderIndex == 0)
+                {
+                    outFile << "\t" << qualities[0]._numActiveParticles;
+                }
+
+                // Note: Signed, because either one could come out negative.
+                long long collapseCost = qualities[1]._durationBuildBvh - qualities[0]._durationBuildBvh;
+                long long detectionSaved = qualities[0]._durationDetectCollisions - qualities[1]._durationDetectCollisions;
+                double speedup = (qualities[1]._durationDetectCollisions == 0) ? 0.0 : 
+                    static_cast<double>(qualities[0]._durationDetectCollisions) / qualities[1]._durationDetectCollisions;
+
+                std::cout << "    " << builderNames[builderIndex] 
+                    << ": nodes visited " << qualities[0]._numNodesVisited << " -> " << qualities[1]._numNodesVisited 
+                    << ", potential collisions " << qualities[0]._numPotentialCollisions << " -> " << qualities[1]._numPotentialCollisions 
+                    << ", detect collisions " << qualities[0]._durationDetectCollisions << " -> " << qualities[1]._durationDetectCollisions 
+                    << " microseconds (" << speedup << "x), collapse cost " << collapseCost 
+                    << " microseconds, detection saved " << detectionSaved << " microseconds" << std::endl;
+                outFile << "\t" << qualities[0]._numNodesVisited << "\t" << qualities[1]._numNodesVisited << "\t" 
+                    << qualities[0]._numPotentialCollisions << "\t" << qualities[1]._numPotentialCollisions << "\t" 
+                    << qualities[0]._durationBuildBvh << "\t" << qualities[1]._durationBuildBvh << "\t" 
+                    << qualities[0]._durationDetectCollisions << "\t" << qualities[1]._durationDetectCollisions << "\t" 
+                    << collapseCost << "\t" << detectionSaved;
+            }
+            outFile << std::endl;
+
+            // put the scene back the way it was
+            RestoreParticles(snapshot);
+        }
+    }
+    outFile.close();
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Runs the demo scene (see GenerateParticleEmitters()) at a few particle counts and, every so 
+    often, has a separate ParticleCollisions build its BVH over a snapshot of the particles and 
+    detect collisions through the float nodes and then through the quantized ones (see 
+    BvhQuantizedNodeBuffer.comp), for each builder, and measure it (see 
+    ParticleCollisions::MeasureTreeQuality(...)).
+
+    The quantized nodes are half the size, so this is about memory traffic, and that only 
+    shows once the tree is a lot bigger than the caches.  That is why the counts start at a 
+    million.  The quantizing costs a dispatch that is added to the build time, and it pays 
+    for itself if collision detection gets faster by more than that.  Both go to stdout and to 
+    the tab-delimited "QuantizedBvhTraversal.txt" so that they can be dumped into an Excel 
+    spreadsheet.  The potential collisions should be the same either way.  The decoded boxes 
+    are a little bigger, so a few more leaves may be looked into, but there is nothing in them 
+    that overlaps.  If the potential collisions aren't the same, then an overlap was missed 
+    and the quantizing rounded something the wrong way.
+
+    Note: The snapshot is put back before every measurement and after all of them so that the 
+    scene carries on as if nothing happened.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+void CompareQuantizedBvhTraversal()
+{
+    std::vector<unsigned int> particleCounts = 
+    {
+        1000000,
+        2000000
+    };
+    std::vector<ShaderControllers::ParticleCollisions::BvhBuilder> builders = 
+    {
+        ShaderControllers::ParticleCollisions::BvhBuilder::KARRAS_RADIX_TREE,
+        ShaderControllers::ParticleCollisions::BvhBuilder::AGGLOMERATIVE,
+        ShaderControllers::ParticleCollisions::BvhBuilder::PLOC
+    };
+    std::vector<std::string> builderNames = { "Karras", "agglomerative", "PLOC" };
+    const unsigned int NUM_TIMED_TRAVERSALS = 10;
+
+    std::ofstream outFile("QuantizedBvhTraversal.txt");
+    outFile << "particles\tframe\tactive particles";
+    for (size_t builderIndex = 0; builderIndex < builders.size(); builderIndex++)
+    {
+        const std::string &name = builderNames[builderIndex];
+        outFile << "\t" << name << " potential collisions\t" << name << " quantized potential collisions\t" 
+            << name << " build (microseconds)\t" << name << " quantized build (microseconds)\t" 
+            << name << " detect collisions (microseconds)\t" << name << " quantized detect collisions (microseconds)\t" 
+            << name << " quantize cost (microseconds)\t" << name << " detection saved (microseconds)";
+    }
+    outFile << std::endl;
+
+    for (size_t countIndex = 0; countIndex < particleCounts.size(); countIndex++)
+    {
+        unsigned int particleCount = particleCounts[countIndex];
+
+        unsigned int particlesPerEmitterPerFrame = MakeBenchmarkScene(particleCount);
+
+        // the builder and the traversal can be switched at any time, so one will do
+        std::shared_ptr<ShaderControllers::ParticleCollisions> measurer = std::make_shared<ShaderControllers::ParticleCollisions>(particleBuffer, particlePropertiesBuffer, MortonCodeEncoding::MORTON_CODE_2D_16_BITS, MAX_PARTICLES_PER_BVH_LEAF);
+
+
+        unsigned int frameCount = 0;
+        for (size_t sampleIndex = 0; sampleIndex < BENCHMARK_FRAMES_TO_SAMPLE.size(); sampleIndex++)
+        {
+            RunBenchmarkFrames(BENCHMARK_FRAMES_TO_SAMPLE[sampleIndex] - frameCount, particlesPerEmitterPerFrame);
+            frameCount = BENCHMARK_FRAMES_TO_SAMPLE[sampleIndex];
+
+            std::vector<Particle> snapshot = SnapshotParticles();
+
+            std::cout << particleCount << " particles, frame " << frameCount << ":" << std::endl;
+            outFile << particleCount << "\t" << frameCount;
+            for (size_t builderIndex = 0; builderIndex < builders.size(); builderIndex++)
+            {
+                // [0] float, [1] quantized
+                ShaderControllers::ParticleCollisions::TreeQuality qualities[2];
+                measurer->SetBvhBuilder(builders[builderIndex]);
+                for (int quantized = 0; quantized < 2; quantized++)
+                {
+                    RestoreParticles(snapshot);
+
+                    measurer->SetQuantizedBvhTraversal(quantized != 0);
+                    qualities[quantized] = measurer->MeasureTreeQuality(NUM_TIMED_TRAVERSALS);
+                }
+                if (builderIndex == 0)
+                {
+                    outFile << "\t" << qualities[0]._numActiveParticles;
+                }
+
+                // Note: Signed, because either one could come out negative.
+                long long quantizeCost = qualities[1]._durationBuildBvh - qualities[0]._durationBuildBvh;
+                long long detectionSaved = qualities[0]._durationDetectCollisions - qualities[1]._durationDetectCollisions;
+                double speedup = (qualities[1]._durationDetectCollisions == 0) ? 0.0 : 
+                    static_cast<double>(qualities[0]._durationDetectCollisions) / qualities[1]._durationDetectCollisions;
+
+                std::cout << "    " << builderNames[builderIndex] 
+                    << ": potential collisions " << qualities[0]._numPotentialCollisions << " -> " << qualities[1]._numPotentialCollisions 
+                    << ", detect collisions " << qualities[0]._durationDetectCollisions << " -> " << qualities[1]._durationDetectCollisions 
+                    << " microseconds (" << speedup << "x), quantize cost " << quantizeCost 
+                    << " microseconds, detection saved " << detectionSaved << " microseconds" << std::endl;
+                outFile << "\t" << qualities[0]._numPotentialCollisions << "\t" << qualities[1]._numPotentialCollisions << "\t" 
+                    << qualities[0]._durationBuildBvh << "\t" << qualities[1]._durationBuildBvh << "\t" 
+                    << qualities[0]._durationDetectCollisions << "\t" << qualities[1]._durationDetectCollisions << "\t" 
+                    << quantizeCost << "\t" << detectionSaved;
+            }
+            outFile << std::endl;
+
+            // put the scene back the way it was
+            RestoreParticles(snapshot);
+        }
+    }
+    outFile.close();
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Runs the demo scene (see GenerateParticleEmitters()) at a million particles, has a separate 
+    ParticleCollisions sort them and build its Karras BVH on the GPU, and then builds the same 
+    tree on the CPU (see CpuBvhBuilders.h) with 1, 2, 4, ... threads, up to however many the 
+    hardware has.  The build time, the speedup over 1 thread, and the parallel efficiency 
+    (speedup / threads) go to stdout and to the tab-delimited "CpuBvhBuilderScaling.txt" so 
+    that they can be dumped into an Excel spreadsheet.
+
+    The GPU uses the dynamic scene bounds (see 
+    ParticleCollisions::SetDynamicMortonCodeBounds(...)).  The sorting data is made on the CPU 
+    from the bounds that it read back (see ParticleCollisions::ReadSceneBounds()) and the 
+    particles in the order that the GPU left them, and it is sorted with std::stable_sort(...), 
+    which is the order that the GPU's radix sort leaves them in.  The number of keys that 
+    aren't the same as the GPU's goes out too.  Only the build is timed.
+
+    Every thread count has to make the same tree, byte for byte, as the GPU (see 
+    ParticleCollisions::ReadBackBvh(...)).  The number of nodes in the tree that don't goes out 
+    too.  Both should always be 0.
+
+    Note: The snapshot is put back afterwards so that the scene carries on as if nothing 
+    happened.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+void ProfileCpuBvhBuilderScaling()
+{
+    const unsigned int PARTICLE_COUNT = 1024 * 1024;
+    const unsigned int FRAMES_TO_RUN = 250;
+    const unsigned int NUM_TIMED_BUILDS = 10;
+
+    unsigned int particlesPerEmitterPerFrame = MakeBenchmarkScene(PARTICLE_COUNT);
+    RunBenchmarkFrames(FRAMES_TO_RUN, particlesPerEmitterPerFrame);
+
+    std::vector<Particle> snapshot = SnapshotParticles();
+
+    // the GPU's tree, and the particles and the bounds that it was built from
+    std::shared_ptr<ShaderControllers::ParticleCollisions> gpuBuilder = std::make_shared<ShaderControllers::ParticleCollisions>(particleBuffer, particlePropertiesBuffer, MortonCodeEncoding::MORTON_CODE_2D_16_BITS, MAX_PARTICLES_PER_BVH_LEAF);
+    gpuBuilder->SetDynamicMortonCodeBounds(true);
+    gpuBuilder->MeasureTreeQuality(0);
+
+    std::vector<BvhNode> gpuNodes;
+    std::vector<BvhNodeBuildData> gpuBuildData;
+    gpuBuilder->ReadBackBvh(gpuNodes, gpuBuildData);
+    SceneBounds sceneBounds = gpuBuilder->ReadSceneBounds();
+
+    unsigned int numActiveParticles = 0;
+    std::vector<ParticleSortingData> gpuSortedData;
+    std::vector<ParticleSortingData64> unusedSortedData64;
+    std::vector<Particle> particles;
+    std::vector<ParticleProperties> particleProperties;
+    gpuBuilder->ReadBackCpuBvhBuildInput(numActiveParticles, gpuSortedData, unusedSortedData64, 
+        particles, particleProperties);
+
+    // only the active particles go in the tree, same as on the GPU
+    std::vector<ParticleSortingData> sortedData;
+    for (size_t particleIndex = 0; particleIndex < particles.size(); particleIndex++)
+    {
+        if (particles[particleIndex]._isActive == 0)
+        {
+            continue;
+        }
+
+        ParticleSortingData item;
+        item._sortingData = PositionToMortonCode2D(particles[particleIndex]._pos, 
+            sceneBounds._sceneMin, sceneBounds._sceneInverseRange);
+        item._preSortedParticleIndex = static_cast<int>(particleIndex);
+        sortedData.push_back(item);
+    }
+    std::stable_sort(sortedData.begin(), sortedData.end(), 
+        [](const ParticleSortingData &a, const ParticleSortingData &b) 
+    {
+        return a._sortingData < b._sortingData;
+    });
+
+    unsigned int numMismatchedKeys = 0;
+    if (sortedData.size() != gpuSortedData.size())
+    {
+        numMismatchedKeys = static_cast<unsigned int>(std::max(sortedData.size(), gpuSortedData.size()));
+    }
+    else
+    {
+        for (size_t dataIndex = 0; dataIndex < sortedData.size(); dataIndex++)
+        {
+            if ((sortedData[dataIndex]._sortingData != gpuSortedData[dataIndex]._sortingData) || 
+                (sortedData[dataIndex]._preSortedParticleIndex != gpuSortedData[dataIndex]._preSortedParticleIndex))
+            {
+                numMismatchedKeys++;
+            }
+        }
+    }
+    std::cout << PARTICLE_COUNT << " particles (" << numActiveParticles << " active): mismatched keys " 
+        << numMismatchedKeys << std::endl;
+
+    // the leaves [0, leaves in use) and the internal nodes [root, root + leaves in use - 1) (see 
+    // CpuBvhBuilders.h); the rest is left over on the GPU and at its defaults on the CPU
+    // Note: The build data's counters are part of it.  Every one should be back to 0.
+    unsigned int numLeafNodes = static_cast<unsigned int>(particles.size());
+    unsigned int numLeavesInUse = (numActiveParticles + MAX_PARTICLES_PER_BVH_LEAF - 1) / MAX_PARTICLES_PER_BVH_LEAF;
+    std::vector<size_t> nodesInTree;
+    for (size_t leafIndex = 0; leafIndex < numLeavesInUse; leafIndex++)
+    {
+        nodesInTree.push_back(leafIndex);
+    }
+    for (size_t internalCount = 0; internalCount + 1 < numLeavesInUse; internalCount++)
+    {
+        nodesInTree.push_back(numLeafNodes + internalCount);
+    }
+
+    std::vector<unsigned int> threadCounts;
+    unsigned int maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    for (unsigned int numThreads = 1; numThreads < maxThreads; numThreads *= 2)
+    {
+        threadCounts.push_back(numThreads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    std::ofstream outFile("CpuBvhBuilderScaling.txt");
+    outFile << "particles\tactive particles\tmismatched keys\tthreads\tbuild (microseconds)\tspeedup\tefficiency\tmismatched nodes" << std::endl;
+
+    long long singleThreadDuration = 0;
+    for (size_t countIndex = 0; countIndex < threadCounts.size(); countIndex++)
+    {
+        unsigned int numThreads = threadCounts[countIndex];
+        WorkStealingThreadPool threadPool(numThreads);
+        std::vector<BvhNode> nodes;
+        std::vector<BvhNodeBuildData> buildData;
+
+        // the first one warms up the caches and the allocations
+        BuildBvhKarrasCpu(sortedData, numActiveParticles, particles, particleProperties, 
+            MAX_PARTICLES_PER_BVH_LEAF, threadPool, nodes, buildData);
+
+        using namespace std::chrono;
+        steady_clock::time_point start = steady_clock::now();
+        for (unsigned int buildCount = 0; buildCount < NUM_TIMED_BUILDS; buildCount++)
+        {
+            BuildBvhKarrasCpu(sortedData, numActiveParticles, particles, particleProperties, 
+                MAX_PARTICLES_PER_BVH_LEAF, threadPool, nodes, buildData);
+        }
+        steady_clock::time_point end = steady_clock::now();
+        long long duration = duration_cast<microseconds>(end - start).count() / NUM_TIMED_BUILDS;
+
+        if (numThreads == 1)
+        {
+            singleThreadDuration = duration;
+        }
+
+        unsigned int numMismatchedNodes = 0;
+        for (size_t nodeIndex : nodesInTree)
+        {
+            if ((memcmp(&nodes[nodeIndex], &gpuNodes[nodeIndex], sizeof(BvhNode)) != 0) || 
+                (memcmp(&buildData[nodeIndex], &gpuBuildData[nodeIndex], sizeof(BvhNodeBuildData)) != 0))
+            {
+                numMismatchedNodes++;
+            }
+        }
+
+        float speedup = (duration == 0) ? 0.0f : static_cast<float>(singleThreadDuration) / duration;
+        float efficiency = speedup / numThreads;
+        std::cout << PARTICLE_COUNT << " particles (" << numActiveParticles << " active), " 
+            << numThreads << " threads: build " << duration << " microseconds, speedup " << speedup 
+            << ", efficiency " << efficiency << ", mismatched nodes " << numMismatchedNodes 
+            << " of " << nodesInTree.size() << std::endl;
+        outFile << PARTICLE_COUNT << "\t" << numActiveParticles << "\t" << numMismatchedKeys << "\t" 
+            << numThreads << "\t" << duration << "\t" << speedup << "\t" << efficiency << "\t" 
+            << numMismatchedNodes << std::endl;
+    }
+    outFile.close();
+
+    // put the scene back the way it was
+    RestoreParticles(snapshot);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Gives the sort benchmark something to sort.  Fills the first half of the key-value SSBO 
+    with random keys over the full range of the SSBO's key width (the same range as the 2D 
+    Morton Codes of that width) and values that are just the original indices, then tells the 
+    item count SSBO how many there are.
+
+    Every bit of a random key changes somewhere in the data set, so the radix sort planner 
+    can't skip anything (see PlanRadixSortPasses.comp).  That makes this the worst case for 
+    64-bit keys.
+
+    Note: The random number generator is seeded with the item count so that every algorithm 
+    sorts the same keys.
+Parameters: 
+    keyValueSsbo    Self-explanatory.
+    itemCountSsbo   Self-explanatory.
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+void UploadRandomKeyValuePairs(const ParticleSortingDataSsbo &keyValueSsbo, 
+    const ActiveParticlesSsbo &itemCountSsbo)
+{
+    unsigned int numItems = keyValueSsbo.NumItems();
+    std::mt19937 randomNumberGenerator(numItems);
+    std::uniform_int_distribution<unsigned int> keyDistribution(0, 0xFFFFFFFFu);
+
+    // Note: The two item types only differ in the key, so fill out whichever one it is.
+    std::vector<ParticleSortingData> keyValuePairs;
+    std::vector<ParticleSortingData64> keyValuePairs64;
+    const void *uploadData = nullptr;
+    if (keyValueSsbo.KeyWidth() == SortingKeyWidth::KEY_64_BIT)
+    {
+        keyValuePairs64.resize(numItems);
+        for (unsigned int itemIndex = 0; itemIndex < numItems; itemIndex++)
+        {
+            keyValuePairs64[itemIndex]._sortingData = keyDistribution(randomNumberGenerator);
+            keyValuePairs64[itemIndex]._sortingDataHigh = keyDistribution(randomNumberGenerator);
+            keyValuePairs64[itemIndex]._preSortedParticleIndex = static_cast<int>(itemIndex);
+        }
+        uploadData = keyValuePairs64.data();
+    }
+    else
+    {
+        keyValuePairs.resize(numItems);
+        for (unsigned int itemIndex = 0; itemIndex < numItems; itemIndex++)
+        {
+            keyValuePairs[itemIndex]._sortingData = keyDistribution(randomNumberGenerator);
+            keyValuePairs[itemIndex]._preSortedParticleIndex = static_cast<int>(itemIndex);
+        }
+        uploadData = keyValuePairs.data();
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, keyValueSsbo.BufferId());
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, numItems * keyValueSsbo.ItemSizeBytes(), uploadData);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    itemCountSsbo.SetNumActiveParticles(numItems);
+}
+
+/*------------------------------------------------------------------------------------------------
+Description:
+    Sorts increasingly large sets of key-value pairs with both radix sort algorithms, once with 
+    32-bit keys and once with 64-bit keys (see SortingKey64.comp), and writes the total sorting 
+    time for each to the tab-delimited "ParallelSortScaling.txt" so that they can be dumped into 
+    an Excel spreadsheet.  Counts that fit in the shared memory sort (see 
+    SharedMemorySortLayout.comp) are also sorted with that, and the small counts are there to 
+    show where it stops being faster than the multi-bit radix sort.  Also says what it is doing 
+    on stdout.  Each sort's breakdown still goes to "ParallelSortDurations.txt", but that only 
+    has the last one.
+
+    The sorts verify themselves against the CPU sort (see 
+    GpuKeyValueSorter::SortWithProfiling(...)), so any count that sorts incorrectly will say 
+    so.  1024 * 1024 + 1 is in there because that was where the old two-level prefix scan ran 
+    out of room.
+
+    This drives GpuKeyValueSorter directly with random keys (see 
+    UploadRandomKeyValuePairs(...)), so it measures the sort and nothing else.  The incremental 
+    sort is turned off because random keys are never nearly sorted.
+
+    Note: The sorter's scratch buffers are sized on construction and its shaders are assembled 
+    for one key width, so the sorter and its buffers are re-created for each count and width.
+Parameters: None
+Returns:    None
+Creator:    John Cox, 7/2017
+------------------------------------------------------------------------------------------------*/
+void ProfileSortScaling()
+{
+    std::vector<unsigned int> itemCounts = 
+    {
+        512,
+        1024,
+        2048,
+        4096,
+        5000,
+        SHARED_MEMORY_SORT_MAX_ITEMS,
+        16 * 1024,
+        64 * 1024,
+        256 * 1024,
+        1024 * 1024,
+        (1024 * 1024) + 1,
+        4 * 1024 * 1024,
+        16 * 1024 * 1024
+    };
+
+    using ShaderControllers::GpuKeyValueSorter;
+
+    std::vector<SortingKeyWidth> keyWidths = { SortingKeyWidth::KEY_32_BIT, SortingKeyWidth::KEY_64_BIT };
+    std::vector<std::string> keyWidthNames = { "32-bit", "64-bit" };
+
+    std::ofstream outFile("ParallelSortScaling.txt");
+    outFile << "items";
+    for (size_t widthIndex = 0; widthIndex < keyWidths.size(); widthIndex++)
+    {
+        const std::string &name = keyWidthNames[widthIndex];
+        outFile << "\t" << name << " 1-bit sort (microseconds)\t" << name << " multi-bit sort (microseconds)\t" << name << " shared memory sort (microseconds)";
+    }
+    outFile << std::endl;
+
+    for (size_t countIndex = 0; countIndex < itemCounts.size(); countIndex++)
+    {
+        unsigned int itemCount = itemCounts[countIndex];
+        std::cout << itemCount << " items:";
+        outFile << itemCount;
+
+        for (size_t widthIndex = 0; widthIndex < keyWidths.size(); widthIndex++)
+        {
+            ParticleSortingDataSsbo keyValueSsbo(itemCount, keyWidths[widthIndex]);
+            ActiveParticlesSsbo itemCountSsbo(1);
+            GpuKeyValueSorter sorter(itemCount, keyWidths[widthIndex]);
+            sorter.SetIncrementalSort(false);
+
+            UploadRandomKeyValuePairs(keyValueSsbo, itemCountSsbo);
+            sorter.SetAlgorithm(GpuKeyValueSorter::Algorithm::RADIX_SORT_1_BIT);
+            long long durationOneBitSort = sorter.SortWithProfiling(keyValueSsbo, itemCountSsbo);
+
+            UploadRandomKeyValuePairs(keyValueSsbo, itemCountSsbo);
+            sorter.SetAlgorithm(GpuKeyValueSorter::Algorithm::RADIX_SORT_MULTI_BIT);
+            long long durationMultiBitSort = sorter.SortWithProfiling(keyValueSsbo, itemCountSsbo);
+
+            std::cout << " " << keyWidthNames[widthIndex] << " keys: 1-bit sort " << durationOneBitSort 
+                << " microseconds, multi-bit sort " << durationMultiBitSort << " microseconds";
+            outFile << "\t" << durationOneBitSort << "\t" << durationMultiBitSort << "\t";
+
+            // leave the column blank for counts that don't fit
+            if (itemCount <= SHARED_MEMORY_SORT_MAX_ITEMS)
+            {
+                UploadRandomKeyValuePairs(keyValueSsbo, itemCountSsbo);
+                sorter.SetAlgorithm(GpuKeyValueSorter::Algorithm::SHARED_MEMORY_SORT);
+                long long durationSharedMemorySort = sorter.SortWithProfiling(keyValueSsbo, itemCountSsbo);
+                std::cout << ", shared memory sort " << durationSharedMemorySort << " microseconds";
+                outFile << durationSharedMemorySort;
+            }
+            std::cout << ";";
+        }
+        std::cout << std::endl;
+        outFile << std::endl;
+    }
+    outFile.close();
+}
+
 /*------------------------------------------------------------------------------------------------
 Description:
     Updates particle positions, generates the quad tree for the particles' new positions, and 
@@ -494,11 +1811,61 @@ int main(int argc, char *argv[])
 
     Init();
 
+    // enable this to run the sort scaling benchmark instead of the demo (see 
+    // ProfileSortScaling())
+//#define PROFILE_SORT_SCALING
+    // or this to compare the Morton Code encoders (see CompareMortonCodeCollisionRates())
+//#define COMPARE_MORTON_CODE_COLLISION_RATES
+    // or this to compare the trees that each sort key builds (see 
+    // CompareSortingKeyTreeQuality())
+//#define COMPARE_SORTING_KEY_TREE_QUALITY
+    // or this to compare rebuilding the BVH every frame with refitting it (see 
+    // CompareBvhRefit())
+//#define COMPARE_BVH_REFIT
+    // or this to compare different numbers of particles per BVH leaf (see 
+    // CompareBvhLeafSizes())
+//#define COMPARE_BVH_LEAF_SIZES
+    // or this to compare the BVH builders (see CompareBvhBuilders())
+//#define COMPARE_BVH_BUILDERS
+    // or this to measure what the BVH treelet restructuring costs and saves (see 
+    // CompareBvhTreeletRestructuring())
+//#define COMPARE_BVH_TREELET_RESTRUCTURING
+    // or this to measure what the 4-wide BVH traversal costs and saves (see 
+    // CompareWideBvhTraversal())
+//#define COMPARE_WIDE_BVH_TRAVERSAL
+    // or this to measure what the quantized BVH nodes cost and save (see 
+    // CompareQuantizedBvhTraversal())
+//#define COMPARE_QUANTIZED_BVH_TRAVERSAL
+    // or this to measure how the CPU BVH builder scales with threads (see 
+    // ProfileCpuBvhBuilderScaling())
+//#define PROFILE_CPU_BVH_BUILDER_SCALING
+#if defined(PROFILE_SORT_SCALING)
+    ProfileSortScaling();
+#elif defined(COMPARE_MORTON_CODE_COLLISION_RATES)
+    CompareMortonCodeCollisionRates();
+#elif defined(COMPARE_SORTING_KEY_TREE_QUALITY)
+    CompareSortingKeyTreeQuality();
+#elif defined(COMPARE_BVH_REFIT)
+    CompareBvhRefit();
+#elif defined(COMPARE_BVH_LEAF_SIZES)
+    CompareBvhLeafSizes();
+#elif defined(COMPARE_BVH_BUILDERS)
+    CompareBvhBuilders();
+#elif defined(COMPARE_BVH_TREELET_RESTRUCTURING)
+    CompareBvhTreeletRestructuring();
+#elif defined(COMPARE_WIDE_BVH_TRAVERSAL)
+    CompareWideBvhTraversal();
+#elif defined(COMPARE_QUANTIZED_BVH_TRAVERSAL)
+    CompareQuantizedBvhTraversal();
+#elif defined(PROFILE_CPU_BVH_BUILDER_SCALING)
+    ProfileCpuBvhBuilderScaling();
+#else
     glutIdleFunc(UpdateAllTheThings);
     glutDisplayFunc(Display);
     glutReshapeFunc(Reshape);
     glutKeyboardFunc(Keyboard);
     glutMainLoop();
+#endif
 
     CleanupAll();
 